@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flightrec/flight_recorder.h"
+
+/*
+ * Converts a binary dump of the tracker's flight recorder to CSV or JSON.
+ *
+ * usage: FlightRecorderDecoder <dump-file> [csv|json]
+ */
+
+const char* event_type_name(int type) {
+	switch (type) {
+	case FR_EVENT_FOUND:
+		return "found";
+	case FR_EVENT_NOT_FOUND:
+		return "not_found";
+	case FR_EVENT_COLOR_ADAPTED:
+		return "color_adapted";
+	case FR_EVENT_COLOR_RESET:
+		return "color_reset";
+	default:
+		return "unknown";
+	}
+}
+
+// names of the stage timings, in the order of PSMoveTracker_Stage
+const char* stage_names[FLIGHT_RECORDER_STAGES] = { "color_conversion", "range_filter", "contours", "moments", "radius", "roi_retries",
+		"color_adaption", "overlay", "reacquire" };
+
+void print_csv_header() {
+	int i;
+	printf("frame,time_ms,type,controller,roi_level,roi_x,roi_y,roi_w,roi_h,x,y,r,q1,q2,q3,color,duration_us");
+	for (i = 0; i < FLIGHT_RECORDER_STAGES; i++)
+		printf(",%s_us", stage_names[i]);
+	printf("\n");
+}
+
+void print_csv(FlightRecorderEvent* e) {
+	int i;
+	printf("%u,%u,%s,%d,%d,%d,%d,%d,%d,%.2f,%.2f,%.2f,%.3f,%g,%.2f,%02X%02X%02X,%u", e->frame, e->time_ms, event_type_name(e->type), e->controller,
+			e->roi_level, e->roi_x, e->roi_y, e->roi_w, e->roi_h, e->x, e->y, e->r, e->q1, e->q2, e->q3, e->color[2], e->color[1], e->color[0],
+			e->duration_us);
+	for (i = 0; i < FLIGHT_RECORDER_STAGES; i++)
+		printf(",%u", e->stage_us[i]);
+	printf("\n");
+}
+
+// the separator is printed before every event but the first, so that a truncated dump still ends in valid JSON
+void print_json(FlightRecorderEvent* e, int first) {
+	int i;
+	printf("%s  {\"frame\":%u, \"time_ms\":%u, \"type\":\"%s\", \"controller\":%d, \"roi_level\":%d, "
+			"\"roi\":[%d,%d,%d,%d], \"x\":%.2f, \"y\":%.2f, \"r\":%.2f, \"q1\":%.3f, \"q2\":%g, \"q3\":%.2f, "
+			"\"color\":\"%02X%02X%02X\", \"duration_us\":%u, \"stages_us\":{", first ? "" : ",\n", e->frame, e->time_ms, event_type_name(e->type), e->controller,
+			e->roi_level, e->roi_x, e->roi_y, e->roi_w, e->roi_h, e->x, e->y, e->r, e->q1, e->q2, e->q3, e->color[2], e->color[1], e->color[0],
+			e->duration_us);
+	for (i = 0; i < FLIGHT_RECORDER_STAGES; i++)
+		printf("%s\"%s\":%u", i ? ", " : "", stage_names[i], e->stage_us[i]);
+	printf("}}");
+}
+
+int main(int arg, char** args) {
+	FlightRecorderHeader header;
+	FlightRecorderEvent e;
+	int json = 0;
+	unsigned int i;
+
+	if (arg < 2) {
+		fprintf(stderr, "usage: %s <dump-file> [csv|json]\n", args[0]);
+		return 1;
+	}
+	if (arg > 2)
+		json = strcmp(args[2], "json") == 0;
+
+	FILE *pFile = fopen(args[1], "rb");
+	if (pFile == 0x0) {
+		fprintf(stderr, "Unable to open '%s'.\n", args[1]);
+		return 1;
+	}
+
+	if (fread(&header, sizeof(header), 1, pFile) != 1 || memcmp(header.magic, FLIGHT_RECORDER_MAGIC, 4) != 0) {
+		fprintf(stderr, "'%s' is not a flight recorder dump.\n", args[1]);
+		fclose(pFile);
+		return 1;
+	}
+	if (header.version != FLIGHT_RECORDER_VERSION || header.event_size != sizeof(FlightRecorderEvent)) {
+		fprintf(stderr, "Unsupported dump version %d (expected %d).\n", header.version, FLIGHT_RECORDER_VERSION);
+		fclose(pFile);
+		return 1;
+	}
+
+	if (json)
+		printf("{\"version\":%d, \"overwritten\":%u, \"events\":[\n", header.version, header.overwritten);
+	else
+		print_csv_header();
+
+	for (i = 0; i < header.count; i++) {
+		if (fread(&e, sizeof(e), 1, pFile) != 1) {
+			fprintf(stderr, "Dump is truncated after %u of %u events.\n", i, header.count);
+			break;
+		}
+		if (json)
+			print_json(&e, i == 0);
+		else
+			print_csv(&e);
+	}
+
+	if (json)
+		printf("\n]}\n");
+	fclose(pFile);
+	return 0;
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opencv2/highgui/highgui_c.h"
+
+#include "psmove.h"
+#include "psmove_tracker.h"
+#include "benchmark/recorded_session.h"
+#include "benchmark/synthetic_scene.h"
+
+#define SYNTHETIC_WIDTH 640 // size of the frames of a synthetic session
+#define SYNTHETIC_HEIGHT 480
+#define SYNTHETIC_SPHERES 2 // number of spheres in a synthetic session
+#define SYNTHETIC_NOISE 4 // pixel noise, motion blur and distractors of a synthetic session (see synthetic_scene.h)
+#define SYNTHETIC_BLUR 3
+#define SYNTHETIC_DISTRACTORS 4
+
+/*
+ * Records a session for TrackerRegression: all camera frames are stored together with
+ * the tracker's results as labels. The labels are only a draft, they have to be
+ * reviewed (and corrected) before the session can serve as a reference.
+ *
+ * With "--synthetic" the frames are rendered by a synthetic scene instead, and the
+ * labels are its ground truth. No camera or controller is needed, and the same seed
+ * always produces the same session, so that "make regression" can create it itself.
+ *
+ * usage: SessionRecorder <existing-directory> [frames]
+ *        SessionRecorder --synthetic <existing-directory> [frames] [seed]
+ */
+
+int record_synthetic(const char* dir, int frames, unsigned int seed) {
+	int i, f;
+	unsigned char r, g, b;
+	float x, y, radius;
+
+	RecordedSession* session = recorded_session_create(dir, SYNTHETIC_SPHERES);
+	if (session == 0x0) {
+		fprintf(stderr, "Unable to create a session in '%s'.\n", dir);
+		return 1;
+	}
+	SyntheticScene* scene = synthetic_scene_new(SYNTHETIC_WIDTH, SYNTHETIC_HEIGHT, SYNTHETIC_SPHERES, seed);
+	synthetic_scene_set_noise(scene, SYNTHETIC_NOISE);
+	synthetic_scene_set_motion_blur(scene, SYNTHETIC_BLUR);
+	synthetic_scene_set_distractors(scene, SYNTHETIC_DISTRACTORS);
+	for (i = 0; i < SYNTHETIC_SPHERES; i++) {
+		synthetic_scene_get_color(scene, i, &r, &g, &b);
+		recorded_session_set_color(session, i, r, g, b);
+	}
+
+	for (f = 0; f < frames; f++) {
+		if (recorded_session_add_frame(session, synthetic_scene_render(scene)) < 0) {
+			fprintf(stderr, "Unable to store frame %d.\n", f);
+			break;
+		}
+		// the spheres never leave the image, so every sphere is labelled in every frame
+		for (i = 0; i < SYNTHETIC_SPHERES; i++) {
+			synthetic_scene_get_truth(scene, i, &x, &y, &radius);
+			recorded_session_add_label(session, i, x, y, radius);
+		}
+	}
+
+	recorded_session_release(session);
+	synthetic_scene_release(scene);
+	printf("### Rendered %d frames into '%s' (seed %u).\n", f, dir, seed);
+	return f < frames;
+}
+
+int main(int arg, char** args) {
+	int i, f;
+	unsigned char r, g, b;
+	float x, y, radius;
+
+	if (arg > 2 && strcmp(args[1], "--synthetic") == 0)
+		return record_synthetic(args[2], arg > 3 ? atoi(args[3]) : 600, arg > 4 ? atoi(args[4]) : 1);
+	if (arg < 2) {
+		fprintf(stderr, "usage: %s <existing-directory> [frames]\n       %s --synthetic <existing-directory> [frames] [seed]\n", args[0], args[0]);
+		return 1;
+	}
+	int frames = arg > 2 ? atoi(args[2]) : 600;
+	int numCtrls = psmove_count_connected();
+	if (numCtrls <= 0 || numCtrls > PSMOVE_TRACKER_MAX_CONTROLLERS) {
+		fprintf(stderr, "Please connect 1 to %d controllers.\n", PSMOVE_TRACKER_MAX_CONTROLLERS);
+		return 1;
+	}
+	PSMove* controllers[numCtrls];
+
+	PSMoveTracker* tracker = psmove_tracker_new();
+	RecordedSession* session = recorded_session_create(args[1], numCtrls);
+	if (session == 0x0) {
+		fprintf(stderr, "Unable to create a session in '%s'.\n", args[1]);
+		return 1;
+	}
+
+	for (i = 0; i < numCtrls; i++) {
+		controllers[i] = psmove_connect_by_id(i);
+		while (psmove_tracker_enable(tracker, controllers[i]) != Tracker_CALIBRATED)
+			printf("### Unable to calibrate controller %d, retrying...\n", i);
+		psmove_tracker_get_camera_color(tracker, controllers[i], &r, &g, &b);
+		recorded_session_set_color(session, i, r, g, b);
+	}
+
+	printf("### Recording %d frames (ESC to stop).\n", frames);
+	for (f = 0; f < frames; f++) {
+		psmove_tracker_update_image(tracker);
+		IplImage* frame = psmove_tracker_get_image(tracker);
+		if (!frame) {
+			f--;
+			continue;
+		}
+		for (i = 0; i < numCtrls; i++) {
+			psmove_tracker_get_color(tracker, controllers[i], &r, &g, &b);
+			psmove_set_leds(controllers[i], r, g, b);
+			psmove_update_leds(controllers[i]);
+		}
+
+		// the labels belong to the last added frame
+		if (recorded_session_add_frame(session, frame) < 0) {
+			fprintf(stderr, "Unable to store frame %d.\n", f);
+			break;
+		}
+		psmove_tracker_update(tracker, 0x0);
+		for (i = 0; i < numCtrls; i++) {
+			if (psmove_tracker_get_status(tracker, controllers[i]) != Tracker_CALIBRATED_AND_FOUND)
+				continue;
+			psmove_tracker_get_position(tracker, controllers[i], &x, &y, &radius);
+			recorded_session_add_label(session, i, x, y, radius);
+		}
+
+		cvShowImage("live camera feed", frame);
+		if ((cvWaitKey(1) & 255) == 27)
+			break;
+	}
+
+	recorded_session_release(session);
+	for (i = 0; i < numCtrls; i++)
+		psmove_disconnect(controllers[i]);
+	psmove_tracker_free(tracker);
+	printf("### Done, please review '%s/%s'.\n", args[1], RECORDED_SESSION_LABELS);
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+
+#include "stream/tracker_stream.h"
+
+/*
+ * Receives the results streamed by the tracker (see psmove_tracker_set_stream) and prints
+ * them as CSV. Lost packets and frames dropped by the tracker are reported on stderr.
+ *
+ * usage: StreamReceiver <unix:path|udp:port>
+ */
+
+volatile int running = 1;
+
+void stop(int sig) {
+	(void) sig;
+	running = 0;
+}
+
+int main(int arg, char** args) {
+	TrackerStreamFrame frames[TRACKER_STREAM_MAX_BATCH];
+	TrackerStreamHeader header;
+	uint32_t next_sequence = 0;
+	uint32_t last_dropped = 0;
+	unsigned int packets = 0, received = 0, lost = 0;
+	int i, j;
+
+	if (arg < 2) {
+		fprintf(stderr, "usage: %s <unix:path|udp:port>\n", args[0]);
+		return 1;
+	}
+
+	TrackerStream* s = tracker_stream_listen(args[1]);
+	if (s == 0x0) {
+		fprintf(stderr, "Unable to listen on '%s'.\n", args[1]);
+		return 1;
+	}
+	signal(SIGINT, stop);
+
+	printf("frame,timestamp_ns,controller,tracked,x,y,r\n");
+	while (running) {
+		int n = tracker_stream_receive(s, &header, frames, TRACKER_STREAM_MAX_BATCH, 100);
+		if (n == 0)
+			continue;
+		if (n < 0) {
+			fprintf(stderr, "Invalid packet received.\n");
+			continue;
+		}
+
+		// the sequence numbers reveal packets lost on the way, the counter those the tracker could not send
+		if (packets > 0 && header.sequence != next_sequence) {
+			lost += header.sequence - next_sequence;
+			fprintf(stderr, "%u packet(s) lost before packet %u.\n", header.sequence - next_sequence, header.sequence);
+		}
+		if (header.dropped != last_dropped) {
+			fprintf(stderr, "The tracker dropped %u frame(s) before packet %u.\n", header.dropped - last_dropped, header.sequence);
+			last_dropped = header.dropped;
+		}
+		next_sequence = header.sequence + 1;
+		packets++;
+
+		for (i = 0; i < n; i++) {
+			for (j = 0; j < frames[i].controllers; j++) {
+				TrackerStreamController* c = &frames[i].controller[j];
+				printf("%u,%lld,%d,%d,%.2f,%.2f,%.2f\n", frames[i].frame, (long long) frames[i].timestamp, j, c->is_tracked, c->x, c->y, c->r);
+			}
+			received++;
+		}
+		fflush(stdout);
+	}
+
+	fprintf(stderr, "%u packets, %u frames received, %u packets lost, %u frames dropped by the tracker.\n", packets, received, lost, last_dropped);
+	tracker_stream_release(s);
+	return 0;
+}
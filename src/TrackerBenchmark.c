@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "psmove.h"
+#include "psmove_tracker.h"
+#include "timer/high_precision_timer.h"
+#include "benchmark/synthetic_scene.h"
+
+/*
+ * Measures the tracker on synthetic frames, no camera or controller is needed.
+ * The scene renders spheres in the colors of the tracker's palette, the tracker is
+ * told these colors (no calibration), and its results are compared against the
+ * known positions of the spheres.
+ *
+ * usage: TrackerBenchmark [frames] [spheres] [noise] [blur] [distractors] [seed] [width] [height]
+ */
+
+#define BENCHMARK_WIDTH 640 // default size of the frames (e.g. 320x240 measures the QVGA mode)
+#define BENCHMARK_HEIGHT 480
+#define BENCHMARK_WARMUP 30 // number of frames that are not measured (the tracker has not found the spheres yet)
+
+const char* stage_names[Tracker_STAGE_COUNT] = { "color_conversion", "range_filter", "contours", "moments", "radius", "roi_retries",
+		"color_adaption", "overlay", "reacquire" };
+
+int compare_int64(const void* a, const void* b) {
+	int64_t ia = *(const int64_t*) a;
+	int64_t ib = *(const int64_t*) b;
+	return (ia > ib) - (ia < ib);
+}
+
+double percentile(int64_t* sorted, int n, int p) {
+	return sorted[(n - 1) * p / 100] * 0.001;
+}
+
+int main(int arg, char** args) {
+	int i, f, s;
+	int frames = arg > 1 ? atoi(args[1]) : 1000;
+	int spheres = arg > 2 ? atoi(args[2]) : 1;
+	float noise = arg > 3 ? atof(args[3]) : 4;
+	int blur = arg > 4 ? atoi(args[4]) : 1;
+	int distractors = arg > 5 ? atoi(args[5]) : 0;
+	unsigned int seed = arg > 6 ? atoi(args[6]) : 1;
+	int width = arg > 7 ? atoi(args[7]) : BENCHMARK_WIDTH;
+	int height = arg > 8 ? atoi(args[8]) : BENCHMARK_HEIGHT;
+	unsigned char r, g, b;
+
+	if (frames <= 0 || spheres <= 0 || spheres > PSMOVE_TRACKER_MAX_CONTROLLERS || width <= 0 || height <= 0) {
+		fprintf(stderr, "usage: %s [frames] [spheres (1-%d)] [noise] [blur] [distractors] [seed] [width] [height]\n", args[0], PSMOVE_TRACKER_MAX_CONTROLLERS);
+		return 1;
+	}
+
+	SyntheticScene* scene = synthetic_scene_new(width, height, spheres, seed);
+	synthetic_scene_set_noise(scene, noise);
+	synthetic_scene_set_motion_blur(scene, blur);
+	synthetic_scene_set_distractors(scene, distractors);
+
+	PSMoveTracker* tracker = psmove_tracker_new_with_frame_source(synthetic_scene_frame_source, scene);
+	if (tracker == 0x0) {
+		fprintf(stderr, "Unable to set up the tracker.\n");
+		return 1;
+	}
+
+	// the tracker only uses the handles to tell the controllers apart, they are never dereferenced
+	PSMove* moves[spheres];
+	for (s = 0; s < spheres; s++) {
+		moves[s] = (PSMove*) (intptr_t) (s + 1);
+		synthetic_scene_get_color(scene, s, &r, &g, &b);
+		if (psmove_tracker_enable_with_known_color(tracker, moves[s], r, g, b) != Tracker_CALIBRATED) {
+			fprintf(stderr, "Unable to enable sphere %d.\n", s);
+			return 1;
+		}
+	}
+
+	int measured = frames - BENCHMARK_WARMUP > 0 ? frames - BENCHMARK_WARMUP : frames;
+	int64_t* latency = (int64_t*) calloc(measured, sizeof(int64_t));
+	int64_t total_ns = 0;
+	int n = 0;
+	int found = 0;
+	double pos_err = 0, pos_err_max = 0, rad_err = 0;
+
+	for (f = 0; f < frames; f++) {
+		psmove_tracker_update_image(tracker);
+		int64_t start = hp_timer_now_ns();
+		psmove_tracker_update(tracker, 0x0);
+		int64_t duration = hp_timer_now_ns() - start;
+
+		if (f < frames - measured)
+			continue;
+		latency[n++] = duration;
+		total_ns += duration;
+
+		for (s = 0; s < spheres; s++) {
+			float tx, ty, tr, x, y, radius;
+			if (psmove_tracker_get_status(tracker, moves[s]) != Tracker_CALIBRATED_AND_FOUND)
+				continue;
+			synthetic_scene_get_truth(scene, s, &tx, &ty, &tr);
+			psmove_tracker_get_position(tracker, moves[s], &x, &y, &radius);
+			double d = sqrt((x - tx) * (x - tx) + (y - ty) * (y - ty));
+			pos_err += d;
+			pos_err_max = d > pos_err_max ? d : pos_err_max;
+			rad_err += fabs(radius - tr);
+			found++;
+		}
+	}
+
+	qsort(latency, n, sizeof(int64_t), compare_int64);
+	printf("frames:       %d (%d measured, %d warm-up)\n", frames, n, frames - n);
+	printf("scene:        %d sphere(s), noise %.1f, blur %d, %d distractor(s), seed %u\n", spheres, noise, blur, distractors, seed);
+	printf("latency (us): p50 %.1f  p90 %.1f  p99 %.1f  max %.1f  mean %.1f\n", percentile(latency, n, 50), percentile(latency, n, 90),
+			percentile(latency, n, 99), latency[n - 1] * 0.001, total_ns * 0.001 / n);
+	printf("throughput:   %.1f frames/s (tracker only)\n", n * 1000000000.0 / total_ns);
+	printf("detection:    %.2f%%\n", 100.0 * found / (n * spheres));
+	if (found > 0)
+		printf("error (px):   position mean %.2f  max %.2f  radius mean %.2f\n", pos_err / found, pos_err_max, rad_err / found);
+
+	for (s = 0; s < spheres; s++) {
+		printf("stages of sphere %d (us):\n", s);
+		for (i = 0; i < Tracker_STAGE_COUNT; i++) {
+			float p50, p99, max;
+			if (psmove_tracker_get_stage_timing(tracker, moves[s], i, &p50, &p99, &max) > 0)
+				printf("  %-18s p50 %8.1f  p99 %8.1f  max %8.1f\n", stage_names[i], p50, p99, max);
+		}
+	}
+
+	free(latency);
+	psmove_tracker_free(tracker);
+	synthetic_scene_release(scene);
+	return 0;
+}
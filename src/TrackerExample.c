@@ -30,6 +30,7 @@ int main(int arg, char** args) {
 	printf("### Found %d controllers.\n", numCtrls);
 
 	IplImage* frame;
+	IplImage* overlay = 0x0;
 	unsigned char r, g, b;
 	int erg;
 
@@ -74,15 +75,26 @@ int main(int arg, char** args) {
 		}
 
 		psmove_tracker_update(tracker, 0x0);
-		cvShowImage("live camera feed", frame);
+
+		// the tracking results are drawn on a copy of the frame by the tracker's overlay thread
+		if (overlay == 0x0)
+			overlay = cvCreateImage(cvGetSize(frame), frame->depth, frame->nChannels);
+		if (psmove_tracker_get_overlay(tracker, overlay))
+			cvShowImage("live camera feed", overlay);
 		//If ESC key pressed
 		if (key == 27)
 			break;
 	}
+	unsigned int processed, dropped;
+	float delay_avg, delay_max;
+	if (psmove_tracker_get_capture_statistics(tracker, &processed, &dropped, &delay_avg, &delay_max))
+		printf("### Frames processed: %u, dropped: %u, queueing delay: %.1fms (max. %.1fms)\n", processed, dropped, delay_avg, delay_max);
 	for (i = 0; i < numCtrls; i++) {
 		psmove_disconnect(controllers[i]);
 	}
 	psmove_tracker_free(tracker);
+	if (overlay != 0x0)
+		cvReleaseImage(&overlay);
 	return 0;
 }
 
@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "psmove.h"
+#include "psmove_tracker.h"
+#include "timer/high_precision_timer.h"
+#include "benchmark/recorded_session.h"
+#include "iniparser/iniparser.h"
+#include "iniparser/dictionary.h"
+
+/*
+ * Replays a corpus of labelled sessions (see benchmark/recorded_session.h) through the
+ * tracker and writes a scorecard of its accuracy and cost. If a baseline scorecard is
+ * given, every metric is compared against it and the tool fails if one got worse by
+ * more than its tolerance. This is meant to be run before and after changing the
+ * tracker's constants or its hot path.
+ *
+ * usage: TrackerRegression <corpus-file> [scorecard-file] [baseline-file]
+ *
+ * The corpus file lists one session directory per line, lines starting with '#' are ignored.
+ * A corpus without sessions is an error, so that an empty corpus never passes as "no regressions".
+ */
+
+typedef struct {
+	int frames; // number of tracked frames
+	int labelled; // number of (frame, sphere) pairs in which the sphere is visible
+	int unlabelled; // number of (frame, sphere) pairs in which the sphere is not visible
+	int detected; // visible spheres that have been found
+	int false_positives; // spheres that have been found, but are not visible
+	double pos_err_sum; // sum of the position errors of all detected spheres
+	double rad_err_sum; // sum of the radius errors of all detected spheres
+	float* pos_err; // position error of every detected sphere
+	int roi_fallbacks; // number of ROI enlargements
+	int full_searches; // number of searches on the whole image
+	int reacquire_handoffs; // number of spheres not found in their ROI and left to the reacquisition
+	int reacquire_searches; // number of (frame, sphere) pairs searched by the reacquisition
+	int64_t* cost; // duration of psmove_tracker_update for every frame (in ns)
+	int64_t cost_sum;
+} Scorecard;
+
+typedef struct {
+	const char* name;
+	int higher_is_better;
+	double tolerance; // allowed change in the wrong direction
+	int relative; // 1 if the tolerance is relative to the baseline value
+} Metric;
+
+// timings depend on the machine and its load, so they are allowed to vary much more than the accuracy
+const Metric metrics[] = { { "detection_rate", 1, 0.005, 0 }, { "false_positive_rate", 0, 0.005, 0 }, { "position_error_mean", 0, 0.1, 0 }, {
+		"position_error_p95", 0, 0.25, 0 }, { "radius_error_mean", 0, 0.1, 0 }, { "roi_fallback_rate", 0, 0.01, 0 }, { "full_search_rate", 0,
+		0.01, 0 }, { "reacquire_handoff_rate", 0, 0.01, 0 }, { "reacquire_search_rate", 0, 0.01, 0 }, { "cost_p50_us", 0, 0.1, 1 }, { "cost_p99_us", 0, 0.2, 1 }, { "cost_mean_us", 0, 0.1, 1 } };
+#define METRICS (int) (sizeof(metrics) / sizeof(metrics[0]))
+
+int compare_float(const void* a, const void* b) {
+	float fa = *(const float*) a;
+	float fb = *(const float*) b;
+	return (fa > fb) - (fa < fb);
+}
+
+int compare_int64(const void* a, const void* b) {
+	int64_t ia = *(const int64_t*) a;
+	int64_t ib = *(const int64_t*) b;
+	return (ia > ib) - (ia < ib);
+}
+
+double rate(int count, int total) {
+	return total > 0 ? (double) count / total : 0;
+}
+
+// calculates all metrics of a scorecard, in the order of "metrics"
+void scorecard_values(Scorecard* sc, double* v) {
+	int n = sc->frames;
+	qsort(sc->pos_err, sc->detected, sizeof(float), compare_float);
+	qsort(sc->cost, n, sizeof(int64_t), compare_int64);
+	v[0] = rate(sc->detected, sc->labelled);
+	v[1] = rate(sc->false_positives, sc->unlabelled);
+	v[2] = sc->detected > 0 ? sc->pos_err_sum / sc->detected : 0;
+	v[3] = sc->detected > 0 ? sc->pos_err[(sc->detected - 1) * 95 / 100] : 0;
+	v[4] = sc->detected > 0 ? sc->rad_err_sum / sc->detected : 0;
+	v[5] = rate(sc->roi_fallbacks, n);
+	v[6] = rate(sc->full_searches, n);
+	v[7] = rate(sc->reacquire_handoffs, n);
+	v[8] = rate(sc->reacquire_searches, n);
+	v[9] = n > 0 ? sc->cost[(n - 1) * 50 / 100] * 0.001 : 0;
+	v[10] = n > 0 ? sc->cost[(n - 1) * 99 / 100] * 0.001 : 0;
+	v[11] = n > 0 ? sc->cost_sum * 0.001 / n : 0;
+}
+
+void scorecard_merge(Scorecard* total, Scorecard* sc) {
+	total->pos_err = (float*) realloc(total->pos_err, (total->detected + sc->detected) * sizeof(float));
+	memcpy(total->pos_err + total->detected, sc->pos_err, sc->detected * sizeof(float));
+	total->cost = (int64_t*) realloc(total->cost, (total->frames + sc->frames) * sizeof(int64_t));
+	memcpy(total->cost + total->frames, sc->cost, sc->frames * sizeof(int64_t));
+	total->frames += sc->frames;
+	total->labelled += sc->labelled;
+	total->unlabelled += sc->unlabelled;
+	total->detected += sc->detected;
+	total->false_positives += sc->false_positives;
+	total->pos_err_sum += sc->pos_err_sum;
+	total->rad_err_sum += sc->rad_err_sum;
+	total->roi_fallbacks += sc->roi_fallbacks;
+	total->full_searches += sc->full_searches;
+	total->reacquire_handoffs += sc->reacquire_handoffs;
+	total->reacquire_searches += sc->reacquire_searches;
+	total->cost_sum += sc->cost_sum;
+}
+
+int replay_session(const char* dir, Scorecard* sc) {
+	int c;
+	unsigned char r, g, b;
+	RecordedSession* session = recorded_session_open(dir);
+	if (session == 0x0) {
+		fprintf(stderr, "Unable to open session '%s'.\n", dir);
+		return 0;
+	}
+	int frames = recorded_session_get_frames(session);
+	int controllers = recorded_session_get_controllers(session);
+	memset(sc, 0, sizeof(Scorecard));
+	sc->pos_err = (float*) calloc(frames * controllers, sizeof(float));
+	sc->cost = (int64_t*) calloc(frames, sizeof(int64_t));
+
+	// the first frame is used by the tracker to set itself up
+	PSMoveTracker* tracker = psmove_tracker_new_with_frame_source(recorded_session_frame_source, session);
+	if (tracker == 0x0) {
+		fprintf(stderr, "Unable to replay session '%s'.\n", dir);
+		free(sc->pos_err);
+		free(sc->cost);
+		recorded_session_release(session);
+		return 0;
+	}
+
+	// the tracker only uses the handles to tell the controllers apart, they are never dereferenced
+	PSMove* moves[RECORDED_SESSION_MAX_CONTROLLERS];
+	for (c = 0; c < controllers; c++) {
+		moves[c] = (PSMove*) (intptr_t) (c + 1);
+		recorded_session_get_color(session, c, &r, &g, &b);
+		psmove_tracker_enable_with_known_color(tracker, moves[c], r, g, b);
+	}
+
+	while (1) {
+		psmove_tracker_update_image(tracker);
+		if (psmove_tracker_get_image(tracker) == 0x0)
+			break;
+
+		int64_t start = hp_timer_now_ns();
+		psmove_tracker_update(tracker, 0x0);
+		int64_t duration = hp_timer_now_ns() - start;
+		sc->cost[sc->frames++] = duration;
+		sc->cost_sum += duration;
+
+		for (c = 0; c < controllers; c++) {
+			float lx, ly, lr, x, y, radius;
+			int visible = recorded_session_get_label(session, c, &lx, &ly, &lr);
+			int found = psmove_tracker_get_status(tracker, moves[c]) == Tracker_CALIBRATED_AND_FOUND;
+			if (!visible) {
+				sc->unlabelled++;
+				sc->false_positives += found;
+				continue;
+			}
+			sc->labelled++;
+			if (!found)
+				continue;
+			psmove_tracker_get_position(tracker, moves[c], &x, &y, &radius);
+			float d = sqrtf((x - lx) * (x - lx) + (y - ly) * (y - ly));
+			sc->pos_err[sc->detected++] = d;
+			sc->pos_err_sum += d;
+			sc->rad_err_sum += fabs(radius - lr);
+		}
+	}
+
+	for (c = 0; c < controllers; c++) {
+		int fallbacks = 0, full_searches = 0;
+		psmove_tracker_get_roi_statistics(tracker, moves[c], &fallbacks, &full_searches);
+		sc->roi_fallbacks += fallbacks;
+		sc->full_searches += full_searches;
+		int handoffs = 0, searches = 0;
+		psmove_tracker_get_reacquisition_statistics(tracker, moves[c], &handoffs, &searches);
+		sc->reacquire_handoffs += handoffs;
+		sc->reacquire_searches += searches;
+	}
+
+	psmove_tracker_free(tracker);
+	recorded_session_release(session);
+	return 1;
+}
+
+void write_section(FILE* out, const char* name, double* v) {
+	int i;
+	fprintf(out, "[%s]\n", name);
+	for (i = 0; i < METRICS; i++)
+		fprintf(out, "%-20s = %.4f\n", metrics[i].name, v[i]);
+	fprintf(out, "\n");
+}
+
+// compares a section against the baseline, returns the number of regressions
+int compare_section(dictionary* baseline, const char* name, double* v) {
+	int i;
+	int regressions = 0;
+	char key[1024];
+	for (i = 0; i < METRICS; i++) {
+		const Metric* m = &metrics[i];
+		snprintf(key, sizeof(key), "%s:%s", name, m->name);
+		if (!iniparser_find_entry(baseline, key))
+			continue;
+		double base = iniparser_getdouble(baseline, key, 0);
+		double worse = m->higher_is_better ? base - v[i] : v[i] - base;
+		double allowed = m->relative ? m->tolerance * fabs(base) : m->tolerance;
+		int regressed = worse > allowed;
+		printf("  %-20s %12.4f %12.4f %+12.4f %s\n", m->name, base, v[i], v[i] - base, regressed ? "REGRESSION" : "");
+		regressions += regressed;
+	}
+	return regressions;
+}
+
+int main(int arg, char** args) {
+	char line[1024];
+	double v[METRICS];
+	int regressions = 0;
+	int sessions = 0;
+	Scorecard total;
+	Scorecard sc;
+
+	if (arg < 2) {
+		fprintf(stderr, "usage: %s <corpus-file> [scorecard-file] [baseline-file]\n", args[0]);
+		return 1;
+	}
+	FILE* corpus = fopen(args[1], "r");
+	if (corpus == 0x0) {
+		fprintf(stderr, "Unable to open '%s'.\n", args[1]);
+		return 1;
+	}
+	FILE* out = arg > 2 ? fopen(args[2], "w") : stdout;
+	if (out == 0x0) {
+		fprintf(stderr, "Unable to write '%s'.\n", args[2]);
+		return 1;
+	}
+	dictionary* baseline = 0x0;
+	if (arg > 3) {
+		baseline = iniparser_load(args[3]);
+		if (baseline == 0x0) {
+			fprintf(stderr, "Unable to load baseline '%s'.\n", args[3]);
+			return 1;
+		}
+	}
+
+	memset(&total, 0, sizeof(Scorecard));
+	while (fgets(line, sizeof(line), corpus) != 0x0) {
+		line[strcspn(line, "\r\n")] = 0;
+		if (line[0] == 0 || line[0] == '#')
+			continue;
+		if (!replay_session(line, &sc)) {
+			regressions++;
+			continue;
+		}
+		scorecard_merge(&total, &sc);
+		scorecard_values(&sc, v);
+		write_section(out, line, v);
+		if (baseline != 0x0) {
+			printf("%s:\n  %-20s %12s %12s %12s\n", line, "metric", "baseline", "current", "change");
+			regressions += compare_section(baseline, line, v);
+		}
+		free(sc.pos_err);
+		free(sc.cost);
+		sessions++;
+	}
+	fclose(corpus);
+
+	scorecard_values(&total, v);
+	write_section(out, "total", v);
+	if (baseline != 0x0) {
+		printf("total:\n  %-20s %12s %12s %12s\n", "metric", "baseline", "current", "change");
+		regressions += compare_section(baseline, "total", v);
+		iniparser_freedict(baseline);
+	}
+	if (out != stdout)
+		fclose(out);
+	free(total.pos_err);
+	free(total.cost);
+
+	printf("%d session(s), %d regression(s)\n", sessions, regressions);
+	if (sessions == 0) {
+		fprintf(stderr, "The corpus '%s' lists no session that could be replayed.\n", args[1]);
+		return 1;
+	}
+	return regressions > 0;
+}
@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opencv2/core/core_c.h"
+#include "opencv2/imgproc/imgproc_c.h"
+
+#include "tracker/bit_mask.h"
+#include "tracker/color_conversion.h"
+#include "tracker/decimated_mask.h"
+#include "tracker/stripe_search.h"
+#include "thread/tracker_pool.h"
+
+/*
+ * Checks building blocks of the tracker against straightforward reference implementations
+ * on random or synthetic data. No camera or controller is needed, the tool fails if a
+ * single check fails.
+ *
+ * usage: TrackerSelfTest [seed]
+ */
+
+#define SELFTEST_WIDTH 640 // size of the frames the checks run on
+#define SELFTEST_HEIGHT 480
+#define SELFTEST_SPHERES 12 // number of spheres drawn into a synthetic frame
+#define SELFTEST_STRIPES 9 // the stripe search is checked with 1 .. SELFTEST_STRIPES stripes
+#define SELFTEST_ROIS 16 // number of random ROIs the decimated filter is checked on (per decimation)
+
+// the color filter of the synthetic frames (HSV)
+#define SELFTEST_MIN cvScalar(100, 120, 120, 0)
+#define SELFTEST_MAX cvScalar(130, 255, 255, 0)
+
+int failures = 0;
+
+// counts a failed check, the first ten failures are reported
+#define SELFTEST_CHECK(cond, ...) \
+	if (!(cond)) { \
+		if (failures++ < 10) { \
+			printf("  FAILED: "); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	}
+
+void selftest_random_fill(IplImage* img, CvRNG* rng) {
+	cvRandArr(rng, img, CV_RAND_UNI, cvScalarAll(0), cvScalarAll(256));
+}
+
+int selftest_in_range(const unsigned char* bgr) {
+	unsigned char hsv[3];
+	CvScalar min = SELFTEST_MIN, max = SELFTEST_MAX;
+	int c;
+	color_bgr2hsv(bgr, hsv);
+	for (c = 0; c < 3; c++) {
+		if (hsv[c] < min.val[c] || hsv[c] > max.val[c])
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Draws a synthetic frame: noise that does not pass the color filter, with spheres of noise
+ * that passes it. The spheres are discs on a grid, so that they never touch each other.
+ */
+void selftest_draw_spheres(IplImage* frame, CvRNG* rng) {
+	CvScalar min = SELFTEST_MIN, max = SELFTEST_MAX;
+	int cell = frame->height / 3;
+	int i, x, y, c;
+
+	for (y = 0; y < frame->height; y++) {
+		for (x = 0; x < frame->width; x++) {
+			unsigned char* p = &CV_IMAGE_ELEM(frame, unsigned char, y, 3 * x);
+			do {
+				for (c = 0; c < 3; c++)
+					p[c] = cvRandInt(rng) & 0xFF;
+			} while (selftest_in_range(p));
+		}
+	}
+
+	for (i = 0; i < SELFTEST_SPHERES; i++) {
+		// the discs keep a gap of at least a quarter of their cell to their neighbors and the border
+		int cx = (i % (frame->width / cell)) * cell + cell / 2;
+		int cy = (i / (frame->width / cell)) % 3 * cell + cell / 2;
+		int r = cell / 8 + cvRandInt(rng) % (cell / 8);
+		for (y = cy - r; y <= cy + r; y++) {
+			for (x = cx - r; x <= cx + r; x++) {
+				if ((x - cx) * (x - cx) + (y - cy) * (y - cy) > r * r)
+					continue;
+				unsigned char* p = &CV_IMAGE_ELEM(frame, unsigned char, y, 3 * x);
+				unsigned char hsv[3];
+				do {
+					for (c = 0; c < 3; c++)
+						hsv[c] = min.val[c] + cvRandInt(rng) % (int) (max.val[c] - min.val[c] + 1);
+					color_hsv2bgr(hsv, p);
+				} while (!selftest_in_range(p));
+			}
+		}
+	}
+}
+
+/*
+ * color_gbrg2bgr_quads_row: every quad of a random mosaic is compared with the pixel read
+ * from the mosaic element by element (rows "G B" and "R G", greens averaged and rounded up).
+ */
+void test_gbrg_quads(CvRNG* rng) {
+	int x, y;
+	IplImage* mosaic = cvCreateImage(cvSize(SELFTEST_WIDTH, SELFTEST_HEIGHT), IPL_DEPTH_8U, 1);
+	IplImage* quads = cvCreateImage(cvSize(SELFTEST_WIDTH / 2, SELFTEST_HEIGHT / 2), IPL_DEPTH_8U, 3);
+	int before = failures;
+	printf("color_gbrg2bgr_quads_row\n");
+
+	selftest_random_fill(mosaic, rng);
+	for (y = 0; y < quads->height; y++) {
+		const unsigned char* even = (const unsigned char*) mosaic->imageData + 2 * y * mosaic->widthStep;
+		color_gbrg2bgr_quads_row(even, even + mosaic->widthStep, (unsigned char*) quads->imageData + y * quads->widthStep, quads->width);
+	}
+
+	for (y = 0; y < quads->height; y++) {
+		for (x = 0; x < quads->width; x++) {
+			int g0 = CV_IMAGE_ELEM(mosaic, unsigned char, 2 * y, 2 * x);
+			int b = CV_IMAGE_ELEM(mosaic, unsigned char, 2 * y, 2 * x + 1);
+			int r = CV_IMAGE_ELEM(mosaic, unsigned char, 2 * y + 1, 2 * x);
+			int g1 = CV_IMAGE_ELEM(mosaic, unsigned char, 2 * y + 1, 2 * x + 1);
+			int g = (int) (g0 * 0.5 + g1 * 0.5 + 0.5);
+			const unsigned char* p = &CV_IMAGE_ELEM(quads, unsigned char, y, 3 * x);
+			SELFTEST_CHECK(p[0] == b && p[1] == g && p[2] == r, "quad (%d, %d): %d %d %d instead of %d %d %d", x, y, p[0], p[1], p[2], b, g, r);
+		}
+	}
+
+	// a mosaic with equal greens in every quad is packed back into the image it has been made of
+	IplImage* image = cvCreateImage(cvGetSize(quads), IPL_DEPTH_8U, 3);
+	selftest_random_fill(image, rng);
+	for (y = 0; y < image->height; y++) {
+		for (x = 0; x < image->width; x++) {
+			const unsigned char* p = &CV_IMAGE_ELEM(image, unsigned char, y, 3 * x);
+			CV_IMAGE_ELEM(mosaic, unsigned char, 2 * y, 2 * x) = p[1];
+			CV_IMAGE_ELEM(mosaic, unsigned char, 2 * y, 2 * x + 1) = p[0];
+			CV_IMAGE_ELEM(mosaic, unsigned char, 2 * y + 1, 2 * x) = p[2];
+			CV_IMAGE_ELEM(mosaic, unsigned char, 2 * y + 1, 2 * x + 1) = p[1];
+		}
+	}
+	for (y = 0; y < quads->height; y++) {
+		const unsigned char* even = (const unsigned char*) mosaic->imageData + 2 * y * mosaic->widthStep;
+		color_gbrg2bgr_quads_row(even, even + mosaic->widthStep, (unsigned char*) quads->imageData + y * quads->widthStep, quads->width);
+	}
+	cvAbsDiff(quads, image, quads);
+	CvScalar sum = cvSum(quads);
+	SELFTEST_CHECK(sum.val[0] + sum.val[1] + sum.val[2] == 0, "the packed mosaic differs from its image");
+
+	printf("  %s\n", failures == before ? "OK" : "FAILED");
+	cvReleaseImage(&image);
+	cvReleaseImage(&quads);
+	cvReleaseImage(&mosaic);
+}
+
+/*
+ * stripe_search_run: the mask filtered in parallel stripes is compared with the mask of the
+ * search on the whole frame (cvCvtColor and bit_mask_in_range, as psmove_tracker_filter_roi
+ * does for ROI level 0), for every number of stripes and pools of 1, 2 and 4 threads. Every
+ * pixel of the mask is set beforehand, so that a row that no stripe covers shows up.
+ */
+void test_stripe_search(CvRNG* rng) {
+	CvSize size = cvSize(SELFTEST_WIDTH, SELFTEST_HEIGHT);
+	IplImage* frame = cvCreateImage(size, IPL_DEPTH_8U, 3);
+	IplImage* hsv = cvCreateImage(size, IPL_DEPTH_8U, 3);
+	BitMask reference, mask;
+	int threads, stripes, y;
+	int before = failures;
+	printf("stripe_search_run\n");
+
+	bit_mask_init(&reference, size, malloc(bit_mask_size_of(size)));
+	bit_mask_init(&mask, size, malloc(bit_mask_size_of(size)));
+	selftest_draw_spheres(frame, rng);
+	cvCvtColor(frame, hsv, CV_BGR2HSV);
+	bit_mask_in_range(&reference, cvRect(0, 0, size.width, size.height), hsv, SELFTEST_MIN, SELFTEST_MAX);
+	SELFTEST_CHECK(bit_mask_count(&reference) > 0, "no pixel of the synthetic frame passes the color filter");
+
+	for (threads = 1; threads <= 4; threads *= 2) {
+		TrackerPool* pool = tracker_pool_new(threads);
+		for (stripes = 1; stripes <= SELFTEST_STRIPES; stripes++) {
+			StripeSearch* s = stripe_search_new(pool, size, stripes);
+			for (y = 0; y < size.height; y++)
+				bit_mask_set_run(bit_mask_row(&mask, y), 0, size.width);
+			cvSetZero(hsv);
+			stripe_search_run(s, frame, hsv, &mask, SELFTEST_MIN, SELFTEST_MAX);
+			SELFTEST_CHECK(memcmp(mask.bits, reference.bits, bit_mask_size_of(size)) == 0, "%d stripe(s) on %d thread(s): the mask differs", stripes, threads);
+			stripe_search_release(s);
+		}
+		tracker_pool_release(pool);
+	}
+
+	printf("  %s\n", failures == before ? "OK" : "FAILED");
+	free(mask.bits);
+	free(reference.bits);
+	cvReleaseImage(&hsv);
+	cvReleaseImage(&frame);
+}
+
+/*
+ * decimated_mask_cells and decimated_mask_refine: on random ROIs of a synthetic frame, the mask
+ * is compared with the classification of every pixel (color_in_range), at decimations 2 and 4.
+ * The spheres are convex and much bigger than a cell, so there are neither holes nor blobs that
+ * miss every cell center: away from the cells on the border of the ROI, both must be equal.
+ */
+void test_decimated_mask(CvRNG* rng) {
+	CvSize size = cvSize(SELFTEST_WIDTH, SELFTEST_HEIGHT);
+	CvSize cells = cvSize((size.width + 1) / 2, (size.height + 1) / 2);
+	IplImage* frame = cvCreateImage(size, IPL_DEPTH_8U, 3);
+	BitMask dec, inner, outer, tmp, mask;
+	int lo[3], hi[3];
+	int d, i, x, y;
+	int before = failures;
+	printf("decimated_mask_refine\n");
+
+	bit_mask_init(&dec, cells, malloc(bit_mask_size_of(cells)));
+	bit_mask_init(&inner, cells, malloc(bit_mask_size_of(cells)));
+	bit_mask_init(&outer, cells, malloc(bit_mask_size_of(cells)));
+	bit_mask_init(&tmp, cells, malloc(bit_mask_size_of(cells)));
+	bit_mask_init(&mask, size, malloc(bit_mask_size_of(size)));
+	selftest_draw_spheres(frame, rng);
+	color_range_bounds(SELFTEST_MIN, SELFTEST_MAX, lo, hi);
+
+	for (d = 2; d <= 4; d *= 2) {
+		for (i = 0; i < SELFTEST_ROIS; i++) {
+			// ROIs of any size and position, most of them do not end on a whole cell
+			int w = 8 * d + cvRandInt(rng) % (size.width / 2);
+			int h = 8 * d + cvRandInt(rng) % (size.height / 2);
+			CvRect roi = cvRect(cvRandInt(rng) % (size.width - w + 1), cvRandInt(rng) % (size.height - h + 1), w, h);
+			int set = 0, differ = 0;
+
+			bit_mask_init(&mask, cvSize(w, h), mask.bits);
+			decimated_mask_cells(frame, roi, d, lo, hi, &dec);
+			decimated_mask_refine(frame, roi, d, lo, hi, &dec, &inner, &outer, &tmp, &mask);
+
+			// the cells on the border of the ROI are left out
+			for (y = d; y < (dec.height - 1) * d; y++) {
+				const uint64_t* row = bit_mask_row(&mask, y);
+				for (x = d; x < (dec.width - 1) * d; x++) {
+					int expected = color_in_range(&CV_IMAGE_ELEM(frame, unsigned char, roi.y + y, 3 * (roi.x + x)), lo, hi);
+					int actual = (row[x / 64] >> (x % 64)) & 1;
+					set += expected;
+					differ += actual != expected;
+				}
+			}
+			SELFTEST_CHECK(differ == 0, "d = %d, ROI (%d, %d, %d, %d): %d of %d pixels differ", d, roi.x, roi.y, roi.width, roi.height, differ, set);
+		}
+	}
+
+	printf("  %s\n", failures == before ? "OK" : "FAILED");
+	free(mask.bits);
+	free(tmp.bits);
+	free(outer.bits);
+	free(inner.bits);
+	free(dec.bits);
+	cvReleaseImage(&frame);
+}
+
+int main(int arg, char** args) {
+	CvRNG rng = cvRNG(arg > 1 ? atoi(args[1]) : 1);
+
+	test_gbrg_quads(&rng);
+	test_stripe_search(&rng);
+	test_decimated_mask(&rng);
+
+	printf("%d failure(s)\n", failures);
+	return failures > 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opencv2/core/core_c.h"
+#include "opencv2/highgui/highgui_c.h"
+
+#include "recorded_session.h"
+#include "../iniparser/iniparser.h"
+#include "../iniparser/dictionary.h"
+
+typedef struct {
+	float x, y, r;
+	int visible;
+} RecordedLabel;
+
+struct _RecordedSession {
+	char* dir; // directory of the session
+	int writing; // 1 if the session is being recorded
+	int frames; // number of frames
+	int controllers; // number of spheres
+	CvScalar color[RECORDED_SESSION_MAX_CONTROLLERS]; // colors of the spheres as seen by the camera (BGR)
+	int current; // index of the last loaded/added frame
+	IplImage* frame; // the last loaded frame (replaying only)
+	RecordedLabel* labels; // frames * controllers labels (replaying only)
+	FILE* label_file; // labels are written as they are added (recording only)
+};
+
+void recorded_session_path(RecordedSession* s, char* path, int size, const char* file) {
+	snprintf(path, size, "%s/%s", s->dir, file);
+}
+
+RecordedSession* recorded_session_alloc(const char* dir) {
+	RecordedSession* s = (RecordedSession*) calloc(1, sizeof(RecordedSession));
+	s->dir = strdup(dir);
+	s->current = -1;
+	s->frame = 0x0;
+	s->labels = 0x0;
+	s->label_file = 0x0;
+	return s;
+}
+
+RecordedSession* recorded_session_open(const char* dir) {
+	int i;
+	char path[1024];
+	char key[64];
+	RecordedSession* s = recorded_session_alloc(dir);
+
+	recorded_session_path(s, path, sizeof(path), RECORDED_SESSION_INFO);
+	dictionary* ini = iniparser_load(path);
+	if (ini == 0x0) {
+		recorded_session_release(s);
+		return 0x0;
+	}
+	s->frames = iniparser_getint(ini, "session:frames", 0);
+	s->controllers = iniparser_getint(ini, "session:controllers", 0);
+	for (i = 0; i < s->controllers && i < RECORDED_SESSION_MAX_CONTROLLERS; i++) {
+		int value = 0;
+		sprintf(key, "session:color%d", i);
+		sscanf(iniparser_getstring(ini, key, "0"), "%X", &value);
+		s->color[i] = cvScalar(value & 0xFF, value >> 8 & 0xFF, value >> 16 & 0xFF, 0);
+	}
+	iniparser_freedict(ini);
+
+	if (s->frames <= 0 || s->controllers <= 0 || s->controllers > RECORDED_SESSION_MAX_CONTROLLERS) {
+		recorded_session_release(s);
+		return 0x0;
+	}
+
+	// frames without a label for a sphere are frames in which that sphere is not visible
+	s->labels = (RecordedLabel*) calloc(s->frames * s->controllers, sizeof(RecordedLabel));
+	recorded_session_path(s, path, sizeof(path), RECORDED_SESSION_LABELS);
+	FILE* f = fopen(path, "r");
+	if (f == 0x0) {
+		recorded_session_release(s);
+		return 0x0;
+	}
+	char line[256];
+	while (fgets(line, sizeof(line), f) != 0x0) {
+		int frame, controller;
+		float x, y, r;
+		// the header and comments are skipped, because they do not start with numbers
+		if (sscanf(line, "%d,%d,%f,%f,%f", &frame, &controller, &x, &y, &r) != 5)
+			continue;
+		if (frame < 0 || frame >= s->frames || controller < 0 || controller >= s->controllers)
+			continue;
+		RecordedLabel* l = &s->labels[frame * s->controllers + controller];
+		l->x = x;
+		l->y = y;
+		l->r = r;
+		l->visible = 1;
+	}
+	fclose(f);
+	return s;
+}
+
+int recorded_session_get_frames(RecordedSession* s) {
+	return s->frames;
+}
+
+int recorded_session_get_controllers(RecordedSession* s) {
+	return s->controllers;
+}
+
+void recorded_session_get_color(RecordedSession* s, int controller, unsigned char* r, unsigned char* g, unsigned char* b) {
+	*r = (unsigned char) s->color[controller].val[2];
+	*g = (unsigned char) s->color[controller].val[1];
+	*b = (unsigned char) s->color[controller].val[0];
+}
+
+IplImage* recorded_session_next_frame(RecordedSession* s) {
+	char file[32];
+	char path[1024];
+	if (s->frame != 0x0)
+		cvReleaseImage(&s->frame);
+	if (s->current + 1 >= s->frames)
+		return 0x0;
+
+	s->current++;
+	sprintf(file, RECORDED_SESSION_FRAME, s->current);
+	recorded_session_path(s, path, sizeof(path), file);
+	s->frame = cvLoadImage(path, CV_LOAD_IMAGE_COLOR);
+	return s->frame;
+}
+
+int recorded_session_get_frame_index(RecordedSession* s) {
+	return s->current;
+}
+
+int recorded_session_get_label(RecordedSession* s, int controller, float* x, float* y, float* r) {
+	if (s->labels == 0x0 || s->current < 0 || controller < 0 || controller >= s->controllers)
+		return 0;
+	RecordedLabel* l = &s->labels[s->current * s->controllers + controller];
+	if (x != 0x0)
+		*x = l->x;
+	if (y != 0x0)
+		*y = l->y;
+	if (r != 0x0)
+		*r = l->r;
+	return l->visible;
+}
+
+IplImage* recorded_session_frame_source(void* session) {
+	return recorded_session_next_frame((RecordedSession*) session);
+}
+
+RecordedSession* recorded_session_create(const char* dir, int controllers) {
+	char path[1024];
+	if (controllers <= 0 || controllers > RECORDED_SESSION_MAX_CONTROLLERS)
+		return 0x0;
+
+	RecordedSession* s = recorded_session_alloc(dir);
+	s->writing = 1;
+	s->controllers = controllers;
+	recorded_session_path(s, path, sizeof(path), RECORDED_SESSION_LABELS);
+	s->label_file = fopen(path, "w");
+	if (s->label_file == 0x0) {
+		s->writing = 0;
+		recorded_session_release(s);
+		return 0x0;
+	}
+	fprintf(s->label_file, "frame,controller,x,y,radius\n");
+	return s;
+}
+
+void recorded_session_set_color(RecordedSession* s, int controller, unsigned char r, unsigned char g, unsigned char b) {
+	s->color[controller] = cvScalar(b, g, r, 0);
+}
+
+int recorded_session_add_frame(RecordedSession* s, IplImage* frame) {
+	char file[32];
+	char path[1024];
+	sprintf(file, RECORDED_SESSION_FRAME, s->frames);
+	recorded_session_path(s, path, sizeof(path), file);
+	if (!cvSaveImage(path, frame, 0))
+		return -1;
+	s->current = s->frames++;
+	return s->current;
+}
+
+void recorded_session_add_label(RecordedSession* s, int controller, float x, float y, float r) {
+	if (s->current < 0)
+		return;
+	fprintf(s->label_file, "%d,%d,%.2f,%.2f,%.2f\n", s->current, controller, x, y, r);
+}
+
+void recorded_session_release(RecordedSession* s) {
+	int i;
+	char path[1024];
+	char key[64];
+	char value[16];
+	if (s == 0x0)
+		return;
+
+	if (s->writing) {
+		fclose(s->label_file);
+		dictionary* ini = dictionary_new(0);
+		iniparser_set(ini, "session", 0);
+		iniparser_set_int(ini, "session:frames", s->frames);
+		iniparser_set_int(ini, "session:controllers", s->controllers);
+		for (i = 0; i < s->controllers; i++) {
+			sprintf(key, "session:color%d", i);
+			sprintf(value, "%02X%02X%02X", (int) s->color[i].val[2], (int) s->color[i].val[1], (int) s->color[i].val[0]);
+			iniparser_set(ini, key, value);
+		}
+		recorded_session_path(s, path, sizeof(path), RECORDED_SESSION_INFO);
+		iniparser_save_ini(ini, path);
+		dictionary_del(ini);
+	}
+
+	if (s->frame != 0x0)
+		cvReleaseImage(&s->frame);
+	free(s->labels);
+	free(s->dir);
+	free(s);
+}
@@ -0,0 +1,74 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef RECORDED_SESSION_H_
+#define RECORDED_SESSION_H_
+
+#include "opencv2/core/core_c.h"
+
+#define RECORDED_SESSION_INFO "session.ini" // meta data of a session (number of frames, colors of the spheres)
+#define RECORDED_SESSION_LABELS "labels.csv" // position of every visible sphere: frame,controller,x,y,radius
+#define RECORDED_SESSION_FRAME "frame_%05d.png" // file name of a frame (lossless)
+#define RECORDED_SESSION_MAX_CONTROLLERS 8 // maximum number of controllers in a session
+
+/* Opaque data type for a recorded session */
+struct _RecordedSession;
+typedef struct _RecordedSession RecordedSession;
+
+/*
+ * A recorded session is a directory with the camera frames of a tracking session and
+ * labels that tell where each sphere is in every frame. The labels of a new recording
+ * are the tracker's own results; they have to be reviewed (and corrected) by hand
+ * before the session can be used as a reference.
+ */
+
+/* replaying */
+RecordedSession* recorded_session_open(const char* dir); // loads meta data and labels, NULL on error
+int recorded_session_get_frames(RecordedSession* s); // number of frames
+int recorded_session_get_controllers(RecordedSession* s); // number of spheres
+// color of a sphere as seen by the camera (see psmove_tracker_enable_with_known_color)
+void recorded_session_get_color(RecordedSession* s, int controller, unsigned char* r, unsigned char* g, unsigned char* b);
+// loads the next frame, NULL after the last one. the image is owned by the session
+IplImage* recorded_session_next_frame(RecordedSession* s);
+int recorded_session_get_frame_index(RecordedSession* s); // index of the last loaded frame (-1 before the first)
+// label of a sphere in the last loaded frame, returns 0 if the sphere is not visible
+int recorded_session_get_label(RecordedSession* s, int controller, float* x, float* y, float* r);
+// loads the next frame, can be passed to psmove_tracker_new_with_frame_source()
+IplImage* recorded_session_frame_source(void* session);
+
+/* recording */
+RecordedSession* recorded_session_create(const char* dir, int controllers); // the directory must exist, NULL on error
+void recorded_session_set_color(RecordedSession* s, int controller, unsigned char r, unsigned char g, unsigned char b);
+int recorded_session_add_frame(RecordedSession* s, IplImage* frame); // stores a frame, returns its index or -1 on error
+// labels a sphere in the last added frame
+void recorded_session_add_label(RecordedSession* s, int controller, float x, float y, float r);
+
+// writes the meta data (recording only) and frees all resources
+void recorded_session_release(RecordedSession* s);
+
+#endif /* RECORDED_SESSION_H_ */
@@ -0,0 +1,243 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "opencv2/core/core_c.h"
+
+#include "synthetic_scene.h"
+
+#define SCENE_BACKGROUND 18 // grey value of the (dark) background
+#define SCENE_MIN_RADIUS 6 // smallest radius of a sphere (in pixel)
+#define SCENE_MAX_RADIUS 48 // biggest radius of a sphere (in pixel)
+#define SCENE_MARGIN 4 // minimum distance of a sphere to the image border (in pixel)
+
+typedef struct {
+	float cx, cy; // center of the path
+	float ax, ay; // amplitude of the path
+	float wx, wy; // angular speed of the path (per frame)
+	float px, py; // phase of the path
+	float r0, ra, wr, pr; // mean, amplitude, angular speed and phase of the radius
+	CvScalar color; // BGR color of the sphere
+	float x, y, r; // ground truth of the last rendered frame
+} SyntheticSphere;
+
+typedef struct {
+	CvPoint center;
+	int radius;
+	CvScalar color;
+} SyntheticDistractor;
+
+struct _SyntheticScene {
+	int width;
+	int height;
+	int spheres; // number of spheres
+	SyntheticSphere sphere[SYNTHETIC_SCENE_MAX_SPHERES];
+	int distractors; // number of distractors
+	SyntheticDistractor distractor[SYNTHETIC_SCENE_MAX_DISTRACTORS];
+	float noise; // standard deviation of the pixel noise
+	int blur; // number of sub-frames per frame
+	float speed; // scales the angular speed of the spheres
+	int frame_no; // number of rendered frames
+	CvRNG rng; // the scene's own random number generator
+	IplImage* frame; // the rendered frame
+	IplImage* layer; // one sub-frame
+	IplImage* acc; // sum of all sub-frames and the noise (32F)
+	IplImage* tmp; // scratch image (32F)
+};
+
+// the colors of the tracker's palette (BGR), in the order they are assigned
+static const CvScalar scene_palette[] = { { { 0xff, 0x00, 0xff, 0 } }, // magenta
+		{ { 0xff, 0xff, 0x00, 0 } }, // cyan
+		{ { 0x00, 0xff, 0xff, 0 } } // yellow
+};
+
+// colors of the distractors (BGR), chosen to be outside of the tracker's color filter, but not by much
+static const CvScalar scene_distractor_colors[] = { { { 0xff, 0xff, 0xff, 0 } }, // white (lamp)
+		{ { 0x00, 0x8c, 0xff, 0 } }, // orange
+		{ { 0x00, 0xc8, 0x00, 0 } }, // green
+		{ { 0xff, 0x00, 0x00, 0 } }, // blue
+		{ { 0xb4, 0x6e, 0xb4, 0 } } // pale magenta
+};
+
+float synthetic_scene_random(SyntheticScene* s, float min, float max) {
+	return min + (max - min) * (float) cvRandReal(&s->rng);
+}
+
+void synthetic_scene_place_distractors(SyntheticScene* s) {
+	int i;
+	int colors = sizeof(scene_distractor_colors) / sizeof(scene_distractor_colors[0]);
+	for (i = 0; i < SYNTHETIC_SCENE_MAX_DISTRACTORS; i++) {
+		SyntheticDistractor* d = &s->distractor[i];
+		d->radius = (int) synthetic_scene_random(s, 3, 20);
+		d->center = cvPoint((int) synthetic_scene_random(s, 0, s->width), (int) synthetic_scene_random(s, 0, s->height));
+		d->color = scene_distractor_colors[i % colors];
+	}
+}
+
+SyntheticScene* synthetic_scene_new(int width, int height, int spheres, unsigned int seed) {
+	int i;
+	SyntheticScene* s = (SyntheticScene*) calloc(1, sizeof(SyntheticScene));
+	int palette = sizeof(scene_palette) / sizeof(scene_palette[0]);
+	if (spheres > SYNTHETIC_SCENE_MAX_SPHERES)
+		spheres = SYNTHETIC_SCENE_MAX_SPHERES;
+
+	s->width = width;
+	s->height = height;
+	s->spheres = spheres;
+	s->distractors = 0;
+	s->noise = 0;
+	s->blur = 1;
+	s->speed = 1;
+	s->frame_no = 0;
+	s->rng = cvRNG(seed);
+
+	for (i = 0; i < spheres; i++) {
+		SyntheticSphere* sp = &s->sphere[i];
+		// the radius varies between the sphere being close to and far away from the camera
+		sp->r0 = synthetic_scene_random(s, SCENE_MIN_RADIUS + 8, SCENE_MAX_RADIUS - 16);
+		sp->ra = synthetic_scene_random(s, 0, sp->r0 - SCENE_MIN_RADIUS);
+		sp->wr = synthetic_scene_random(s, 0.005, 0.02);
+		sp->pr = synthetic_scene_random(s, 0, 2 * CV_PI);
+
+		// the path must keep the biggest possible sphere inside of the image
+		float rmax = sp->r0 + sp->ra + SCENE_MARGIN;
+		sp->cx = width / 2.0f;
+		sp->cy = height / 2.0f;
+		sp->ax = synthetic_scene_random(s, 0.3, 1.0) * (width / 2.0f - rmax);
+		sp->ay = synthetic_scene_random(s, 0.3, 1.0) * (height / 2.0f - rmax);
+		sp->wx = synthetic_scene_random(s, 0.01, 0.04);
+		sp->wy = synthetic_scene_random(s, 0.01, 0.04);
+		sp->px = synthetic_scene_random(s, 0, 2 * CV_PI);
+		sp->py = synthetic_scene_random(s, 0, 2 * CV_PI);
+		sp->color = scene_palette[i % palette];
+	}
+	synthetic_scene_place_distractors(s);
+
+	s->frame = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 3);
+	s->layer = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 3);
+	s->acc = cvCreateImage(cvSize(width, height), IPL_DEPTH_32F, 3);
+	s->tmp = cvCreateImage(cvSize(width, height), IPL_DEPTH_32F, 3);
+	return s;
+}
+
+void synthetic_scene_release(SyntheticScene* s) {
+	if (s == 0x0)
+		return;
+	cvReleaseImage(&s->frame);
+	cvReleaseImage(&s->layer);
+	cvReleaseImage(&s->acc);
+	cvReleaseImage(&s->tmp);
+	free(s);
+}
+
+void synthetic_scene_set_noise(SyntheticScene* s, float sigma) {
+	s->noise = sigma;
+}
+
+void synthetic_scene_set_motion_blur(SyntheticScene* s, int steps) {
+	s->blur = steps < 1 ? 1 : steps;
+}
+
+void synthetic_scene_set_distractors(SyntheticScene* s, int count) {
+	if (count > SYNTHETIC_SCENE_MAX_DISTRACTORS)
+		count = SYNTHETIC_SCENE_MAX_DISTRACTORS;
+	s->distractors = count < 0 ? 0 : count;
+}
+
+void synthetic_scene_set_speed(SyntheticScene* s, float speed) {
+	s->speed = speed;
+}
+
+void synthetic_scene_get_color(SyntheticScene* s, int sphere, unsigned char* r, unsigned char* g, unsigned char* b) {
+	CvScalar c = s->sphere[sphere].color;
+	*r = (unsigned char) c.val[2];
+	*g = (unsigned char) c.val[1];
+	*b = (unsigned char) c.val[0];
+}
+
+void synthetic_scene_get_truth(SyntheticScene* s, int sphere, float* x, float* y, float* r) {
+	SyntheticSphere* sp = &s->sphere[sphere];
+	if (x != 0x0)
+		*x = sp->x;
+	if (y != 0x0)
+		*y = sp->y;
+	if (r != 0x0)
+		*r = sp->r;
+}
+
+IplImage* synthetic_scene_render(SyntheticScene* s) {
+	int i, k;
+	float t;
+
+	for (i = 0; i < s->spheres; i++)
+		s->sphere[i].x = s->sphere[i].y = s->sphere[i].r = 0;
+
+	// the exposure spans the whole frame; each sub-frame contributes the same share
+	cvZero(s->acc);
+	for (k = 0; k < s->blur; k++) {
+		t = (s->frame_no + (k + 1) / (float) s->blur) * s->speed;
+		cvSet(s->layer, cvScalarAll(SCENE_BACKGROUND), 0x0);
+
+		for (i = 0; i < s->distractors; i++) {
+			SyntheticDistractor* d = &s->distractor[i];
+			cvCircle(s->layer, d->center, d->radius, d->color, CV_FILLED, CV_AA, 0);
+		}
+
+		for (i = 0; i < s->spheres; i++) {
+			SyntheticSphere* sp = &s->sphere[i];
+			float x = sp->cx + sp->ax * sinf(sp->wx * t + sp->px);
+			float y = sp->cy + sp->ay * sinf(sp->wy * t + sp->py);
+			float r = sp->r0 + sp->ra * sinf(sp->wr * t + sp->pr);
+			// draw with 4 bits of sub-pixel precision, so that the ground truth is not rounded to full pixels
+			cvCircle(s->layer, cvPoint((int) (x * 16 + 0.5f), (int) (y * 16 + 0.5f)), (int) (r * 16 + 0.5f), sp->color, CV_FILLED, CV_AA, 4);
+			// a blurred sphere is seen at its average position
+			sp->x += x / s->blur;
+			sp->y += y / s->blur;
+			sp->r += r / s->blur;
+		}
+
+		cvConvertScale(s->layer, s->tmp, 1.0 / s->blur, 0);
+		cvAdd(s->acc, s->tmp, s->acc, 0x0);
+	}
+
+	if (s->noise > 0) {
+		cvRandArr(&s->rng, s->tmp, CV_RAND_NORMAL, cvScalarAll(0), cvScalarAll(s->noise));
+		cvAdd(s->acc, s->tmp, s->acc, 0x0);
+	}
+
+	// converting to 8 bit saturates the values
+	cvConvertScale(s->acc, s->frame, 1, 0);
+	s->frame_no++;
+	return s->frame;
+}
+
+IplImage* synthetic_scene_frame_source(void* scene) {
+	return synthetic_scene_render((SyntheticScene*) scene);
+}
@@ -0,0 +1,73 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef SYNTHETIC_SCENE_H_
+#define SYNTHETIC_SCENE_H_
+
+#include "opencv2/core/core_c.h"
+
+#define SYNTHETIC_SCENE_MAX_SPHERES 8 // maximum number of spheres in a scene
+#define SYNTHETIC_SCENE_MAX_DISTRACTORS 32 // maximum number of distractor blobs in a scene
+
+/* Opaque data type for the synthetic scene */
+struct _SyntheticScene;
+typedef struct _SyntheticScene SyntheticScene;
+
+/*
+ * Renders frames that look like a camera image of glowing spheres, so that the
+ * tracker can be measured without a camera or a controller. Every sphere moves on
+ * its own smooth path with a varying radius, and its exact position is known
+ * (ground truth). All random values are derived from the seed, so that the same
+ * seed always produces the same sequence of frames.
+ */
+SyntheticScene* synthetic_scene_new(int width, int height, int spheres, unsigned int seed); // constructor
+void synthetic_scene_release(SyntheticScene* s); // destructor
+
+// standard deviation of the gaussian noise added to each pixel (0 = no noise)
+void synthetic_scene_set_noise(SyntheticScene* s, float sigma);
+// number of sub-frames averaged per frame to simulate motion blur (1 = no blur)
+void synthetic_scene_set_motion_blur(SyntheticScene* s, int steps);
+// number of blobs in colors the tracker should ignore (lamps, reflections, ...)
+void synthetic_scene_set_distractors(SyntheticScene* s, int count);
+// scales the speed of the spheres (1 = default, about half the image per second at 60 FPS)
+void synthetic_scene_set_speed(SyntheticScene* s, float speed);
+
+// the color of a sphere (as rendered), spheres use the tracker's palette in order
+void synthetic_scene_get_color(SyntheticScene* s, int sphere, unsigned char* r, unsigned char* g, unsigned char* b);
+
+// renders the next frame. the image is owned by the scene and is overwritten by the next call
+IplImage* synthetic_scene_render(SyntheticScene* s);
+
+// the position and radius of a sphere in the last rendered frame. with motion blur this is
+// the mean over all sub-frames of the exposure, which is where the blurred sphere is seen
+void synthetic_scene_get_truth(SyntheticScene* s, int sphere, float* x, float* y, float* r);
+
+// renders the next frame, can be passed to psmove_tracker_new_with_frame_source()
+IplImage* synthetic_scene_frame_source(void* scene);
+
+#endif /* SYNTHETIC_SCENE_H_ */
@@ -2,6 +2,7 @@
 
 #include "../iniparser/dictionary.h"
 #include "../iniparser/iniparser.h"
+#include "../tracker/color_conversion.h"
 
 #include "opencv2/core/core_c.h"
 #include "opencv2/highgui/highgui_c.h"
@@ -23,6 +24,10 @@
 
 struct _CameraControl {
 	int cameraID;
+	int width, height; // the size of the frames delivered by the camera
+	int fps; // the requested frame rate
+	int raw_bayer; // the camera delivers its raw Bayer mosaic, whose quads are packed into frameQuads
+	IplImage* frameQuads;
 	IplImage* frame;
 	IplImage* frame3chUndistort;
 #if defined(WIN32) && defined(USE_CL_DRIVER)
@@ -45,10 +50,25 @@ struct _CameraControl {
 	int contrast; // value range [0-0xFFFF]
 	int brightness; // value range [0-0xFFFF]
 
+	CvMat* intrinsic; // the camera matrix read by camera_control_read_calibration (or NULL)
+	CvMat* distortion; // the distortion coefficients read by camera_control_read_calibration (or NULL)
+	int undistort_frames; // remap every frame to remove the lens distortion
 	IplImage* mapx;
 	IplImage* mapy;
 };
 
+void cc_init_undistort_maps(CameraControl* cc);
+void cc_release_undistort_maps(CameraControl* cc);
+void cc_open_capture(CameraControl* cc);
+void cc_scale_calibration(CameraControl* cc, CvMat* intrinsic);
+void cc_pack_bayer_quads(IplImage* mosaic, IplImage* dst);
+
+/*
+ * Switches the capture back to color frames (converted to BGR by the driver), if the driver
+ * does not deliver the raw mosaic that has been asked for.
+ */
+void cc_disable_raw_bayer(CameraControl* cc);
+
 #ifdef WIN32
 void cc_backup_sytem_settings_win(CameraControl* cc, const char* file);
 void cc_restore_sytem_settings_win(CameraControl* cc, const char* file);
@@ -62,9 +82,18 @@ void cc_set_parameters_linux(CameraControl* cc, int autoE, int autoG, int autoWB
 #endif
 
 CameraControl* camera_control_new(int cameraID) {
+	return camera_control_new_with_mode(cameraID, CAMERA_CONTROL_DEFAULT_WIDTH, CAMERA_CONTROL_DEFAULT_HEIGHT, CAMERA_CONTROL_DEFAULT_FPS, 0);
+}
+
+CameraControl* camera_control_new_with_mode(int cameraID, int width, int height, int fps, int raw_bayer) {
 
 	CameraControl* cc = (CameraControl*) calloc(1, sizeof(CameraControl));
 	cc->cameraID = cameraID;
+	cc->width = width;
+	cc->height = height;
+	cc->fps = fps;
+	cc->raw_bayer = raw_bayer;
+	cc->undistort_frames = 1;
 
 #if defined(WIN32) && defined(USE_CL_DRIVER)
 	int cams = CLEyeGetCameraCount();
@@ -74,54 +103,169 @@ CameraControl* camera_control_new(int cameraID) {
 	}
 	assert(cams);
 	GUID cguid = CLEyeGetCameraUUID(cameraID);
-	cc->camera = CLEyeCreateCamera(cguid, CLEYE_COLOR_PROCESSED, CLEYE_VGA, 60);
-	int w = 0;
-	int h = 0;
-	CLEyeCameraGetFrameDimensions(cc->camera, &w, &h);
+	CLEyeCameraResolution resolution = width <= 320 && height <= 240 ? CLEYE_QVGA : CLEYE_VGA;
+	cc->camera = CLEyeCreateCamera(cguid, raw_bayer ? CLEYE_BAYER_RAW : CLEYE_COLOR_PROCESSED, resolution, fps);
+	CLEyeCameraGetFrameDimensions(cc->camera, &cc->width, &cc->height);
 	// Depending on color mode chosen, create the appropriate OpenCV image
-	cc->frame = cvCreateImage(cvSize(w, h), IPL_DEPTH_8U, 4);
-	cc->frame3ch = cvCreateImage(cvSize(w, h), IPL_DEPTH_8U, 3);
+	cc->frame = cvCreateImage(cvSize(cc->width, cc->height), IPL_DEPTH_8U, raw_bayer ? 1 : 4);
+	if (raw_bayer) {
+		cc->width /= 2;
+		cc->height /= 2;
+	}
+	cc->frame3ch = cvCreateImage(cvSize(cc->width, cc->height), IPL_DEPTH_8U, 3);
 	CLEyeCameraStart(cc->camera);
 #else
 #ifndef WIN32
 	sprintf(cc->device, "/dev/video%d", cc->cameraID);
 #endif
-	cc->capture = cvCaptureFromCAM(cc->cameraID);
-	cvSetCaptureProperty(cc->capture, CV_CAP_PROP_FRAME_WIDTH, 640);
-	cvSetCaptureProperty(cc->capture, CV_CAP_PROP_FRAME_HEIGHT, 480);
-	// not working
-	//cvSetCaptureProperty(cc->capture, CV_CAP_PROP_FPS, 60);
+	cc_open_capture(cc);
+	// the first frame tells if the driver delivers raw frames
+	if (cc->raw_bayer)
+		camera_control_query_frame(cc);
 #endif
 
 	return cc;
 }
 
+int camera_control_get_raw_bayer(CameraControl* cc) {
+	return cc->raw_bayer;
+}
+
+void camera_control_get_mode(CameraControl* cc, int* width, int* height, int* fps) {
+	if (width != 0x0)
+		*width = cc->width;
+	if (height != 0x0)
+		*height = cc->height;
+	if (fps != 0x0)
+		*fps = cc->fps;
+}
+
+void cc_open_capture(CameraControl* cc) {
+#if !defined(WIN32) || !defined(USE_CL_DRIVER)
+	cc->capture = cvCaptureFromCAM(cc->cameraID);
+	cvSetCaptureProperty(cc->capture, CV_CAP_PROP_FRAME_WIDTH, cc->width);
+	cvSetCaptureProperty(cc->capture, CV_CAP_PROP_FRAME_HEIGHT, cc->height);
+	// not supported by all backends, the camera keeps its default frame rate then
+	cvSetCaptureProperty(cc->capture, CV_CAP_PROP_FPS, cc->fps);
+	if (cc->raw_bayer) {
+		// the mosaic as it is read from the sensor (1 byte per pixel), without conversion to BGR
+		cvSetCaptureProperty(cc->capture, CV_CAP_PROP_FOURCC, CV_FOURCC('G', 'B', 'R', 'G'));
+		cvSetCaptureProperty(cc->capture, CV_CAP_PROP_CONVERT_RGB, 0);
+		// backends ignore what they do not support, only the format they report is trusted
+		if ((int) cvGetCaptureProperty(cc->capture, CV_CAP_PROP_FOURCC) != CV_FOURCC('G', 'B', 'R', 'G'))
+			cc_disable_raw_bayer(cc);
+	}
+	// the driver may have chosen a different resolution
+	int w = (int) cvGetCaptureProperty(cc->capture, CV_CAP_PROP_FRAME_WIDTH);
+	int h = (int) cvGetCaptureProperty(cc->capture, CV_CAP_PROP_FRAME_HEIGHT);
+	if (w > 0 && h > 0) {
+		cc->width = cc->raw_bayer ? w / 2 : w;
+		cc->height = cc->raw_bayer ? h / 2 : h;
+	}
+#endif
+}
+
+void cc_disable_raw_bayer(CameraControl* cc) {
+#if !defined(WIN32) || !defined(USE_CL_DRIVER)
+	cc->raw_bayer = 0;
+	cvSetCaptureProperty(cc->capture, CV_CAP_PROP_CONVERT_RGB, 1);
+#endif
+}
+
+void cc_pack_bayer_quads(IplImage* mosaic, IplImage* dst) {
+	int y;
+	for (y = 0; y < dst->height; y++) {
+		const unsigned char* even = (const unsigned char*) mosaic->imageData + 2 * y * mosaic->widthStep;
+		color_gbrg2bgr_quads_row(even, even + mosaic->widthStep, (unsigned char*) dst->imageData + y * dst->widthStep, dst->width);
+	}
+}
+
 void camera_control_read_calibration(CameraControl* cc, char* intrinsicsFile, char* distortionFile) {
 	CvMat *intrinsic = (CvMat*) cvLoad(intrinsicsFile, 0, 0, 0);
 	CvMat *distortion = (CvMat*) cvLoad(distortionFile, 0, 0, 0);
 
-	if (cc->mapx != 0x0)
-		cvReleaseImage(&cc->mapx);
-	if (cc->mapy != 0x0)
-		cvReleaseImage(&cc->mapy);
+	cc_release_undistort_maps(cc);
+	if (cc->intrinsic != 0x0)
+		cvReleaseMat(&cc->intrinsic);
+	if (cc->distortion != 0x0)
+		cvReleaseMat(&cc->distortion);
 
 	printf("\n%s\n", "### Trying to read camera calibration...");
 	if (intrinsic != 0 && distortion != 0) {
-		if (cc->frame3chUndistort == 0x0)
-			cc->frame3chUndistort = cvCloneImage(camera_control_query_frame(cc));
-
-		cc->mapx = cvCreateImage(cvSize(640, 480), IPL_DEPTH_32F, 1);
-		cc->mapy = cvCreateImage(cvSize(640, 480), IPL_DEPTH_32F, 1);
-		cvInitUndistortMap(intrinsic, distortion, cc->mapx, cc->mapy);
+		cc_scale_calibration(cc, intrinsic);
+		cc->intrinsic = intrinsic;
+		cc->distortion = distortion;
+		if (cc->undistort_frames)
+			cc_init_undistort_maps(cc);
 
 		printf("%s\n", "OK");
 	} else {
+		if (intrinsic != 0)
+			cvReleaseMat(&intrinsic);
+		if (distortion != 0)
+			cvReleaseMat(&distortion);
 		printf("%s\n", "Warning");
 		printf("%s\n", "--> Unable to read camera calibration files.\n");
 		printf("--> Make sure that both \"%s\" and \"%s\" exist.\n", intrinsicsFile, distortionFile);
 	}
 }
 
+int camera_control_get_calibration(CameraControl* cc, CvMat** intrinsic, CvMat** distortion) {
+	if (intrinsic != 0x0)
+		*intrinsic = cc->intrinsic;
+	if (distortion != 0x0)
+		*distortion = cc->distortion;
+	return cc->intrinsic != 0x0 && cc->distortion != 0x0;
+}
+
+void camera_control_set_undistort_frames(CameraControl* cc, int enabled) {
+	cc->undistort_frames = enabled;
+	if (!enabled)
+		cc_release_undistort_maps(cc);
+	else if (cc->mapx == 0x0 && cc->intrinsic != 0x0 && cc->distortion != 0x0)
+		cc_init_undistort_maps(cc);
+}
+
+int camera_control_get_undistort_frames(CameraControl* cc) {
+	return cc->undistort_frames && cc->mapx != 0x0;
+}
+
+void cc_scale_calibration(CameraControl* cc, CvMat* intrinsic) {
+	// the calibration files do not record the resolution they have been made at, but the principal point
+	// is close to the center of the frame. the modes of the PS Eye bin the pixels of the whole sensor (they
+	// do not crop it), so a calibration made at another resolution (e.g. VGA, used in QVGA mode) is scaled
+	double cx = cvmGet(intrinsic, 0, 2);
+	double s = 1;
+	if (cx <= 0)
+		return;
+	while (2 * cx * s > cc->width * 1.5)
+		s *= 0.5;
+	while (2 * cx * s < cc->width * 0.75)
+		s *= 2;
+	if (s != 1) {
+		cvmSet(intrinsic, 0, 0, cvmGet(intrinsic, 0, 0) * s);
+		cvmSet(intrinsic, 0, 2, cvmGet(intrinsic, 0, 2) * s);
+		cvmSet(intrinsic, 1, 1, cvmGet(intrinsic, 1, 1) * s);
+		cvmSet(intrinsic, 1, 2, cvmGet(intrinsic, 1, 2) * s);
+	}
+}
+
+void cc_init_undistort_maps(CameraControl* cc) {
+	if (cc->frame3chUndistort == 0x0)
+		cc->frame3chUndistort = cvCloneImage(camera_control_query_frame(cc));
+
+	cc->mapx = cvCreateImage(cvGetSize(cc->frame3chUndistort), IPL_DEPTH_32F, 1);
+	cc->mapy = cvCreateImage(cvGetSize(cc->frame3chUndistort), IPL_DEPTH_32F, 1);
+	cvInitUndistortMap(cc->intrinsic, cc->distortion, cc->mapx, cc->mapy);
+}
+
+void cc_release_undistort_maps(CameraControl* cc) {
+	if (cc->mapx != 0x0)
+		cvReleaseImage(&cc->mapx);
+	if (cc->mapy != 0x0)
+		cvReleaseImage(&cc->mapy);
+}
+
 IplImage* camera_control_query_frame(CameraControl* cc) {
 	IplImage* retVal;
 #if defined(WIN32) && defined(USE_CL_DRIVER)
@@ -129,21 +273,46 @@ IplImage* camera_control_query_frame(CameraControl* cc) {
 	cvGetRawData(cc->frame, &cc->pCapBuffer, 0, 0);
 	// read image
 	CLEyeCameraGetFrame(cc->camera, cc->pCapBuffer, 2000);
-	// convert 4ch image to 3ch image
-	const int from_to[] = { 0, 0, 1, 1, 2, 2 };
-	const CvArr** src = (const CvArr**) &cc->frame;
-	CvArr** dst = (CvArr**) &cc->frame3ch;
-	cvMixChannels(src, 1, dst, 1, from_to, 3);
+	if (cc->raw_bayer) {
+		// every quad of the mosaic is one pixel (no demosaicing)
+		cc_pack_bayer_quads(cc->frame, cc->frame3ch);
+	} else {
+		// convert 4ch image to 3ch image
+		const int from_to[] = { 0, 0, 1, 1, 2, 2 };
+		const CvArr** src = (const CvArr**) &cc->frame;
+		CvArr** dst = (CvArr**) &cc->frame3ch;
+		cvMixChannels(src, 1, dst, 1, from_to, 3);
+	}
 	// return image
 	retVal = cc->frame3ch;
 #else
 	retVal = cvQueryFrame(cc->capture);
+	if (retVal != 0x0 && cc->raw_bayer) {
+		// only a mosaic of the negotiated mode is packed, anything else is no raw frame
+		if (retVal->nChannels == 1 && retVal->depth == IPL_DEPTH_8U && retVal->width == 2 * cc->width && retVal->height == 2 * cc->height) {
+			// every quad of the mosaic is one pixel (no demosaicing)
+			if (cc->frameQuads == 0x0)
+				cc->frameQuads = cvCreateImage(cvSize(cc->width, cc->height), IPL_DEPTH_8U, 3);
+			cc_pack_bayer_quads(retVal, cc->frameQuads);
+			retVal = cc->frameQuads;
+		} else {
+			// the driver does not deliver raw frames, its color frames are used instead
+			cc_disable_raw_bayer(cc);
+			if (retVal->nChannels == 3) {
+				cc->width = retVal->width;
+				cc->height = retVal->height;
+			} else {
+				// this frame can be neither packed nor tracked, the next one is converted by the driver
+				retVal = 0x0;
+			}
+		}
+	}
 #endif
 
 	//IplImage *t = cvCloneImage(retv);
 	//cvShowImage("Calibration", image); // Show raw image
 	// undistort image
-	if (cc->mapx != 0x0 && cc->mapy != 0x0) {
+	if (retVal != 0x0 && cc->mapx != 0x0 && cc->mapy != 0x0) {
 		cvRemap(retVal, cc->frame3chUndistort, cc->mapx, cc->mapy, CV_INTER_LINEAR + CV_WARP_FILL_OUTLIERS, cvScalarAll(0));
 		retVal = cc->frame3chUndistort;
 	}
@@ -181,11 +350,14 @@ void camera_control_delete(CameraControl** cameraCtrl) {
 #endif
 	if (cc->frame3chUndistort != 0x0)
 		cvReleaseImage(&cc->frame3chUndistort);
+	if (cc->frameQuads != 0x0)
+		cvReleaseImage(&cc->frameQuads);
 
-	if (cc->mapx != 0x0)
-		cvReleaseImage(&cc->mapx);
-	if (cc->mapy != 0x0)
-		cvReleaseImage(&cc->mapy);
+	cc_release_undistort_maps(cc);
+	if (cc->intrinsic != 0x0)
+		cvReleaseMat(&cc->intrinsic);
+	if (cc->distortion != 0x0)
+		cvReleaseMat(&cc->distortion);
 
 	free(*cameraCtrl);
 	*cameraCtrl = 0;
@@ -200,6 +372,31 @@ void camera_control_set_parameters(CameraControl* cc, int autoE, int autoG, int
 #endif
 }
 
+void camera_control_set_exposure(CameraControl* cc, int exposure) {
+	if (exposure < 0)
+		return;
+#if defined(WIN32) && defined(USE_CL_DRIVER)
+	CLEyeSetCameraParameter(cc->camera, CLEYE_EXPOSURE, round((511 * exposure) / 0xFFFF));
+#elif defined(WIN32)
+	HKEY hKey;
+	DWORD l = sizeof(DWORD);
+	int err = RegOpenKeyEx(HKEY_CURRENT_USER, CL_DRIVER_REG_PATH, 0, KEY_ALL_ACCESS, &hKey);
+	if (err != ERROR_SUCCESS) {
+		printf("Error: %d Unable to open reg-key:  [HKCU]\%s!", err, CL_DRIVER_REG_PATH);
+		return;
+	}
+	int val = round((511 * exposure) / 0xFFFF);
+	RegSetValueExA(hKey, "Exposure", 0, REG_DWORD, (CONST BYTE*) &val, l);
+	RegCloseKey(hKey);
+#else
+	int fd = v4l2_open(cc->device, O_RDWR, 0);
+	if (fd != -1) {
+		v4l2_set_control(fd, V4L2_CID_EXPOSURE, exposure);
+		v4l2_close(fd);
+	}
+#endif
+}
+
 /// INTERNAL FUNCTIONS ///////////////////////////////////////////////////////////////////
 void cc_backup_sytem_settings_win(CameraControl* cc, const char* file) {
 #ifdef WIN32
@@ -398,30 +595,37 @@ void cc_set_parameters_win(CameraControl* cc, int autoE, int autoG, int autoWB,
 		printf("Error: %d Unable to open reg-key:  [HKCU]\%s!", err, PATH);
 		return;
 	}
+	// negative values are left unchanged, like with the CL driver
 	val = autoE > 0;
-	RegSetValueExA(hKey, "AutoAEC", 0, REG_DWORD, (CONST BYTE*) &val, l);
+	if (autoE >= 0)
+		RegSetValueExA(hKey, "AutoAEC", 0, REG_DWORD, (CONST BYTE*) &val, l);
 	val = autoG > 0;
-	RegSetValueExA(hKey, "AutoAGC", 0, REG_DWORD, (CONST BYTE*) &val, l);
+	if (autoG >= 0)
+		RegSetValueExA(hKey, "AutoAGC", 0, REG_DWORD, (CONST BYTE*) &val, l);
 	val = autoWB > 0;
-	RegSetValueExA(hKey, "AutoAWB", 0, REG_DWORD, (CONST BYTE*) &val, l);
+	if (autoWB >= 0)
+		RegSetValueExA(hKey, "AutoAWB", 0, REG_DWORD, (CONST BYTE*) &val, l);
 	val = round((511 * exposure) / 0xFFFF);
-	RegSetValueExA(hKey, "Exposure", 0, REG_DWORD, (CONST BYTE*) &val, l);
+	if (exposure >= 0)
+		RegSetValueExA(hKey, "Exposure", 0, REG_DWORD, (CONST BYTE*) &val, l);
 	val = round((79 * gain) / 0xFFFF);
-	RegSetValueExA(hKey, "Gain", 0, REG_DWORD, (CONST BYTE*) &val, l);
+	if (gain >= 0)
+		RegSetValueExA(hKey, "Gain", 0, REG_DWORD, (CONST BYTE*) &val, l);
 	val = round((255 * wbRed) / 0xFFFF);
-	RegSetValueExA(hKey, "WhiteBalanceR", 0, REG_DWORD, (CONST BYTE*) &val, l);
+	if (wbRed >= 0)
+		RegSetValueExA(hKey, "WhiteBalanceR", 0, REG_DWORD, (CONST BYTE*) &val, l);
 	val = round((255 * wbGreen) / 0xFFFF);
-	RegSetValueExA(hKey, "WhiteBalanceG", 0, REG_DWORD, (CONST BYTE*) &val, l);
+	if (wbGreen >= 0)
+		RegSetValueExA(hKey, "WhiteBalanceG", 0, REG_DWORD, (CONST BYTE*) &val, l);
 	val = round((255 * wbBlue) / 0xFFFF);
-	RegSetValueExA(hKey, "WhiteBalanceB", 0, REG_DWORD, (CONST BYTE*) &val, l);
+	if (wbBlue >= 0)
+		RegSetValueExA(hKey, "WhiteBalanceB", 0, REG_DWORD, (CONST BYTE*) &val, l);
 
 	// restart the camera capture with openCv
 	if (cc->capture != 0x0)
 	cvReleaseCapture(&cc->capture);
 
-	cc->capture = cvCaptureFromCAM(cc->cameraID);
-	cvSetCaptureProperty(cc->capture, CV_CAP_PROP_FRAME_WIDTH, 640);
-	cvSetCaptureProperty(cc->capture, CV_CAP_PROP_FRAME_HEIGHT, 480);
+	cc_open_capture(cc);
 #endif
 }
 void cc_set_parameters_linux(CameraControl* cc, int autoE, int autoG, int autoWB, int exposure, int gain, int wbRed, int wbGreen, int wbBlue, int contrast,
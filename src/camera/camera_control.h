@@ -37,10 +37,34 @@
 struct _CameraControl;
 typedef struct _CameraControl CameraControl;
 
+// the mode of camera_control_new, the PS Eye also supports 320x240 at up to 187 fps
+#define CAMERA_CONTROL_DEFAULT_WIDTH 640
+#define CAMERA_CONTROL_DEFAULT_HEIGHT 480
+#define CAMERA_CONTROL_DEFAULT_FPS 60
+
 CameraControl* camera_control_new(int cameraID);
+/*
+ * Opens the camera with the given resolution and frame rate, the driver may choose the nearest mode it supports.
+ * With "raw_bayer", the camera is asked for its raw GBRG Bayer mosaic (V4L2_PIX_FMT_SGBRG8 / CLEYE_BAYER_RAW):
+ * every 2x2 quad becomes one pixel of the frames, which have half the resolution of the mode then. If the
+ * driver does not deliver raw frames, its color frames are used as usual.
+ */
+CameraControl* camera_control_new_with_mode(int cameraID, int width, int height, int fps, int raw_bayer);
+// returns the size of the frames returned by camera_control_query_frame and the frame rate that has been requested
+void camera_control_get_mode(CameraControl* cc, int* width, int* height, int* fps);
+// returns 1 if the frames are packed from the raw Bayer mosaic of the camera
+int camera_control_get_raw_bayer(CameraControl* cc);
 
 void camera_control_read_calibration(CameraControl* cc, char* intrinsicsFile, char* distortionFile);
+// returns 1 if a calibration has been read, the matrices are owned by the camera control
+int camera_control_get_calibration(CameraControl* cc, CvMat** intrinsic, CvMat** distortion);
+// enables/disables the undistortion of every frame (enabled by default, only has an effect if a calibration has been read)
+void camera_control_set_undistort_frames(CameraControl* cc, int enabled);
+int camera_control_get_undistort_frames(CameraControl* cc);
 void camera_control_set_parameters(CameraControl* cc, int autoE, int autoG, int autoWB, int exposure, int gain, int wbRed, int wbGreen, int wbBlue, int contrast, int brightness);
+// changes only the exposure ([0-0xFFFF]) and never reopens the capture, so it may be called while frames are read.
+// on windows without the CL driver, the exposure is stored for the driver and applies when the capture is opened next
+void camera_control_set_exposure(CameraControl* cc, int exposure);
 void camera_control_backup_sytem_settings(CameraControl* cc, const char* file);
 void camera_control_restore_sytem_settings(CameraControl* cc, const char* file);
 
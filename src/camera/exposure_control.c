@@ -0,0 +1,199 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "exposure_control.h"
+#include "../thread/tracker_thread.h"
+
+struct _ExposureControl {
+	CameraControl* cc; // the camera to adjust
+	int min, max; // range of the exposure
+	int target; // the luminance to aim for
+	unsigned int histogram[256]; // luminance histogram of the frame measured last
+	int adjusting; // 1 while the luminance is brought back to the target
+	int settle; // number of frames to ignore until the last change has been applied
+	TrackerMutex process_mutex; // held while a frame is processed, so that a pause waits for it
+	TrackerMutex mutex; // protects everything below
+	int paused; // 1 if the exposure must not be changed
+	int exposure; // the exposure currently set
+	unsigned int changes; // number of changes of the exposure
+	float luminance; // the luminance measured last
+};
+
+/*
+ * exposure_control_process without the process mutex, which the caller holds.
+ */
+int exposure_control_process_locked(ExposureControl* e, IplImage* frame);
+
+ExposureControl* exposure_control_new(CameraControl* cc, int exposure, int min, int max, int target) {
+	ExposureControl* e = (ExposureControl*) calloc(1, sizeof(ExposureControl));
+	e->cc = cc;
+	e->min = min;
+	e->max = max;
+	e->target = target;
+	e->exposure = exposure;
+	e->settle = EXPOSURE_CONTROL_SETTLE_FRAMES;
+	tracker_mutex_init(&e->process_mutex);
+	tracker_mutex_init(&e->mutex);
+	return e;
+}
+
+void exposure_control_release(ExposureControl* e) {
+	if (e == 0x0)
+		return;
+	tracker_mutex_destroy(&e->process_mutex);
+	tracker_mutex_destroy(&e->mutex);
+	free(e);
+}
+
+/*
+ * Builds the luminance histogram of the frame and returns the mean luminance of all
+ * pixels except the brightest ones, which are mostly the spheres and light sources.
+ */
+float exposure_control_measure(ExposureControl* e, IplImage* frame) {
+	int x, y, i;
+	unsigned int n = 0;
+	for (i = 0; i < 256; i++)
+		e->histogram[i] = 0;
+
+	for (y = 0; y < frame->height; y += EXPOSURE_CONTROL_SAMPLE_STEP) {
+		const unsigned char* p = (const unsigned char*) frame->imageData + y * frame->widthStep;
+		for (x = 0; x < frame->width; x += EXPOSURE_CONTROL_SAMPLE_STEP, p += EXPOSURE_CONTROL_SAMPLE_STEP * 3)
+			e->histogram[(p[0] + 2 * p[1] + p[2]) >> 2]++;
+		n += (frame->width + EXPOSURE_CONTROL_SAMPLE_STEP - 1) / EXPOSURE_CONTROL_SAMPLE_STEP;
+	}
+
+	// sum up from the dark end until all but the brightest pixels are counted
+	unsigned int keep = n - (unsigned int) (n * EXPOSURE_CONTROL_IGNORE_BRIGHT);
+	unsigned int counted = 0;
+	double sum = 0;
+	for (i = 0; i < 256 && counted < keep; i++) {
+		unsigned int c = e->histogram[i];
+		if (counted + c > keep)
+			c = keep - counted;
+		counted += c;
+		sum += (double) c * i;
+	}
+	return counted > 0 ? sum / counted : 0;
+}
+
+int exposure_control_process(ExposureControl* e, IplImage* frame) {
+	tracker_mutex_lock(&e->process_mutex);
+	int changed = exposure_control_process_locked(e, frame);
+	tracker_mutex_unlock(&e->process_mutex);
+	return changed;
+}
+
+int exposure_control_process_locked(ExposureControl* e, IplImage* frame) {
+	tracker_mutex_lock(&e->mutex);
+	int paused = e->paused;
+	int exposure = e->exposure;
+	tracker_mutex_unlock(&e->mutex);
+
+	if (paused) {
+		// the frames right after the pause may still show the conditions of the pause
+		e->settle = EXPOSURE_CONTROL_SETTLE_FRAMES;
+		return 0;
+	}
+	if (e->settle > 0) {
+		e->settle--;
+		return 0;
+	}
+
+	float luminance = exposure_control_measure(e, frame);
+	tracker_mutex_lock(&e->mutex);
+	e->luminance = luminance;
+	tracker_mutex_unlock(&e->mutex);
+
+	float deviation = fabs(luminance - e->target) / e->target;
+	if (!e->adjusting && deviation <= EXPOSURE_CONTROL_START)
+		return 0;
+	if (e->adjusting && deviation <= EXPOSURE_CONTROL_STOP) {
+		e->adjusting = 0;
+		return 0;
+	}
+	e->adjusting = 1;
+
+	// the luminance is roughly proportional to the exposure
+	float factor = e->target / (luminance > 1 ? luminance : 1);
+	if (factor > EXPOSURE_CONTROL_MAX_STEP)
+		factor = EXPOSURE_CONTROL_MAX_STEP;
+	if (factor < 1.0 / EXPOSURE_CONTROL_MAX_STEP)
+		factor = 1.0 / EXPOSURE_CONTROL_MAX_STEP;
+	int next = (int) (exposure * factor + 0.5);
+	if (next < e->min)
+		next = e->min;
+	if (next > e->max)
+		next = e->max;
+	if (next == exposure) {
+		// at the limit of the range, there is nothing more to do
+		e->adjusting = 0;
+		return 0;
+	}
+
+	// only the exposure is changed, all other parameters are left as they are
+	camera_control_set_exposure(e->cc, next);
+	tracker_mutex_lock(&e->mutex);
+	e->exposure = next;
+	e->changes++;
+	tracker_mutex_unlock(&e->mutex);
+	e->settle = EXPOSURE_CONTROL_SETTLE_FRAMES;
+	return 1;
+}
+
+void exposure_control_set_paused(ExposureControl* e, int paused) {
+	// waits for a frame that is processed right now, so that the exposure does not change after a pause has been set
+	tracker_mutex_lock(&e->process_mutex);
+	tracker_mutex_lock(&e->mutex);
+	e->paused = paused;
+	tracker_mutex_unlock(&e->mutex);
+	tracker_mutex_unlock(&e->process_mutex);
+}
+
+int exposure_control_get_exposure(ExposureControl* e) {
+	tracker_mutex_lock(&e->mutex);
+	int exposure = e->exposure;
+	tracker_mutex_unlock(&e->mutex);
+	return exposure;
+}
+
+unsigned int exposure_control_get_changes(ExposureControl* e) {
+	tracker_mutex_lock(&e->mutex);
+	unsigned int changes = e->changes;
+	tracker_mutex_unlock(&e->mutex);
+	return changes;
+}
+
+float exposure_control_get_luminance(ExposureControl* e) {
+	tracker_mutex_lock(&e->mutex);
+	float luminance = e->luminance;
+	tracker_mutex_unlock(&e->mutex);
+	return luminance;
+}
@@ -0,0 +1,67 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef EXPOSURE_CONTROL_H_
+#define EXPOSURE_CONTROL_H_
+
+#include "opencv2/core/core_c.h"
+
+#include "camera_control.h"
+
+#define EXPOSURE_CONTROL_SAMPLE_STEP 4		// only every x-th pixel of every x-th row is counted in the histogram
+#define EXPOSURE_CONTROL_IGNORE_BRIGHT 0.02	// fraction of the brightest pixels (spheres, lamps) that is left out of the luminance
+#define EXPOSURE_CONTROL_START 0.25			// relative deviation from the target luminance that starts an adjustment
+#define EXPOSURE_CONTROL_STOP 0.08			// relative deviation from the target luminance that ends an adjustment
+#define EXPOSURE_CONTROL_MAX_STEP 1.5		// maximal factor the exposure is changed by at once, so that the color filters keep up
+#define EXPOSURE_CONTROL_SETTLE_FRAMES 3	// number of frames that are ignored after a change, until the camera has applied it
+
+/* Opaque data type for the exposure control */
+struct _ExposureControl;
+typedef struct _ExposureControl ExposureControl;
+
+/*
+ * Keeps the luminance of the background at a target by adjusting the exposure of the camera.
+ * A luminance histogram of every frame is built while it is captured; assuming that the
+ * luminance is proportional to the exposure, the exposure that hits the target is solved for
+ * directly, so that it converges within a few frames. An adjustment only starts if the
+ * luminance deviates clearly from the target and continues until it is close to it again
+ * (hysteresis), so that the exposure does not flicker. The control may be paused from
+ * another thread, e.g. while sphere colors are calibrated.
+ */
+ExposureControl* exposure_control_new(CameraControl* cc, int exposure, int min, int max, int target); // constructor
+void exposure_control_release(ExposureControl* e); // destructor
+// measures a frame and changes the exposure of the camera if necessary, returns 1 if it has been changed
+int exposure_control_process(ExposureControl* e, IplImage* frame);
+// while paused, the exposure is not changed. waits until a frame that is being processed is done, so that
+// the exposure does not change anymore once the call returns
+void exposure_control_set_paused(ExposureControl* e, int paused);
+int exposure_control_get_exposure(ExposureControl* e); // the exposure currently set
+unsigned int exposure_control_get_changes(ExposureControl* e); // the number of times the exposure has been changed
+float exposure_control_get_luminance(ExposureControl* e); // the luminance of the background measured last
+
+#endif /* EXPOSURE_CONTROL_H_ */
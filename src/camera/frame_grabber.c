@@ -0,0 +1,178 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+#include "frame_grabber.h"
+#include "../thread/tracker_thread.h"
+#include "../timer/high_precision_timer.h"
+
+struct _FrameGrabber {
+	CameraControl* cc; // the camera to read
+	ExposureControl* exposure; // adjusts the exposure of the camera to every captured frame (NULL = fixed exposure)
+	TrackerThread thread; // the capturing thread
+	TrackerMutex mutex; // protects everything below
+	TrackerCond cond; // signals a new frame (or the end of the thread)
+	int running; // 0 if the thread shall end
+	IplImage* capture; // the frame that is being copied from the camera (capturing thread only)
+	IplImage* ready; // the newest frame
+	int fresh; // "ready" has not been taken yet
+	int64_t ready_ns; // the monotonic time when "ready" arrived
+	IplImage* front; // the frame handed out to the tracker (tracker only)
+	unsigned int processed; // number of frames taken
+	unsigned int dropped; // number of frames replaced before they were taken
+	float delay_avg; // smoothed queueing delay (in ms)
+	float delay_max; // maximal queueing delay (in ms)
+};
+
+void frame_grabber_main(void* arg) {
+	FrameGrabber* g = (FrameGrabber*) arg;
+	IplImage* tmp;
+
+	while (1) {
+		tracker_mutex_lock(&g->mutex);
+		int running = g->running;
+		tracker_mutex_unlock(&g->mutex);
+		if (!running)
+			break;
+
+		// blocks until the camera delivers the next frame
+		IplImage* frame = camera_control_query_frame(g->cc);
+		if (frame == 0x0) {
+#ifdef WIN32
+			Sleep(1);
+#else
+			usleep(1000);
+#endif
+			continue;
+		}
+		if (g->capture == 0x0)
+			g->capture = cvCloneImage(frame);
+		else
+			cvCopy(frame, g->capture, 0x0);
+		int64_t now = hp_timer_now_ns();
+
+		// publish the frame, the previous one is dropped if it has not been taken
+		tracker_mutex_lock(&g->mutex);
+		tmp = g->ready;
+		g->ready = g->capture;
+		g->capture = tmp;
+		if (g->fresh)
+			g->dropped++;
+		g->fresh = 1;
+		g->ready_ns = now;
+		tracker_cond_signal(&g->cond);
+		tracker_mutex_unlock(&g->mutex);
+
+		// measured after the hand-over, so that it does not add to the latency ("frame" is valid until the next query)
+		if (g->exposure != 0x0)
+			exposure_control_process(g->exposure, frame);
+	}
+
+	tracker_mutex_lock(&g->mutex);
+	tracker_cond_broadcast(&g->cond);
+	tracker_mutex_unlock(&g->mutex);
+}
+
+FrameGrabber* frame_grabber_new(CameraControl* cc, ExposureControl* exposure) {
+	FrameGrabber* g = (FrameGrabber*) calloc(1, sizeof(FrameGrabber));
+	g->cc = cc;
+	g->exposure = exposure;
+	g->running = 1;
+	tracker_mutex_init(&g->mutex);
+	tracker_cond_init(&g->cond);
+	if (!tracker_thread_create(&g->thread, frame_grabber_main, g)) {
+		tracker_cond_destroy(&g->cond);
+		tracker_mutex_destroy(&g->mutex);
+		free(g);
+		return 0x0;
+	}
+	return g;
+}
+
+void frame_grabber_release(FrameGrabber* g) {
+	if (g == 0x0)
+		return;
+
+	tracker_mutex_lock(&g->mutex);
+	g->running = 0;
+	tracker_mutex_unlock(&g->mutex);
+	tracker_thread_join(g->thread);
+
+	tracker_cond_destroy(&g->cond);
+	tracker_mutex_destroy(&g->mutex);
+	if (g->capture != 0x0)
+		cvReleaseImage(&g->capture);
+	if (g->ready != 0x0)
+		cvReleaseImage(&g->ready);
+	if (g->front != 0x0)
+		cvReleaseImage(&g->front);
+	free(g);
+}
+
+IplImage* frame_grabber_query_frame(FrameGrabber* g) {
+	IplImage* tmp;
+
+	tracker_mutex_lock(&g->mutex);
+	while (g->running && !g->fresh)
+		tracker_cond_wait(&g->cond, &g->mutex);
+	if (!g->fresh) {
+		tracker_mutex_unlock(&g->mutex);
+		return 0x0;
+	}
+
+	// take the newest frame, the grabber gets the old one back for the next frame
+	tmp = g->front;
+	g->front = g->ready;
+	g->ready = tmp;
+	g->fresh = 0;
+
+	float delay = (hp_timer_now_ns() - g->ready_ns) * 0.000001f;
+	g->delay_avg = g->processed == 0 ? delay : 0.85f * g->delay_avg + 0.15f * delay;
+	if (delay > g->delay_max)
+		g->delay_max = delay;
+	g->processed++;
+	tracker_mutex_unlock(&g->mutex);
+	return g->front;
+}
+
+void frame_grabber_get_statistics(FrameGrabber* g, unsigned int* processed, unsigned int* dropped, float* delay_avg, float* delay_max) {
+	tracker_mutex_lock(&g->mutex);
+	if (processed != 0x0)
+		*processed = g->processed;
+	if (dropped != 0x0)
+		*dropped = g->dropped;
+	if (delay_avg != 0x0)
+		*delay_avg = g->delay_avg;
+	if (delay_max != 0x0)
+		*delay_max = g->delay_max;
+	tracker_mutex_unlock(&g->mutex);
+}
@@ -0,0 +1,61 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef FRAME_GRABBER_H_
+#define FRAME_GRABBER_H_
+
+#include "opencv2/core/core_c.h"
+
+#include "camera_control.h"
+#include "exposure_control.h"
+
+/* Opaque data type for the frame grabber */
+struct _FrameGrabber;
+typedef struct _FrameGrabber FrameGrabber;
+
+/*
+ * Reads the camera on its own thread, so that the buffers of the driver never fill up.
+ * Only the newest frame is kept: a frame that has not been taken before the next one
+ * arrives is dropped. This bounds the latency to the age of a single frame, at the cost
+ * of skipping frames whenever the tracker falls behind the camera.
+ */
+// constructor, starts reading the camera; if "exposure" is set, every frame is passed to it on the capturing thread
+FrameGrabber* frame_grabber_new(CameraControl* cc, ExposureControl* exposure);
+void frame_grabber_release(FrameGrabber* g); // destructor, stops reading the camera (the camera is not released)
+// waits for a frame that has not been returned before and returns it, it is valid until the next call
+IplImage* frame_grabber_query_frame(FrameGrabber* g);
+
+/*
+ * processed	- (out) the number of frames returned by frame_grabber_query_frame
+ * dropped		- (out) the number of frames that have been replaced by newer ones before they were taken
+ * delay_avg	- (out) the smoothed time between the arrival of a frame and it being taken (in ms)
+ * delay_max	- (out) the maximal time between the arrival of a frame and it being taken (in ms)
+ */
+void frame_grabber_get_statistics(FrameGrabber* g, unsigned int* processed, unsigned int* dropped, float* delay_avg, float* delay_max);
+
+#endif /* FRAME_GRABBER_H_ */
@@ -0,0 +1,174 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+
+#include "tracker_events.h"
+#include "../thread/tracker_thread.h"
+
+typedef struct {
+	PSMoveTrackerEventCallback callback;
+	void* user_data;
+} TrackerSubscriber;
+
+struct _TrackerEvents {
+	TrackerMutex mutex; // protects everything below
+	TrackerCond idle; // signals that no callback is running anymore
+	TrackerSubscriber subscriber[TRACKER_EVENTS_MAX_SUBSCRIBERS];
+	int subscribers; // number of valid entries in "subscriber"
+	int delivering; // number of callbacks that are running
+	PSMoveTrackerEvent* queue; // ring buffer of events (NULL = no queue)
+	int capacity; // size of "queue"
+	int head; // index of the oldest event
+	int count; // number of events in the queue
+	volatile int wanted; // there are subscribers or a queue (read without the mutex on the hot path)
+};
+
+// the dispatcher whose callback is running on this thread (a callback that unsubscribes must not wait for itself)
+static TRACKER_THREAD_LOCAL TrackerEvents* tracker_events_in_callback = 0x0;
+
+TrackerEvents* tracker_events_new() {
+	TrackerEvents* e = (TrackerEvents*) calloc(1, sizeof(TrackerEvents));
+	tracker_mutex_init(&e->mutex);
+	tracker_cond_init(&e->idle);
+	return e;
+}
+
+void tracker_events_release(TrackerEvents* e) {
+	if (e == 0x0)
+		return;
+	tracker_cond_destroy(&e->idle);
+	tracker_mutex_destroy(&e->mutex);
+	free(e->queue);
+	free(e);
+}
+
+int tracker_events_subscribe(TrackerEvents* e, PSMoveTrackerEventCallback callback, void* user_data) {
+	int result = 0;
+	tracker_mutex_lock(&e->mutex);
+	if (e->subscribers < TRACKER_EVENTS_MAX_SUBSCRIBERS) {
+		e->subscriber[e->subscribers].callback = callback;
+		e->subscriber[e->subscribers].user_data = user_data;
+		e->subscribers++;
+		e->wanted = 1;
+		result = 1;
+	}
+	tracker_mutex_unlock(&e->mutex);
+	return result;
+}
+
+void tracker_events_unsubscribe(TrackerEvents* e, PSMoveTrackerEventCallback callback, void* user_data) {
+	int i;
+	tracker_mutex_lock(&e->mutex);
+	for (i = 0; i < e->subscribers; i++) {
+		if (e->subscriber[i].callback == callback && e->subscriber[i].user_data == user_data) {
+			e->subscriber[i] = e->subscriber[--e->subscribers];
+			break;
+		}
+	}
+	e->wanted = e->subscribers > 0 || e->queue != 0x0;
+	// a callback that has been started before it was removed may still be running on another thread
+	if (tracker_events_in_callback != e) {
+		while (e->delivering > 0)
+			tracker_cond_wait(&e->idle, &e->mutex);
+	}
+	tracker_mutex_unlock(&e->mutex);
+}
+
+int tracker_events_is_subscribed(TrackerEvents* e, TrackerSubscriber* s) {
+	int i;
+	for (i = 0; i < e->subscribers; i++) {
+		if (e->subscriber[i].callback == s->callback && e->subscriber[i].user_data == s->user_data)
+			return 1;
+	}
+	return 0;
+}
+
+void tracker_events_set_queue(TrackerEvents* e, int capacity) {
+	tracker_mutex_lock(&e->mutex);
+	free(e->queue);
+	e->queue = capacity > 0 ? (PSMoveTrackerEvent*) calloc(capacity, sizeof(PSMoveTrackerEvent)) : 0x0;
+	e->capacity = capacity > 0 ? capacity : 0;
+	e->head = 0;
+	e->count = 0;
+	e->wanted = e->subscribers > 0 || e->queue != 0x0;
+	tracker_mutex_unlock(&e->mutex);
+}
+
+int tracker_events_poll(TrackerEvents* e, PSMoveTrackerEvent* event) {
+	int result = 0;
+	tracker_mutex_lock(&e->mutex);
+	if (e->count > 0) {
+		*event = e->queue[e->head];
+		e->head = (e->head + 1) % e->capacity;
+		e->count--;
+		result = 1;
+	}
+	tracker_mutex_unlock(&e->mutex);
+	return result;
+}
+
+int tracker_events_is_wanted(TrackerEvents* e) {
+	return e->wanted;
+}
+
+void tracker_events_emit(TrackerEvents* e, const PSMoveTrackerEvent* event) {
+	TrackerSubscriber subscriber[TRACKER_EVENTS_MAX_SUBSCRIBERS];
+	TrackerEvents* outer = tracker_events_in_callback;
+	int subscribers, i;
+
+	tracker_mutex_lock(&e->mutex);
+	if (e->queue != 0x0) {
+		if (e->count == e->capacity) {
+			// drop the oldest event
+			e->head = (e->head + 1) % e->capacity;
+			e->count--;
+		}
+		e->queue[(e->head + e->count) % e->capacity] = *event;
+		e->count++;
+	}
+	// the callbacks are called without the mutex, so that they may (un)subscribe
+	subscribers = e->subscribers;
+	for (i = 0; i < subscribers; i++)
+		subscriber[i] = e->subscriber[i];
+
+	tracker_events_in_callback = e;
+	for (i = 0; i < subscribers; i++) {
+		// skip the callbacks that have been removed by the ones before
+		if (!tracker_events_is_subscribed(e, &subscriber[i]))
+			continue;
+		e->delivering++;
+		tracker_mutex_unlock(&e->mutex);
+		subscriber[i].callback(event, subscriber[i].user_data);
+		tracker_mutex_lock(&e->mutex);
+		if (--e->delivering == 0)
+			tracker_cond_broadcast(&e->idle);
+	}
+	tracker_events_in_callback = outer;
+	tracker_mutex_unlock(&e->mutex);
+}
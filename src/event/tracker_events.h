@@ -0,0 +1,59 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef TRACKER_EVENTS_H_
+#define TRACKER_EVENTS_H_
+
+#include "../psmove_tracker.h"
+
+#define TRACKER_EVENTS_MAX_SUBSCRIBERS 8 // maximum number of registered callbacks
+
+/* Opaque data type for the event dispatcher */
+struct _TrackerEvents;
+typedef struct _TrackerEvents TrackerEvents;
+
+/*
+ * Delivers the events of the tracker to the registered callbacks (on the thread that
+ * emits them) and, if enabled, to a bounded queue that can be polled from any thread.
+ * If the queue is full, its oldest event is dropped.
+ *
+ * Once tracker_events_unsubscribe has returned, the callback is not called anymore:
+ * called from another thread, it waits until the running callbacks have returned;
+ * called from within a callback, the removed callback does not get the current event
+ * either (if it has not been called yet).
+ */
+TrackerEvents* tracker_events_new(); // constructor
+void tracker_events_release(TrackerEvents* e); // destructor
+int tracker_events_subscribe(TrackerEvents* e, PSMoveTrackerEventCallback callback, void* user_data); // returns 0 if there are too many subscribers
+void tracker_events_unsubscribe(TrackerEvents* e, PSMoveTrackerEventCallback callback, void* user_data);
+void tracker_events_set_queue(TrackerEvents* e, int capacity); // 0 disables the queue (and drops its events)
+int tracker_events_poll(TrackerEvents* e, PSMoveTrackerEvent* event); // returns 1 if an event has been taken from the queue
+int tracker_events_is_wanted(TrackerEvents* e); // 1 if there is anybody to deliver events to
+void tracker_events_emit(TrackerEvents* e, const PSMoveTrackerEvent* event); // delivers an event
+
+#endif /* TRACKER_EVENTS_H_ */
@@ -0,0 +1,98 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flight_recorder.h"
+
+struct _FlightRecorder {
+	FlightRecorderEvent* events; // the ring buffer
+	int capacity; // maximum number of events within the ring buffer
+	uint32_t written; // total number of events ever written to the ring buffer
+};
+
+FlightRecorder* flight_recorder_create(int capacity) {
+	FlightRecorder* fr = (FlightRecorder*) calloc(1, sizeof(FlightRecorder));
+	if (capacity <= 0)
+		capacity = FLIGHT_RECORDER_DEFAULT_SIZE;
+	fr->events = (FlightRecorderEvent*) calloc(capacity, sizeof(FlightRecorderEvent));
+	fr->capacity = capacity;
+	fr->written = 0;
+	return fr;
+}
+
+void flight_recorder_release(FlightRecorder* fr) {
+	if (fr == 0x0)
+		return;
+	free(fr->events);
+	free(fr);
+}
+
+FlightRecorderEvent* flight_recorder_next(FlightRecorder* fr) {
+	FlightRecorderEvent* e = &fr->events[fr->written % fr->capacity];
+	fr->written++;
+	memset(e, 0, sizeof(FlightRecorderEvent));
+	return e;
+}
+
+int flight_recorder_count(FlightRecorder* fr) {
+	return fr->written < (uint32_t) fr->capacity ? (int) fr->written : fr->capacity;
+}
+
+int flight_recorder_dump(FlightRecorder* fr, const char* file) {
+	FlightRecorderHeader header;
+	int count = flight_recorder_count(fr);
+	// the oldest event is the one that will be overwritten next
+	int first = count < fr->capacity ? 0 : fr->written % fr->capacity;
+	FILE *pFile = fopen(file, "wb");
+	if (pFile == 0x0)
+		return -1;
+
+	memcpy(header.magic, FLIGHT_RECORDER_MAGIC, 4);
+	header.version = FLIGHT_RECORDER_VERSION;
+	header.event_size = sizeof(FlightRecorderEvent);
+	header.count = count;
+	header.overwritten = fr->written - count;
+	fwrite(&header, sizeof(header), 1, pFile);
+
+	// write the ring buffer in two chunks: [first, capacity) and [0, first)
+	fwrite(&fr->events[first], sizeof(FlightRecorderEvent), count - first, pFile);
+	fwrite(&fr->events[0], sizeof(FlightRecorderEvent), first, pFile);
+	fclose(pFile);
+	return count;
+}
+
+int flight_recorder_copy(FlightRecorder* dst, FlightRecorder* src) {
+	if (dst->capacity != src->capacity)
+		return 0;
+	memcpy(dst->events, src->events, flight_recorder_count(src) * sizeof(FlightRecorderEvent));
+	dst->written = src->written;
+	return 1;
+}
@@ -0,0 +1,116 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef FLIGHT_RECORDER_H_
+#define FLIGHT_RECORDER_H_
+
+#include <stdint.h>
+
+#define FLIGHT_RECORDER_MAGIC "PSFR"		// first four bytes of every dump file
+#define FLIGHT_RECORDER_VERSION 3			// increase whenever the layout of FlightRecorderEvent changes
+#define FLIGHT_RECORDER_DEFAULT_SIZE 4096	// number of events kept in memory (~30 seconds of two controllers at 60fps)
+#define FLIGHT_RECORDER_NO_CONTROLLER 0xFF	// controller index used for events that do not belong to an enabled controller
+#define FLIGHT_RECORDER_STAGES 9			// number of stage timings per event (see PSMoveTracker_Stage)
+
+/* Opaque data structure, defined only in flight_recorder.c */
+struct _FlightRecorder;
+typedef struct _FlightRecorder FlightRecorder;
+
+/* Type of a recorded event */
+enum FlightRecorder_EventType {
+	FR_EVENT_FOUND = 1, // the controller has been found in this frame
+	FR_EVENT_NOT_FOUND, // the controller has not been found in this frame
+	FR_EVENT_COLOR_ADAPTED, // the estimated color of the controller has been adapted
+	FR_EVENT_COLOR_RESET, // the adapted color drifted too far away and has been reset to its first estimation
+};
+
+/* A single entry of the flight recorder. The layout is written 1:1 to the dump file. */
+typedef struct {
+	uint32_t frame; // number of the frame processed by psmove_tracker_update
+	uint32_t time_ms; // milliseconds since the tracker has been created
+	uint8_t type; // one of FlightRecorder_EventType
+	uint8_t controller; // slot of the controller within the tracker, it does not change while the controller is enabled
+	uint8_t roi_level; // the current index for the level of ROI
+	uint8_t color[3]; // estimated color of the sphere (BGR)
+	int16_t roi_x, roi_y; // x/y - Coordinates of the ROI
+	int16_t roi_w, roi_h; // width/height of the ROI
+	uint16_t reserved;
+	float x, y, r; // x/y - Coordinates of the controllers sphere and its radius
+	float q1, q2, q3; // quality indicators of the tracker (see psmove_tracker_update_controller)
+	uint32_t duration_us; // time spent on this controller (in micro-seconds)
+	uint16_t stage_us[FLIGHT_RECORDER_STAGES]; // time spent in each stage of the tracker (in micro-seconds, saturated)
+} FlightRecorderEvent;
+
+/* Header of a dump file, followed by "count" events (oldest first) */
+typedef struct {
+	char magic[4]; // FLIGHT_RECORDER_MAGIC
+	uint16_t version; // FLIGHT_RECORDER_VERSION
+	uint16_t event_size; // sizeof(FlightRecorderEvent)
+	uint32_t count; // number of events stored in the file
+	uint32_t overwritten; // number of events that have been overwritten before the dump
+} FlightRecorderHeader;
+
+/**
+ * Creates a new flight recorder holding the last "capacity" events.
+ * All memory is allocated here, recording itself never allocates.
+ **/
+FlightRecorder* flight_recorder_create(int capacity);
+
+/**
+ * Releases the flight recorder and all its events.
+ **/
+void flight_recorder_release(FlightRecorder* fr);
+
+/**
+ * Returns the next (zeroed) slot of the ring buffer, which the caller fills in place.
+ * If the ring buffer is full, the oldest event is overwritten.
+ **/
+FlightRecorderEvent* flight_recorder_next(FlightRecorder* fr);
+
+/**
+ * Returns the number of events currently held by the flight recorder.
+ **/
+int flight_recorder_count(FlightRecorder* fr);
+
+/**
+ * Writes all events currently held by the flight recorder to the given file
+ * (oldest event first). The content of the recorder is not modified.
+ *
+ * Returns: the number of written events, or -1 if the file could not be written
+ **/
+int flight_recorder_dump(FlightRecorder* fr, const char* file);
+
+/**
+ * Copies all events of "src" into "dst", e.g. so that they can be written on another thread.
+ * Both flight recorders must have the same capacity.
+ *
+ * Returns: 1 on success, 0 if the capacities differ
+ **/
+int flight_recorder_copy(FlightRecorder* dst, FlightRecorder* src);
+
+#endif /* FLIGHT_RECORDER_H_ */
@@ -0,0 +1,137 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flight_recorder_writer.h"
+#include "../thread/tracker_thread.h"
+
+struct _FlightRecorderWriter {
+	TrackerThread thread; // the writing thread
+	TrackerMutex mutex; // protects everything below
+	TrackerCond cond; // signals a new copy (or the end of the thread)
+	int pending; // a copy waits to be written
+	int running; // 0 if the thread shall end
+	FlightRecorder* copy; // copy of the recorder handed over by the tracker
+	char* file; // the file the copy is written to
+	FlightRecorder* work; // the copy that is being written (writing thread only)
+	char* work_file; // the file that is being written (writing thread only)
+};
+
+void flight_recorder_writer_main(void* arg) {
+	FlightRecorderWriter* w = (FlightRecorderWriter*) arg;
+	FlightRecorder* tmp;
+	char* tmp_file;
+
+	tracker_mutex_lock(&w->mutex);
+	while (1) {
+		while (w->running && !w->pending)
+			tracker_cond_wait(&w->cond, &w->mutex);
+		// a copy that has been handed over is written, even if the writer is being released
+		if (!w->pending)
+			break;
+
+		// take the copy, the tracker gets the old buffer for the next one
+		tmp = w->work;
+		w->work = w->copy;
+		w->copy = tmp;
+		tmp_file = w->work_file;
+		w->work_file = w->file;
+		w->file = tmp_file;
+		w->pending = 0;
+		tracker_mutex_unlock(&w->mutex);
+
+		if (flight_recorder_dump(w->work, w->work_file) < 0)
+			fprintf(stderr, "[FLIGHTREC] unable to write '%s'\n", w->work_file);
+
+		tracker_mutex_lock(&w->mutex);
+	}
+	tracker_mutex_unlock(&w->mutex);
+}
+
+FlightRecorderWriter* flight_recorder_writer_new(int capacity) {
+	FlightRecorderWriter* w = (FlightRecorderWriter*) calloc(1, sizeof(FlightRecorderWriter));
+	w->pending = 0;
+	w->running = 1;
+	w->copy = flight_recorder_create(capacity);
+	w->work = flight_recorder_create(capacity);
+	w->file = 0x0;
+	w->work_file = 0x0;
+	tracker_mutex_init(&w->mutex);
+	tracker_cond_init(&w->cond);
+	if (!tracker_thread_create(&w->thread, flight_recorder_writer_main, w)) {
+		tracker_cond_destroy(&w->cond);
+		tracker_mutex_destroy(&w->mutex);
+		flight_recorder_release(w->copy);
+		flight_recorder_release(w->work);
+		free(w);
+		return 0x0;
+	}
+	return w;
+}
+
+void flight_recorder_writer_release(FlightRecorderWriter* w) {
+	if (w == 0x0)
+		return;
+	tracker_mutex_lock(&w->mutex);
+	w->running = 0;
+	tracker_cond_broadcast(&w->cond);
+	tracker_mutex_unlock(&w->mutex);
+	tracker_thread_join(w->thread);
+
+	tracker_cond_destroy(&w->cond);
+	tracker_mutex_destroy(&w->mutex);
+	flight_recorder_release(w->copy);
+	flight_recorder_release(w->work);
+	free(w->file);
+	free(w->work_file);
+	free(w);
+}
+
+int flight_recorder_writer_dump(FlightRecorderWriter* w, FlightRecorder* fr, const char* file) {
+	// if the writing thread holds the lock, this dump is skipped
+	if (!tracker_mutex_trylock(&w->mutex))
+		return 0;
+
+	// the file names are swapped between the threads like the copies, they only change if the file does
+	if (w->file == 0x0 || strcmp(w->file, file) != 0) {
+		free(w->file);
+		w->file = (char*) malloc(strlen(file) + 1);
+		strcpy(w->file, file);
+	}
+
+	int copied = flight_recorder_copy(w->copy, fr);
+	if (copied) {
+		w->pending = 1;
+		tracker_cond_signal(&w->cond);
+	}
+	tracker_mutex_unlock(&w->mutex);
+	return copied;
+}
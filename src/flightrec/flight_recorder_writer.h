@@ -0,0 +1,49 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef FLIGHT_RECORDER_WRITER_H_
+#define FLIGHT_RECORDER_WRITER_H_
+
+#include "flight_recorder.h"
+
+/* Opaque data type for the writer */
+struct _FlightRecorderWriter;
+typedef struct _FlightRecorderWriter FlightRecorderWriter;
+
+/*
+ * Writes dumps of a flight recorder on its own thread, so that the thread that records the
+ * events never waits for the file system. A dump is handed over as a copy of the recorder;
+ * handing it over never blocks: if the writer is busy with the previous copy, the copy is
+ * skipped. A copy that has been handed over is written before the writer is released.
+ */
+FlightRecorderWriter* flight_recorder_writer_new(int capacity); // constructor, starts the writing thread (capacity: see flight_recorder_create)
+void flight_recorder_writer_release(FlightRecorderWriter* w); // destructor, writes a pending dump and stops the writing thread
+// hands a copy of the flight recorder over to the writing thread (non-blocking), returns 1 if it will be written to "file"
+int flight_recorder_writer_dump(FlightRecorderWriter* w, FlightRecorder* fr, const char* file);
+
+#endif /* FLIGHT_RECORDER_WRITER_H_ */
@@ -59,9 +59,8 @@ void psmove_trace_clear() {
 	pFile = fopen(TRACE_OUTPUT, "w");
 	if (pFile != NULL) {
 		fputs("originals = new Array();\n", pFile);
-		fputs("rawdiffs = new Array();\n", pFile);
-		fputs("threshdiffs = new Array();\n", pFile);
 		fputs("erodediffs = new Array();\n", pFile);
+		fputs("intersections = new Array();\n", pFile);
 		fputs("finaldiff = new Array();\n", pFile);
 		fputs("filtered = new Array();\n", pFile);
 		fputs("contours = new Array();\n", pFile);
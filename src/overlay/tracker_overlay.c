@@ -0,0 +1,223 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "opencv2/core/core_c.h"
+
+#include "tracker_overlay.h"
+#include "../thread/tracker_thread.h"
+#include "../timer/high_precision_timer.h"
+#include "../tracker/tracker_helpers.h"
+#include "../htmltrace/tracker_trace.h"
+
+#define OVERLAY_LIVE_INTERVAL 1000000000LL // interval in which the overlay is written to the html trace (in ns)
+
+struct _TrackerOverlay {
+	TrackerThread thread; // the rendering thread
+	TrackerMutex mutex; // protects everything below
+	TrackerCond cond; // signals a new snapshot (or the end of the thread)
+	volatile int requested; // a consumer waits for a new overlay
+	int pending; // a snapshot waits to be rendered
+	int fresh; // the output has not been copied yet
+	int running; // 0 if the thread shall end
+	IplImage* frame; // copy of the frame handed over by the tracker
+	TrackerOverlaySnapshot snapshot; // results handed over by the tracker
+	IplImage* work; // the frame that is being rendered (rendering thread only)
+	TrackerOverlaySnapshot work_snapshot; // the results that are being rendered (rendering thread only)
+	IplImage* output; // the latest rendered overlay
+	int64_t last_live; // the monotonic time when the last overlay was written to the html trace (in ns)
+};
+
+void tracker_overlay_main(void* arg) {
+	TrackerOverlay* o = (TrackerOverlay*) arg;
+	IplImage* tmp;
+
+	tracker_mutex_lock(&o->mutex);
+	while (1) {
+		while (o->running && !o->pending)
+			tracker_cond_wait(&o->cond, &o->mutex);
+		if (!o->running)
+			break;
+
+		// take the snapshot, the tracker gets the old buffer for the next one
+		tmp = o->work;
+		o->work = o->frame;
+		o->frame = tmp;
+		o->work_snapshot = o->snapshot;
+		o->pending = 0;
+		tracker_mutex_unlock(&o->mutex);
+
+		tracker_overlay_render(o->work, &o->work_snapshot);
+		int64_t now = hp_timer_now_ns();
+		if (now - o->last_live > OVERLAY_LIVE_INTERVAL) {
+			psmove_html_trace_image(o->work, "livefeed", o->last_live != 0);
+			o->last_live = now;
+		}
+
+		tracker_mutex_lock(&o->mutex);
+		tmp = o->output;
+		o->output = o->work;
+		o->work = tmp;
+		o->fresh = 1;
+	}
+	tracker_mutex_unlock(&o->mutex);
+}
+
+TrackerOverlay* tracker_overlay_new() {
+	TrackerOverlay* o = (TrackerOverlay*) calloc(1, sizeof(TrackerOverlay));
+	o->requested = 0;
+	o->pending = 0;
+	o->fresh = 0;
+	o->running = 1;
+	o->frame = 0x0;
+	o->work = 0x0;
+	o->output = 0x0;
+	o->last_live = 0;
+	tracker_mutex_init(&o->mutex);
+	tracker_cond_init(&o->cond);
+	if (!tracker_thread_create(&o->thread, tracker_overlay_main, o)) {
+		tracker_cond_destroy(&o->cond);
+		tracker_mutex_destroy(&o->mutex);
+		free(o);
+		return 0x0;
+	}
+	return o;
+}
+
+void tracker_overlay_release(TrackerOverlay* o) {
+	if (o == 0x0)
+		return;
+	tracker_mutex_lock(&o->mutex);
+	o->running = 0;
+	tracker_cond_broadcast(&o->cond);
+	tracker_mutex_unlock(&o->mutex);
+	tracker_thread_join(o->thread);
+
+	tracker_cond_destroy(&o->cond);
+	tracker_mutex_destroy(&o->mutex);
+	if (o->frame != 0x0)
+		cvReleaseImage(&o->frame);
+	if (o->work != 0x0)
+		cvReleaseImage(&o->work);
+	if (o->output != 0x0)
+		cvReleaseImage(&o->output);
+	free(o);
+}
+
+int tracker_overlay_is_requested(TrackerOverlay* o) {
+	return o != 0x0 && o->requested;
+}
+
+void tracker_overlay_publish(TrackerOverlay* o, IplImage* frame, TrackerOverlaySnapshot* snapshot) {
+	// if the consumer or the rendering thread holds the lock, the next frame is used instead
+	if (!o->requested || !tracker_mutex_trylock(&o->mutex))
+		return;
+
+	// the buffers are swapped between the threads; they only need to be created once per frame size
+	if (o->frame != 0x0 && (o->frame->width != frame->width || o->frame->height != frame->height))
+		cvReleaseImage(&o->frame);
+	if (o->frame == 0x0)
+		o->frame = cvCreateImage(cvGetSize(frame), frame->depth, frame->nChannels);
+
+	cvCopy(frame, o->frame, 0x0);
+	o->snapshot = *snapshot;
+	o->pending = 1;
+	o->requested = 0;
+	tracker_cond_signal(&o->cond);
+	tracker_mutex_unlock(&o->mutex);
+}
+
+int tracker_overlay_get(TrackerOverlay* o, IplImage* dst) {
+	int copied = 0;
+	tracker_mutex_lock(&o->mutex);
+	o->requested = 1;
+	if (o->fresh && o->output->width == dst->width && o->output->height == dst->height) {
+		cvCopy(o->output, dst, 0x0);
+		o->fresh = 0;
+		copied = 1;
+	}
+	tracker_mutex_unlock(&o->mutex);
+	return copied;
+}
+
+void tracker_overlay_render(IplImage* frame, TrackerOverlaySnapshot* snapshot) {
+	int i;
+	CvPoint p;
+	float textSmall = 0.8;
+	float textNormal = 1;
+	char text[256];
+	CvScalar c;
+	CvScalar avgC;
+	float avgLum = 0;
+	int roi_w = 0;
+	int roi_h = 0;
+
+	// general statistics
+	avgC = cvAvg(frame, 0x0);
+	avgLum = th_avg(avgC.val, 3);
+	cvRectangle(frame, cvPoint(0, 0), cvPoint(frame->width, 25), th_black, CV_FILLED, 8, 0);
+	sprintf(text, "fps:%.0f", snapshot->fps);
+	th_put_text(frame, text, cvPoint(10, 20), th_white, textNormal);
+	sprintf(text, "avg(lum):%.0f", avgLum);
+	th_put_text(frame, text, cvPoint(255, 20), th_white, textNormal);
+
+	// draw all controller information to the image
+	for (i = 0; i < snapshot->controllers; i++) {
+		TrackerOverlayController* tc = &snapshot->controller[i];
+		if (tc->is_tracked) {
+			// controller specific statistics
+			p.x = tc->x;
+			p.y = tc->y;
+			roi_w = tc->roi.width;
+			roi_h = tc->roi.height;
+			c = tc->color;
+
+			cvRectangle(frame, cvPoint(tc->roi.x, tc->roi.y), cvPoint(tc->roi.x + roi_w, tc->roi.y + roi_h), th_white, 3, 8, 0);
+			cvRectangle(frame, cvPoint(tc->roi.x, tc->roi.y), cvPoint(tc->roi.x + roi_w, tc->roi.y + roi_h), th_red, 1, 8, 0);
+			cvRectangle(frame, cvPoint(tc->roi.x, tc->roi.y - 45), cvPoint(tc->roi.x + roi_w, tc->roi.y - 5), th_black, CV_FILLED, 8, 0);
+
+			int vOff = 0;
+			if (roi_h == frame->height)
+				vOff = roi_h;
+			sprintf(text, "RGB:%x,%x,%x", (int) c.val[2], (int) c.val[1], (int) c.val[0]);
+			th_put_text(frame, text, cvPoint(tc->roi.x, tc->roi.y + vOff - 5), c, textSmall);
+
+			sprintf(text, "ROI:%dx%d", roi_w, roi_h);
+			th_put_text(frame, text, cvPoint(tc->roi.x, tc->roi.y + vOff - 15), c, textSmall);
+
+			sprintf(text, "radius: %.2f", tc->r);
+			th_put_text(frame, text, cvPoint(tc->roi.x, tc->roi.y + vOff - 35), c, textSmall);
+			sprintf(text, "dist: %.2fmm", tc->distance);
+			th_put_text(frame, text, cvPoint(tc->roi.x, tc->roi.y + vOff - 25), c, textSmall);
+
+			cvCircle(frame, p, tc->r, th_white, 1, 8, 0);
+		}
+	}
+}
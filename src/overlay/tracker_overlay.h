@@ -0,0 +1,71 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef TRACKER_OVERLAY_H_
+#define TRACKER_OVERLAY_H_
+
+#include "opencv2/core/core_c.h"
+
+#define TRACKER_OVERLAY_MAX_CONTROLLERS 8 // maximum number of controllers in a snapshot
+
+/* The results of a single controller, as needed to draw them */
+typedef struct {
+	int is_tracked; // 1 if the sphere has been found
+	float x, y, r; // position and radius of the sphere
+	CvRect roi; // the region of interest that has been searched
+	CvScalar color; // the estimated color of the sphere (BGR)
+	float distance; // distance of the sphere to the camera (in mm)
+} TrackerOverlayController;
+
+/* The results of one call of psmove_tracker_update */
+typedef struct {
+	float fps; // the rate at which frames can be processed
+	int controllers; // number of valid entries in "controller"
+	TrackerOverlayController controller[TRACKER_OVERLAY_MAX_CONTROLLERS];
+} TrackerOverlaySnapshot;
+
+/* Opaque data type for the overlay */
+struct _TrackerOverlay;
+typedef struct _TrackerOverlay TrackerOverlay;
+
+/*
+ * The overlay renders the tracking results on a copy of the frame on its own thread.
+ * The tracker only hands over a snapshot if a consumer has asked for an overlay, and
+ * handing it over never blocks: if the overlay is busy, the snapshot is skipped.
+ */
+TrackerOverlay* tracker_overlay_new(); // constructor, starts the rendering thread
+void tracker_overlay_release(TrackerOverlay* o); // destructor, stops the rendering thread
+int tracker_overlay_is_requested(TrackerOverlay* o); // 1 if a consumer waits for a new overlay
+// hands a copy of the frame and the results over to the rendering thread (non-blocking)
+void tracker_overlay_publish(TrackerOverlay* o, IplImage* frame, TrackerOverlaySnapshot* snapshot);
+// asks for a new overlay and copies the latest one into "dst", returns 1 if it has not been copied before
+int tracker_overlay_get(TrackerOverlay* o, IplImage* dst);
+// draws the results into the given frame
+void tracker_overlay_render(IplImage* frame, TrackerOverlaySnapshot* snapshot);
+
+#endif /* TRACKER_OVERLAY_H_ */
@@ -30,34 +30,59 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <time.h>
+#include <string.h>
+#include <stddef.h>
 
 #include "opencv2/core/core_c.h"
 #include "opencv2/imgproc/imgproc_c.h"
 
 #include "psmove_tracker.h"
 #include "timer/high_precision_timer.h"
+#include "timer/stage_profiler.h"
 #include "camera/camera_control.h"
+#include "camera/frame_grabber.h"
+#include "camera/exposure_control.h"
 #include "tracker/tracker_helpers.h"
+#include "tracker/color_conversion.h"
 #include "tracker/tracked_controller.h"
 #include "tracker/tracked_color.h"
+#include "tracker/stripe_search.h"
+#include "tracker/image_arena.h"
+#include "tracker/calibration_mask.h"
+#include "tracker/bit_mask.h"
+#include "tracker/decimated_mask.h"
+#include "thread/tracker_pool.h"
+#include "thread/tracker_seqlock.h"
 #include "htmltrace/tracker_trace.h"
+#include "flightrec/flight_recorder.h"
+#include "flightrec/flight_recorder_writer.h"
+#include "overlay/tracker_overlay.h"
+#include "shm/tracker_shm.h"
+#include "stream/tracker_stream.h"
+#include "event/tracker_events.h"
 
-#define PRINT_DEBUG_STATS			// shall graphical statistics be printed to the image
 #define GOOD_EXPOSURE 2051			// a very low exposure that was found to be good for tracking
+#define EXPOSURE_CONTROL 1			// 1: the exposure is adapted continuously to the lighting, starting at GOOD_EXPOSURE, 0: GOOD_EXPOSURE is kept
+#define EXPOSURE_TARGET 25			// the luminance of the background the exposure control aims for
+#define EXPOSURE_MIN 2051			// the range of exposures the exposure control may choose from
+#define EXPOSURE_MAX 4051
+#define CAPTURE_LATEST_FRAME 1		// 1: the camera is read on its own thread and only the newest frame is tracked, 0: all frames are read in order
+#define CAMERA_RAW_BAYER 0			// 1: the camera is asked for its raw Bayer mosaic, each 2x2 quad is one pixel of a half resolution frame (no demosaicing)
 #define ROIS 6                   	// the number of levels of regions of interest (roi)
 #define BLINKS 4                 	// number of diff images to create during calibration
 #define BLINK_DELAY 50             	// number of milliseconds to wait between a blink
 #define CALIB_MIN_SIZE 50		 	// minimum size of the estimated glowing sphere during calibration process (in pixel)
 #define CALIB_SIZE_STD 10	     	// maximum standard deviation (in %) of the glowing spheres found during calibration process
 #define CALIB_MAX_DIST 30		 	// maximum displacement of the separate found blobs
+#define REFERENCE_WIDTH 640			// the frame width all thresholds in pixels are given for, they are scaled to the width of the camera's frames
 #define COLOR_FILTER_RANGE_H 5		// +- H-Range of the hsv-colorfilter
 #define COLOR_FILTER_RANGE_S 85		// +- s-Range of the hsv-colorfilter
 #define COLOR_FILTER_RANGE_V 85		// +- v-Range of the hsv-colorfilter
 #define CAMERA_FOCAL_LENGTH 28.3	// focal lenght constant of the ps-eye camera in (degrees)
 #define CAMERA_PIXEL_HEIGHT 5		// pixel height constant of the ps-eye camera in (m)
 #define PS_MOVE_DIAMETER 47			// orb diameter constant of the ps-move controller in (mm)
+#define UNDISTORT_FRAMES 0			// remove the lens distortion of every frame (0 = only the centers of the spheres are undistorted for their camera space positions)
 /* Thresholds */
-#define ROI_ADJUST_FPS_T 160		// the minimum fps to be reached, if a better roi-center adjusment is to be perfomred
 #define CALIBRATION_DIFF_T 20		// during calibration, all grey values in the diff image below this value are set to black
 // if tracker thresholds not met, sphere is deemed not to be found
 #define TRACKER_QUALITY_T1 0.3		// minimum ratio of number of pixels in blob vs pixel of estimated circle.
@@ -65,40 +90,118 @@
 #define TRACKER_QUALITY_T3 4		// minimum radius
 #define TRACKER_ADAPTIVE_XY 1		// specifies to use a adaptive x/y smoothing
 #define TRACKER_ADAPTIVE_Z 1		// specifies to use a adaptive z smoothing
+#define REACQUIRE_DECIMATION 4		// a lost sphere is searched on every x-th pixel of every x-th row first (1 = search the ROI levels instead)
+#define REACQUIRE_TILES 4			// number of horizontal bands the decimated frame is split into, one band is searched at a time
+#define REACQUIRE_BUDGET 1000		// time per frame that may be spent on searching lost spheres (in micro-seconds)
+#define REACQUIRE_CANDIDATES 3		// number of blobs of a tile (the biggest ones) that are checked at full resolution, until one is the sphere
+#define FULL_SEARCH_THREADS 0		// number of threads that search the whole frame in parallel stripes (0 = one per CPU, 1 = no parallel search)
+#define ROI_DECIMATION_MAX 4		// the ROI of a big sphere is classified on every 2nd or 4th pixel, only its edge at full resolution (1 = always full resolution)
+#define ROI_DECIMATION_RADIUS 12	// minimum expected radius of the sphere at the decimated resolution (in pixel)
 #define COLOR_ADAPTION_QUALITY 35 	// maximal distance between the first estimated color and the newly estimated
-#define COLOR_UPDATE_RATE 1	 	 	// every x seconds adapt to the color, 0 means no adaption
+#define COLOR_ADAPTION_RATE 0.05	// weight of the current frame in the exponentially weighted color estimation, 0 means no adaption
 // if color thresholds not met, color is not adapted
 #define COLOR_UPDATE_QUALITY_T1 0.8	// minimum ratio of number of pixels in blob vs pixel of estimated circle.
 #define COLOR_UPDATE_QUALITY_T2 0.2	// maximum allowed change of the radius in percent, compared to the last estimated radius
 #define COLOR_UPDATE_QUALITY_T3 6	// minimum radius
+#define FLIGHT_RECORDER_EVENTS FLIGHT_RECORDER_DEFAULT_SIZE	// number of events kept by the flight recorder
+#define FLIGHT_RECORDER_DUMP_INTERVAL 1	// minimum number of seconds between two automatic dumps on tracking loss
+#define SNAPSHOT_MAX_CONTROLLERS 8	// maximum number of controllers returned by psmove_tracker_get_snapshot
+#define PROFILER_CONTROLLERS 8		// number of controllers whose stages are profiled (and recorded by the flight recorder) separately
+#define ARENA_HUGE_PAGES 1			// ask the OS to back the image arena with huge pages (if supported)
+#define FRAME_SOURCE_ATTEMPTS 100	// number of calls after which a frame source that delivered no frame is given up
 #ifdef WIN32
 #define PSEYE_BACKUP_FILE "PSEye_backup_win.ini"
 #else
 #define PSEYE_BACKUP_FILE "PSEye_backup_v4l.ini"
 #endif
+
+// statistics of the pixels of a blob, see psmove_tracker_blob_statistics
+typedef struct {
+	int pixels; // number of pixels of the blob (moment m00)
+	double sx, sy; // sums of the x/y coordinates of its pixels (moments m10/m01)
+	double sbgr[3]; // sums of the colors of its pixels in the frame (BGR)
+} PSMoveTrackerBlobStats;
+
+// the results of all controllers after an update, guarded by a sequence lock (see thread/tracker_seqlock.h)
+typedef struct {
+	unsigned int frame; // number of the frame the results belong to
+	int64_t timestamp; // the monotonic time when that frame has been taken (in ns)
+	int controllers; // number of valid elements in "controller"
+	PSMoveTrackerControllerState controller[SNAPSHOT_MAX_CONTROLLERS];
+} PSMoveTrackerSnapshot;
+
 struct _PSMoveTracker {
 	CameraControl* cc;
+	FrameGrabber* grabber; // reads the camera on its own thread (NULL = the camera is read on the tracker's thread)
+	PSMoveTrackerFrameSource source; // if set, frames are read from this function instead of the camera
+	void* source_data; // user data passed to "source"
 	IplImage* frame; // the current frame of the camera
 	int exposure; // the exposure to use
+	ExposureControl* exposure_control; // adapts the exposure to the lighting (NULL = the exposure is fixed)
+	int capture_latest_frame; // should the camera be read on its own thread, dropping frames that are not tracked in time
+	int raw_bayer; // should the frames be packed from the raw Bayer mosaic of the camera (if the driver supports it)
 	IplImage* roiI[ROIS]; // array of images for each level of roi (colored)
-	IplImage* roiM[ROIS]; // array of images for each level of roi (greyscale)
-	IplConvKernel* kCalib; // kernel used for morphological operations during calibration
+	BitMask roiM[ROIS]; // array of masks for each level of roi
+	BitMask decM; // the color filtered ROI at a decimated resolution (1 pixel per cell of the ROI)
+	BitMask decI, decO; // the cells of decM whose neighbours are all set (interior) / of which one is set (interior and edge)
+	BitMask decT; // scratch mask of the morphological operations on decM
+	IplImage* roiS[ROIS]; // array of scratch images for each level of roi (greyscale), used to trace the contour of a blob of roiM
+	IplImage* coarseM; // color filtered, decimated frame used to reacquire lost spheres (greyscale)
+	IplImage* calib_images[BLINKS]; // frames with the lit sphere, taken during calibration (colored)
+	BitMask calib_mask; // intersection of the diffs between the lit and unlit sphere of all blinks
+	BitMask calib_blink; // diff of the current blink alone, for debugging
+	BitMask calib_tmp; // scratch mask of the morphological operations during calibration
+	BitMask calib_rows; // scratch rows of calibration_mask_fold
+	IplImage* calib_trace; // the masks of the calibration, converted for the html trace (greyscale)
+	ImageArena* arena; // the single allocation all images and masks above are taken from
+	BitMaskBlobs* blobs; // labels the blobs of the ROI and calibration masks
+	TrackerPool* pool; // threads used to search the whole frame in parallel
+	StripeSearch* stripes; // filters the whole frame in parallel stripes (NULL = on the tracker's thread only)
 	CvScalar rHSV; // the range of the color filter
 	TrackedController* controllers; // a pointer to a linked list of connected controllers
 	PSMoveTrackingColor* available_colors; // a pointer to a linked list of available tracking colors
 	CvMemStorage* storage; // use to store the result of cvFindContour and cvHughCircles
 	HPTimer* timer; // pointer to a high-precision timer used for internal calculation and debugging purposes
+	StageProfiler* profiler; // per stage timing of every controller (in the controller's slot) and of the stages per frame
+	int frame_slot; // the profiler slot of the stages per frame, it follows the slots of the controllers
+	int64_t created_ns; // monotonic time of the creation, used to timestamp flight recorder events
+	FlightRecorder* recorder; // always-on ring buffer of per frame/controller tracking events
+	char* recorder_dump_file; // if set, the flight recorder is dumped to this file whenever a controller is lost
+	FlightRecorderWriter* recorder_writer; // writes the automatic dumps on its own thread (only while recorder_dump_file is set)
+	int64_t recorder_last_dump; // the monotonic time when the flight recorder was automatically dumped the last time (in ns)
+	unsigned int frame_no; // number of frames processed by "psmove_tracker_update"
+	TrackerOverlay* overlay; // renders the tracking results on its own thread, created on the first request
+	int64_t frame_ns; // the monotonic time when the current frame has been taken from the camera (in ns)
+	TrackerShm* shm; // publishes the results of every frame to other processes (NULL = disabled)
+	TrackerShmFrame shm_frame; // the results that have been published last
+	TrackerStream* stream; // streams the results of every frame to another process (NULL = disabled)
+	TrackerEvents* events; // delivers found/lost/calibrated/color events to callbacks and the event queue
+	volatile uint32_t snapshot_sequence; // the sequence lock of "snapshot", only psmove_tracker_update writes it
+	PSMoveTrackerSnapshot snapshot; // the results of the last update, readable from other threads
 
 	// internal variables
 	float cam_focal_length; // in (mm)
 	float cam_pixel_height; // in (m)
 	float ps_move_diameter; // in (mm)
 	float user_factor_dist; // user defined factor used in distance calulation
+	int undistort_frames; // remove the lens distortion of every frame, instead of just the centers of the spheres
+	float fx, fy; // focal length of the camera (in pixels), from the calibration or from the constants above
+	float cx, cy; // principal point of the camera (in pixels)
+	CvMat* intrinsic; // camera matrix used to undistort the centers of the spheres (NULL = no calibration, or the frames are undistorted already)
+	CvMat* distortion; // distortion coefficients belonging to "intrinsic"
 
 	int tracker_adaptive_xy; // should adaptive x/y-smoothing be used
 	int tracker_adaptive_z; // should adaptive z-smoothing be used
+	int reacquire_decimation; // decimation of the frame when searching for lost spheres (1 = no decimated search)
+	int reacquire_budget; // time per frame that may be spent on searching lost spheres (in micro-seconds)
+	unsigned int reacquire_next; // rotates the lost controller that is served first by the reacquisition scheduler
+	int full_search_threads; // number of threads that search the whole frame (0 = one per CPU, 1 = no parallel search)
+	int roi_decimation_max; // maximum decimation of the ROI of a big sphere (1 = always full resolution)
+	int roi_decimation_radius; // minimum expected radius of the sphere at the decimated resolution (in pixel)
 
 	int calibration_t;
+	float calib_min_size; // minimum size of the glowing sphere during calibration (in pixels)
+	float calib_max_dist; // maximum displacement of the blobs found during calibration (in pixels)
 
 	// if one is not met, the tracker is regarded as not found (although something has been found)
 	float tracker_t1; // quality threshold1 for the tracker
@@ -111,11 +214,10 @@ struct _PSMoveTracker {
 	float color_t1; // quality threshold3 for the color adaption
 	float color_t2; // quality threshold3 for the color adaption
 	float color_t3; // quality threshold3 for the color adaption
-	float color_update_rate; // how often shall the color be adapted (in seconds), 0 means never
+	float color_adaption_rate; // weight of the current frame in the estimated color (0 means never adapt)
 
 	// internal variables (debug)
 	float debug_fps; // the current FPS achieved by "psmove_tracker_update"
-	time_t debug_last_live; // the timesamp when the last live-image was written to the file-system
 
 };
 
@@ -125,35 +227,20 @@ struct _PSMoveTracker {
 #define tracker_CRITICAL(x) \
         {fprintf(stderr, "[TRACKER] Assertion fail in %s: %s\n", __func__, x);}
 
-/**
- * Adapts the cameras exposure to the current lighting conditions
- * This function will adapt to the most suitable exposure, it will start
- * with "expMin" and increases step by step to "expMax" until it reaches "lumMin" or "expMax"
- *
- * tracker - A valid PSMoveTracker * instance
- * limMin  - Minimal luminance to reach
- * expMin  - Minimal exposure to test
- * expMax  - Maximal exposure to test
- *
- * Returns: the most suitable exposure within range
- **/
-int psmove_tracker_adapt_to_light(PSMoveTracker *tracker, int lumMin, int expMin, int expMax);
-
 /**
  * This function switches the sphere of the given PSMove on to the given color and takes
- * a picture via the given capture. Then it switches it of and takes a picture again. A difference image
- * is calculated from these two images. It stores the image of the lit sphere and
- * of the diff-image in the passed parameter "on" and "diff". Before taking
- * a picture it waits for the specified delay (in microseconds).
+ * a picture via the given capture. Then it switches it of and takes a picture again.
+ * It stores the image of the lit sphere in the passed parameter "on" and returns the
+ * image of the unlit sphere (the current frame of the tracker, valid until the next frame
+ * is queried). Before taking a picture it waits for the specified delay (in microseconds).
  *
  * tracker - the tracker that contains the camera control
  * move    - the PSMove controller to use
  * r,g,b   - the RGB color to use to lit the sphere
  * on	   - the pre-allocated image to store the captured image when the sphere is lit
- * diff    - the pre-allocated image to store the calculated diff-image
  * delay   - the time to wait before taking a picture (in microseconds)
  **/
-void psmove_tracker_get_diff(PSMoveTracker* tracker, PSMove* move, int r, int g, int b, IplImage* on, IplImage* diff, int delay);
+IplImage* psmove_tracker_get_blink(PSMoveTracker* tracker, PSMove* move, int r, int g, int b, IplImage* on, int delay);
 
 /**
  * This function assures thate the roi (region of interest) is always within the bounds
@@ -178,11 +265,46 @@ void psmove_tracker_prepare_colors(PSMoveTracker* tracker);
 int psmove_tracker_update_controller(PSMoveTracker* tracker, TrackedController* tc, float* q1, float* q2, float* q3);
 
 /**
- * This draws tracking statistics into the current camera image. This is only used internally.
+ * Hands a copy of the current camera image and the tracking results over to the overlay,
+ * but only if someone asked for a new overlay. This is only used internally.
  *
  * tracker - the Tracker to use
  */
-void psmove_tracker_draw_tracking_stats(PSMoveTracker* tracker);
+void psmove_tracker_publish_overlay(PSMoveTracker* tracker);
+
+/*
+ * Writes the results of the controllers that have just been updated into the shared
+ * memory segment. The results of the other controllers are published unchanged.
+ *
+ * tracker	- the Tracker to use
+ * move		- the controller that has been updated, or NULL if all have been updated
+ */
+void psmove_tracker_publish_shm(PSMoveTracker* tracker, PSMove* move);
+
+/*
+ * Appends the results of all controllers to the stream (which sends them once a batch is complete).
+ *
+ * tracker	- the Tracker to use
+ */
+void psmove_tracker_publish_stream(PSMoveTracker* tracker);
+
+/*
+ * Copies the results of all controllers to the snapshot read by psmove_tracker_get_snapshot.
+ * The sequence lock allows a single writer only, so this is only called by psmove_tracker_update.
+ *
+ * tracker	- the Tracker to use
+ */
+void psmove_tracker_publish_snapshot(PSMoveTracker* tracker);
+
+/*
+ * Calculates the metric position of the sphere's center in camera space (x right, y down,
+ * z forward; in mm) from its position and radius in the image. If the frames are not
+ * undistorted, only the center of the sphere is.
+ *
+ * t	- (in) The PSMoveTracker to use.
+ * tc	- (in) The controller whose sphere has just been found.
+ */
+void psmove_tracker_update_camera_position(PSMoveTracker* t, TrackedController* tc);
 
 /*
  *  This finds the biggest contour within the given image.
@@ -227,20 +349,233 @@ float psmove_tracker_hsvcolor_diff(TrackedController* tc);
 void psmove_tracker_estimate_3d_pos(CvSeq* cont, CvPoint* center, float* radius);
 
 /*
- * This function return a optimal ROI center point for a given Tracked controller.
+ * Converts a rectangle of the controller's current ROI to HSV and applies the color filter to it.
+ * The result is written to the same rectangle of the ROI's mask (roiM).
+ *
+ * t		- (in) The PSMoveTracker to use.
+ * tc		- (in) The controller whose ROI should be filtered.
+ * rect		- (in) The rectangle to filter, relative to the ROI.
+ * min, max	- (in) The bounds of the color filter (HSV).
+ */
+void psmove_tracker_filter_roi(PSMoveTracker* t, TrackedController* tc, CvRect rect, CvScalar min, CvScalar max);
+
+/*
+ * Chooses the resolution the controller's ROI is classified at: the biggest decimation (a power
+ * of 2, up to roi_decimation_max) at which the radius of the last frame is still at least
+ * roi_decimation_radius pixels. Spheres that are not tracked are always searched at full resolution.
+ *
+ * Returns: the decimation (1 = full resolution)
+ */
+int psmove_tracker_roi_decimation(PSMoveTracker* t, TrackedController* tc);
+
+/*
+ * Applies the color filter to the controller's current ROI at a decimated resolution (see
+ * decimated_mask.h): decM holds the classification of the cells, roiM receives the mask of
+ * the ROI. Holes in the sphere that are smaller than a cell are filled.
+ *
+ * t		- (in) The PSMoveTracker to use.
+ * tc		- (in) The controller whose ROI should be filtered.
+ * d		- (in) The decimation (2 or 4).
+ * min, max	- (in) The bounds of the color filter (HSV).
+ */
+void psmove_tracker_filter_roi_decimated(PSMoveTracker* t, TrackedController* tc, int d, CvScalar min, CvScalar max);
+
+/*
+ * Finds the biggest blob in the mask of the controller's current ROI. The blobs are labelled
+ * on the bit mask, only the contours of the blobs that may be bigger than the biggest one
+ * found so far are traced (on roiS, of which only the bounding box of the blob is used).
+ *
+ * Returns: the contour of the biggest blob or NULL
+ */
+CvSeq* psmove_tracker_find_blob(PSMoveTracker* t, TrackedController* tc);
+
+/*
+ * Applies the color filter to the whole frame, like psmove_tracker_filter_roi does for
+ * ROI level 0, but the frame is processed in parallel stripes (see stripe_search.h).
+ *
+ * t		- (in) The PSMoveTracker to use.
+ * min, max	- (in) The bounds of the color filter (HSV).
+ */
+void psmove_tracker_filter_in_stripes(PSMoveTracker* t, CvScalar min, CvScalar max);
+
+/*
  * On very fast movements, it may happen that the orb is visible in the ROI, but resides
- * at its border. This function will simply look for the biggest blob in the ROI and return a
- * point so that that blob would be in the center of the ROI.
+ * at its border. This function moves the ROI so that the blob is in its center. The part of
+ * the mask that is still covered by the moved ROI is kept, only the newly uncovered pixels
+ * are filtered.
+ *
+ * tc		- (in) The controller whose ROI should be adjusted.
+ * t		- (in) The PSMoveTracker to use.
+ * blob		- (in) The bounding rectangle of the blob, relative to the ROI.
+ * min, max	- (in) The bounds of the color filter (HSV).
+ *
+ * Returns: 1 if the ROI has been moved, 0 otherwise
+ */
+int psmove_tracker_center_roi_on_blob(TrackedController* tc, PSMoveTracker* t, CvRect blob, CvScalar min, CvScalar max);
+
+/*
+ * Searches a lost sphere in one tile (a horizontal band) of a decimated version of the
+ * frame: only every "reacquire_decimation"-th pixel of every "reacquire_decimation"-th row
+ * is converted to HSV and tested against the color filter. The biggest blobs are the
+ * candidates for the sphere; a distractor of the same color may be bigger than the sphere,
+ * so more than one is returned.
  *
- * tc - (in) The controller whose ROI centerpoint should be adjusted.
- * t  - (in) The PSMoveTracker to use.
+ * t			- (in) The PSMoveTracker to use.
+ * tile			- (in) The index of the tile to search (0 .. REACQUIRE_TILES - 1).
+ * min, max		- (in) The bounds of the color filter (HSV).
+ * candidates	- (out) The bounding rectangles of up to REACQUIRE_CANDIDATES blobs in the
+ * 				  decimated frame, the biggest one first.
  *
- * Returns: a better center point for the current ROI.
+ * Returns: the number of candidates
  */
-CvPoint psmove_tracker_better_roi_center(TrackedController* tc, PSMoveTracker* t);
+int psmove_tracker_reacquire(PSMoveTracker* t, int tile, CvScalar min, CvScalar max, CvRect* candidates);
+
+/*
+ * Places the ROI of a lost controller on a candidate of psmove_tracker_reacquire, so that
+ * the sphere can be measured at full resolution. The ROI is big enough for the blob and its
+ * surroundings, so a blob that is cut by the border of the tile is completed.
+ *
+ * tc			- (in) The controller to search for.
+ * t			- (in) The PSMoveTracker to use.
+ * candidate	- (in) The bounding rectangle of the blob in the decimated frame.
+ */
+void psmove_tracker_place_roi_on_candidate(TrackedController* tc, PSMoveTracker* t, CvRect candidate);
+
+/*
+ * Searches all lost controllers (those marked with "reacquire_pending") within the time
+ * budget of the frame. Each controller searches one tile after the other, starting where
+ * it has stopped in the previous frame, until the sphere is found or the budget is used
+ * up. The candidates of a tile are checked at full resolution, the biggest first, until one
+ * of them is the sphere. The controller that is served first changes every frame, so that none starves.
+ * The budget is checked before each tile, so it is exceeded by one tile at most; at least
+ * one tile is searched per frame, so that lost spheres are found eventually.
+ *
+ * t		- (in) The PSMoveTracker to use.
+ * n_lost	- (in) The number of controllers marked with "reacquire_pending".
+ *
+ * Returns: the number of spheres that have been found again
+ */
+int psmove_tracker_schedule_reacquisition(PSMoveTracker* t, int n_lost);
+
+/*
+ * Gathers the statistics of a blob in a single pass over its mask: the number of pixels, the
+ * sums of their coordinates (the image moments m00, m10 and m01) and the sums of their colors.
+ *
+ * mask		- (in) The mask containing only the blob.
+ * frame	- (in) The frame, its ROI set to the area covered by the mask.
+ * br		- (in) The bounding rectangle of the blob within the mask.
+ * stats	- (out) The statistics of the blob.
+ */
+void psmove_tracker_blob_statistics(IplImage* mask, IplImage* frame, CvRect br, PSMoveTrackerBlobStats* stats);
+
+/*
+ * Writes a mask of the calibration to the html trace (converted to an image in calib_trace).
+ */
+void psmove_tracker_trace_mask(PSMoveTracker* t, BitMask* mask, int index, char* target);
 
 int psmove_tracker_old_color_is_tracked(PSMoveTracker* t, PSMove* move, int r, int g, int b);
 
+/*
+ * The implementation of psmove_tracker_enable_with_color, which runs while the exposure control is paused.
+ */
+enum PSMoveTracker_Status psmove_tracker_calibrate_color(PSMoveTracker *tracker, PSMove *move, unsigned char r, unsigned char g, unsigned char b);
+
+/*
+ * Appends an event of the given controller to the flight recorder of the tracker.
+ *
+ * t 		- (in) the PSMoveTracker to use
+ * tc 		- (in) the controller the event belongs to
+ * type 	- (in) one of FlightRecorder_EventType
+ * q1,q2,q3	- (in) the quality indicators of the tracker (or 0)
+ * nanos	- (in) the time spent on the controller (in nano-seconds)
+ */
+void psmove_tracker_record_event(PSMoveTracker* t, TrackedController* tc, int type, float q1, float q2, float q3, int64_t nanos);
+
+/*
+ * Returns the index of the controller within the tracker's list of controllers
+ * or -1 if it is not part of the list (e.g. during calibration).
+ */
+int psmove_tracker_controller_index(PSMoveTracker* t, TrackedController* tc);
+
+/*
+ * Gives a newly enabled controller the first profiler slot that no other controller uses, and
+ * forgets the timings of the slot's previous owner. The slot stays the same until the controller
+ * is disabled, then it is free again. If all PROFILER_CONTROLLERS slots are taken, the controller
+ * gets none (-1) and is neither profiled nor told apart by the flight recorder.
+ */
+void psmove_tracker_assign_slot(PSMoveTracker* t, TrackedController* tc);
+
+/*
+ * Delivers an event of the given controller to the subscribers and the event queue.
+ * Nothing happens, if nobody listens or the controller is not part of the list (e.g. during calibration).
+ *
+ * t 		- (in) the PSMoveTracker to use
+ * tc 		- (in) the controller the event belongs to
+ * type 	- (in) one of PSMoveTracker_Event
+ * timestamp- (in) the monotonic time of the event (in nano-seconds)
+ */
+void psmove_tracker_emit_event(PSMoveTracker* t, TrackedController* tc, enum PSMoveTracker_Event type, int64_t timestamp);
+
+/*
+ * Emits the events for the change of the tracking state of a controller after it has been updated.
+ *
+ * t 			- (in) the PSMoveTracker to use
+ * tc 			- (in) the controller that has been updated
+ * was_tracked	- (in) 1 if the sphere has been tracked in the previous frame
+ * found		- (in) 1 if the sphere has been found in the current frame
+ */
+void psmove_tracker_emit_transition(PSMoveTracker* t, TrackedController* tc, int was_tracked, int found);
+
+/*
+ * Returns: the exposure the camera is set to (the one of the exposure control, if enabled)
+ */
+int psmove_tracker_current_exposure(PSMoveTracker* t);
+
+/*
+ * Rescales the first estimated color of a controller to another exposure, assuming that the
+ * brightness of the sphere is proportional to the exposure (like the exposure control does).
+ * Otherwise the reset of the estimated color (see COLOR_ADAPTION_QUALITY) would return to the
+ * brightness of the calibration, long after the exposure has been changed.
+ * The color is always derived from the calibrated one (cFColor at cExposure), so that
+ * channels clamped at a long exposure are restored once the exposure gets shorter again.
+ *
+ * tc		- (in) The controller whose color should be rescaled.
+ * exposure	- (in) The exposure the color should belong to.
+ */
+void psmove_tracker_rebase_color(TrackedController* tc, int exposure);
+
+/*
+ * Saves the first estimated colors of all controllers for the next start of the tracker,
+ * rescaled to the exposure the tracker starts with. Nothing is saved for frame sources.
+ */
+void psmove_tracker_save_colors(PSMoveTracker* t);
+
+/*
+ * Allocates a new tracker and initializes all parameters with their defaults.
+ * This does neither open a camera, nor prepare the ROI data structures.
+ */
+PSMoveTracker* psmove_tracker_create();
+
+/*
+ * Queries frames until the first valid one arrives and prepares the
+ * ROI data structures according to its size.
+ */
+int psmove_tracker_setup_rois(PSMoveTracker* t);
+
+/*
+ * Takes all images and masks of the tracker, sized for "frame", from the arena "a". With a
+ * NULL arena nothing is allocated (the pointers are set to NULL), which yields the capacity
+ * the arena needs.
+ *
+ * Returns: the number of bytes the allocations take in the arena
+ */
+size_t psmove_tracker_allocate_images(PSMoveTracker* t, ImageArena* a, IplImage* frame);
+
+/*
+ * Returns the next frame of the camera or of the frame source (if set).
+ */
+IplImage* psmove_tracker_query_frame(PSMoveTracker* t);
+
 // -------- END: internal functions only
 
 PSMoveTracker *psmove_tracker_new() {
@@ -249,73 +584,226 @@ PSMoveTracker *psmove_tracker_new() {
 
 PSMoveTracker *
 psmove_tracker_new_with_camera(int camera) {
-	int i = 0;
+	return psmove_tracker_new_with_camera_mode(camera, CAMERA_CONTROL_DEFAULT_WIDTH, CAMERA_CONTROL_DEFAULT_HEIGHT, CAMERA_CONTROL_DEFAULT_FPS);
+}
+
+PSMoveTracker *
+psmove_tracker_new_with_camera_mode(int camera, int width, int height, int fps) {
+	PSMoveTracker* t = psmove_tracker_create();
+
+	// start the video capture device for tracking
+	t->cc = camera_control_new_with_mode(camera, width, height, fps, t->raw_bayer);
+	camera_control_set_undistort_frames(t->cc, t->undistort_frames);
+	camera_control_read_calibration(t->cc, "Intrinsics.xml", "Distortion.xml");
+
+	// start with a static exposure, the exposure control (if enabled) adapts it while tracking
+	t->exposure = GOOD_EXPOSURE;
+
+	// backup the systems settings, if not already backuped
+	if (th_file_exists(PSEYE_BACKUP_FILE) == 0)
+		camera_control_backup_sytem_settings(t->cc, PSEYE_BACKUP_FILE);
+
+	camera_control_set_parameters(t->cc, 0, 0, 0, t->exposure, 0, 0xffff, 0xffff, 0xffff, -1, -1);
+	if (EXPOSURE_CONTROL)
+		t->exposure_control = exposure_control_new(t->cc, t->exposure, EXPOSURE_MIN, EXPOSURE_MAX, EXPOSURE_TARGET);
+
+	// frames that queue up in the driver add latency, drop them instead
+	if (t->capture_latest_frame)
+		t->grabber = frame_grabber_new(t->cc, t->exposure_control);
+
+	psmove_tracker_setup_rois(t);
+	return t;
+}
+
+PSMoveTracker *
+psmove_tracker_new_with_frame_source(PSMoveTrackerFrameSource source, void* user_data) {
+	PSMoveTracker* t = psmove_tracker_create();
+	t->source = source;
+	t->source_data = user_data;
+	if (!psmove_tracker_setup_rois(t)) {
+		psmove_tracker_free(t);
+		free(t);
+		return 0x0;
+	}
+	return t;
+}
+
+PSMoveTracker* psmove_tracker_create() {
 	PSMoveTracker* t = (PSMoveTracker*) calloc(1, sizeof(PSMoveTracker));
+	t->cc = 0x0;
+	t->grabber = 0x0;
+	t->exposure_control = 0x0;
+	t->capture_latest_frame = CAPTURE_LATEST_FRAME;
+	t->raw_bayer = CAMERA_RAW_BAYER;
+	t->source = 0x0;
+	t->source_data = 0x0;
 	t->controllers = 0x0;
 	t->rHSV = cvScalar(COLOR_FILTER_RANGE_H, COLOR_FILTER_RANGE_S, COLOR_FILTER_RANGE_V, 0);
 	t->timer = hp_timer_create();
+	t->frame_slot = PROFILER_CONTROLLERS;
+	t->profiler = stage_profiler_create(PROFILER_CONTROLLERS + 1, Tracker_STAGE_COUNT);
+	t->created_ns = hp_timer_now_ns();
+	t->recorder = flight_recorder_create(FLIGHT_RECORDER_EVENTS);
+	t->recorder_dump_file = 0x0;
+	t->recorder_writer = 0x0;
+	t->recorder_last_dump = 0;
+	t->frame_no = 0;
 	t->debug_fps = 0;
-	t->debug_last_live = 0;
+	t->overlay = 0x0;
+	t->frame_ns = 0;
+	t->shm = 0x0;
+	t->stream = 0x0;
+	t->events = tracker_events_new();
 	t->storage = cvCreateMemStorage(0);
 
 	t->cam_focal_length = CAMERA_FOCAL_LENGTH;
 	t->cam_pixel_height = CAMERA_PIXEL_HEIGHT;
 	t->ps_move_diameter = PS_MOVE_DIAMETER;
 	t->user_factor_dist = 1.05;
+	t->undistort_frames = UNDISTORT_FRAMES;
+	t->intrinsic = 0x0;
+	t->distortion = 0x0;
 
 	t->calibration_t = CALIBRATION_DIFF_T;
+	t->calib_min_size = CALIB_MIN_SIZE;
+	t->calib_max_dist = CALIB_MAX_DIST;
 	t->tracker_t1 = TRACKER_QUALITY_T1;
 	t->tracker_t2 = TRACKER_QUALITY_T2;
 	t->tracker_t3 = TRACKER_QUALITY_T3;
 	t->tracker_adaptive_xy = TRACKER_ADAPTIVE_XY;
 	t->tracker_adaptive_z = TRACKER_ADAPTIVE_Z;
+	t->reacquire_decimation = REACQUIRE_DECIMATION;
+	t->reacquire_budget = REACQUIRE_BUDGET;
+	t->reacquire_next = 0;
+	t->full_search_threads = FULL_SEARCH_THREADS;
+	t->roi_decimation_max = ROI_DECIMATION_MAX;
+	t->roi_decimation_radius = ROI_DECIMATION_RADIUS;
+	t->pool = 0x0;
+	t->stripes = 0x0;
 	t->adapt_t1 = COLOR_ADAPTION_QUALITY;
 	t->color_t1 = COLOR_UPDATE_QUALITY_T1;
 	t->color_t2 = COLOR_UPDATE_QUALITY_T2;
 	t->color_t3 = COLOR_UPDATE_QUALITY_T3;
-	t->color_update_rate = COLOR_UPDATE_RATE;
+	t->color_adaption_rate = COLOR_ADAPTION_RATE;
 	// prepare available colors for tracking
 	psmove_tracker_prepare_colors(t);
+	return t;
+}
 
-	// start the video capture device for tracking
-	t->cc = camera_control_new(camera);
-	camera_control_read_calibration(t->cc, "Intrinsics.xml", "Distortion.xml");
+IplImage* psmove_tracker_arena_image(ImageArena* a, size_t* bytes, CvSize size, int depth, int channels) {
+	*bytes += image_arena_size_of(size, depth, channels);
+	return a != 0x0 ? image_arena_create_image(a, size, depth, channels) : 0x0;
+}
 
-	// use static exposure
-	t->exposure = GOOD_EXPOSURE;
-	// use static adaptive exposure
+void psmove_tracker_arena_mask(ImageArena* a, size_t* bytes, BitMask* m, CvSize size) {
+	*bytes += image_arena_block_size_of(bit_mask_size_of(size));
+	if (a != 0x0)
+		bit_mask_init(m, size, image_arena_alloc(a, bit_mask_size_of(size)));
+}
 
-	// backup the systems settings, if not already backuped
-	if (th_file_exists(PSEYE_BACKUP_FILE) == 0)
-		camera_control_backup_sytem_settings(t->cc, PSEYE_BACKUP_FILE);
+size_t psmove_tracker_allocate_images(PSMoveTracker* t, ImageArena* a, IplImage* frame) {
+	CvSize size = cvGetSize(frame);
+	CvSize rows = cvSize(size.width, CALIBRATION_MASK_ROWS);
+	// the decimated masks are big enough for the biggest ROI at the smallest decimation
+	CvSize cells = cvSize((size.width + 1) / 2, (size.height + 1) / 2);
+	int b = (MIN(size.height, size.width) / ROIS);
+	// the decimated frame has the size of the whole frame divided by the decimation (rounded up)
+	int d = t->reacquire_decimation;
+	CvSize coarse = cvSize((size.width + d - 1) / d, (size.height + d - 1) / d);
+	size_t bytes = 0;
+	int i;
 
-	//t->exposure = psmove_tracker_adapt_to_light(t, 25, 2051, 4051);
-	camera_control_set_parameters(t->cc, 0, 0, 0, t->exposure, 0, 0xffff, 0xffff, 0xffff, -1, -1);
+	// prepare ROI data structures
+	t->roiI[0] = psmove_tracker_arena_image(a, &bytes, size, frame->depth, 3);
+	psmove_tracker_arena_mask(a, &bytes, &t->roiM[0], size);
+	t->roiS[0] = psmove_tracker_arena_image(a, &bytes, size, frame->depth, 1);
+	for (i = 1; i < ROIS; i++) {
+		int h = b * (ROIS - i);
+		t->roiI[i] = psmove_tracker_arena_image(a, &bytes, cvSize(h, h), frame->depth, 3);
+		psmove_tracker_arena_mask(a, &bytes, &t->roiM[i], cvSize(h, h));
+		t->roiS[i] = psmove_tracker_arena_image(a, &bytes, cvSize(h, h), frame->depth, 1);
+	}
+	t->coarseM = psmove_tracker_arena_image(a, &bytes, coarse, IPL_DEPTH_8U, 1);
+	psmove_tracker_arena_mask(a, &bytes, &t->decM, cells);
+	psmove_tracker_arena_mask(a, &bytes, &t->decI, cells);
+	psmove_tracker_arena_mask(a, &bytes, &t->decO, cells);
+	psmove_tracker_arena_mask(a, &bytes, &t->decT, cells);
+
+	// the calibration reuses the same images and masks for every controller
+	for (i = 0; i < BLINKS; i++)
+		t->calib_images[i] = psmove_tracker_arena_image(a, &bytes, size, frame->depth, 3);
+	psmove_tracker_arena_mask(a, &bytes, &t->calib_mask, size);
+	psmove_tracker_arena_mask(a, &bytes, &t->calib_blink, size);
+	psmove_tracker_arena_mask(a, &bytes, &t->calib_tmp, size);
+	psmove_tracker_arena_mask(a, &bytes, &t->calib_rows, rows);
+	t->calib_trace = psmove_tracker_arena_image(a, &bytes, size, frame->depth, 1);
+	return bytes;
+}
 
+int psmove_tracker_setup_rois(PSMoveTracker* t) {
+	int attempts = 0;
 	// just query a frame so that we know the camera works
 	IplImage* frame;
 	while (1) {
-		frame = camera_control_query_frame(t->cc);
-		if (!frame)
-			continue;
-		else
+		frame = psmove_tracker_query_frame(t);
+		if (frame)
 			break;
+		// a frame source may have nothing to deliver at all
+		if (t->source != 0x0 && ++attempts >= FRAME_SOURCE_ATTEMPTS) {
+			fprintf(stderr, "[TRACKER] the frame source delivered no frame\n");
+			return 0;
+		}
 	}
 
-	// prepare ROI data structures
-	t->roiI[0] = cvCreateImage(cvGetSize(frame), frame->depth, 3);
-	t->roiM[0] = cvCreateImage(cvGetSize(frame), frame->depth, 1);
-	int b = (MIN(t->roiI[0]->height, t->roiI[0]->width) / ROIS);
-	for (i = 1; i < ROIS; i++) {
-		IplImage* z = t->roiI[i - 1];
-		int h = b * (ROIS - i);
-		t->roiI[i] = cvCreateImage(cvSize(h, h), z->depth, 3);
-		t->roiM[i] = cvCreateImage(cvSize(h, h), z->depth, 1);
+	// scale all thresholds in pixels to the resolution of the camera, e.g. a QVGA frame shows the sphere at half the
+	// radius (the PS Eye bins the pixels of the whole sensor at lower resolutions, so the pixels are bigger)
+	float s = frame->width / (float) REFERENCE_WIDTH;
+	t->calib_min_size *= s * s;
+	t->calib_max_dist *= s;
+	t->tracker_t3 *= s;
+	t->color_t3 *= s;
+	t->reacquire_decimation = MAX(1, cvRound(t->reacquire_decimation * s));
+	t->cam_pixel_height /= s;
+
+	// the whole frame is filtered in one stripe per thread, if there is more than one
+	t->pool = tracker_pool_new(t->full_search_threads);
+	if (tracker_pool_get_threads(t->pool) > 1)
+		t->stripes = stripe_search_new(t->pool, cvGetSize(frame), tracker_pool_get_threads(t->pool));
+
+	// all images and masks of the tracker are taken from one arena, sized by a first pass over the same allocations
+	t->arena = image_arena_new(psmove_tracker_allocate_images(t, 0x0, frame), ARENA_HUGE_PAGES);
+	psmove_tracker_allocate_images(t, t->arena, frame);
+
+	// the blobs of all masks are labelled with the same data structures
+	t->blobs = bit_mask_blobs_new(cvGetSize(frame));
+
+	// without a calibration, the camera is modeled from the constants of the PS Eye
+	t->fx = t->fy = t->cam_focal_length * t->user_factor_dist * 100.0 / t->cam_pixel_height;
+	t->cx = frame->width * 0.5;
+	t->cy = frame->height * 0.5;
+	CvMat *intrinsic, *distortion;
+	if (t->cc != 0x0 && camera_control_get_calibration(t->cc, &intrinsic, &distortion)) {
+		t->fx = cvmGet(intrinsic, 0, 0);
+		t->fy = cvmGet(intrinsic, 1, 1);
+		t->cx = cvmGet(intrinsic, 0, 2);
+		t->cy = cvmGet(intrinsic, 1, 2);
+		if (!camera_control_get_undistort_frames(t->cc)) {
+			t->intrinsic = intrinsic;
+			t->distortion = distortion;
+		}
 	}
+	return 1;
+}
 
-	// prepare structure used for
-	t->kCalib = cvCreateStructuringElementEx(5, 5, 3, 3, CV_SHAPE_RECT, 0x0);
-	return t;
+IplImage* psmove_tracker_query_frame(PSMoveTracker* t) {
+	if (t->source != 0x0)
+		return t->source(t->source_data);
+	if (t->grabber != 0x0)
+		return frame_grabber_query_frame(t->grabber);
+	IplImage* frame = camera_control_query_frame(t->cc);
+	if (frame != 0x0 && t->exposure_control != 0x0)
+		exposure_control_process(t->exposure_control, frame);
+	return frame;
 }
 
 enum PSMoveTracker_Status psmove_tracker_enable(PSMoveTracker *tracker, PSMove *move) {
@@ -348,6 +836,10 @@ int psmove_tracker_old_color_is_tracked(PSMoveTracker* t, PSMove* move, int r, i
 	int i = 0;
 	int d = 0;
 	if (tracked_controller_load_color(tc)) {
+		tc->exposure = t->exposure;
+		tc->cFColor = tc->eFColor;
+		tc->cExposure = tc->exposure;
+		psmove_tracker_rebase_color(tc, psmove_tracker_current_exposure(t));
 
 		result = 1;
 		for (i = 0; i < nTimes; i++) {
@@ -360,7 +852,8 @@ int psmove_tracker_old_color_is_tracked(PSMoveTracker* t, PSMove* move, int r, i
 			}
 
 			psmove_tracker_update_controller(t, tc, &q1, 0, &q3);
-			psmove_tracker_draw_tracking_stats(t);
+			// do not keep the timings of the calibration
+			psmove_profile_commit(t->profiler, -1);
 
 			// if the quality is higher than 83% and the blobs radius bigger than 8px
 			result = result && q1 > 0.83 && q3 > 8;
@@ -372,6 +865,16 @@ int psmove_tracker_old_color_is_tracked(PSMoveTracker* t, PSMove* move, int r, i
 }
 
 enum PSMoveTracker_Status psmove_tracker_enable_with_color(PSMoveTracker *tracker, PSMove *move, unsigned char r, unsigned char g, unsigned char b) {
+	// the blinking sphere is compared between frames, and its color is estimated for the current exposure
+	if (tracker->exposure_control != 0x0)
+		exposure_control_set_paused(tracker->exposure_control, 1);
+	enum PSMoveTracker_Status status = psmove_tracker_calibrate_color(tracker, move, r, g, b);
+	if (tracker->exposure_control != 0x0)
+		exposure_control_set_paused(tracker->exposure_control, 0);
+	return status;
+}
+
+enum PSMoveTracker_Status psmove_tracker_calibrate_color(PSMoveTracker *tracker, PSMove *move, unsigned char r, unsigned char g, unsigned char b) {
 	PSMoveTracker* t = tracker;
 	int i;
 	// check if the controller is already enabled!
@@ -386,80 +889,67 @@ enum PSMoveTracker_Status psmove_tracker_enable_with_color(PSMoveTracker *tracke
 	// try to track the controller with the old color, if it works, immediately return1
 	if (psmove_tracker_old_color_is_tracked(tracker, move, r, g, b)) {
 		TrackedController* itm = tracked_controller_insert(&tracker->controllers, move);
+		psmove_tracker_assign_slot(tracker, itm);
 		itm->dColor = cvScalar(b, g, r, 0);
 		tracked_controller_load_color(itm);
+		// the saved colors belong to the exposure the tracker starts with
+		itm->exposure = t->exposure;
+		itm->cFColor = itm->eFColor;
+		itm->cExposure = itm->exposure;
+		psmove_tracker_rebase_color(itm, psmove_tracker_current_exposure(t));
 		tracked_color->is_used = 1;
+		psmove_tracker_emit_event(tracker, itm, Tracker_EVENT_CALIBRATED, hp_timer_now_ns());
 		return Tracker_CALIBRATED;
 	}
 
 	// clear the calibration html trace
 	psmove_html_trace_clear();
 
-	IplImage* frame = camera_control_query_frame(tracker->cc);
-	IplImage* images[BLINKS]; // array of images saved during calibration for estimation of sphere color
-	IplImage* diffs[BLINKS]; // array of masks saved during calibration for estimation of sphere color
+	IplImage* frame = psmove_tracker_query_frame(tracker);
+	IplImage** images = t->calib_images; // array of images saved during calibration for estimation of sphere color
+	BitMask* mask = &t->calib_mask; // intersection of the masks of all blinks, used for estimation of sphere color
 	double sizes[BLINKS]; // array of blob sizes saved during calibration for estimation of sphere color
-	for (i = 0; i < BLINKS; i++) {
-		images[i] = cvCreateImage(cvGetSize(frame), frame->depth, 3);
-		diffs[i] = cvCreateImage(cvGetSize(frame), frame->depth, 1);
-	}
 	// DEBUG log the assigned color
 	CvScalar assignedColor = cvScalar(b, g, r, 0);
 	psmove_html_trace_var_color("assignedColor", assignedColor);
 
 	// for each blink
 	for (i = 0; i < BLINKS; i++) {
-		// create a diff image
-		psmove_tracker_get_diff(tracker, move, r, g, b, images[i], diffs[i], BLINK_DELAY);
-
-		// DEBUG log the diff image and the image with the lit sphere
-		psmove_html_trace_image_at(images[i], i, "originals");
-		psmove_html_trace_image_at(diffs[i], i, "rawdiffs");
-
-		// threshold it to reduce image noise
-		cvThreshold(diffs[i], diffs[i], t->calibration_t, 0xFF, CV_THRESH_BINARY);
+		// take the images with the lit and unlit sphere
+		IplImage* off = psmove_tracker_get_blink(tracker, move, r, g, b, images[i], BLINK_DELAY);
 
-		// DEBUG log the thresholded diff image
-		psmove_html_trace_image_at(diffs[i], i, "threshdiffs");
+		// in one pass: diff them in grey, threshold the diff to reduce image noise, use morphological
+		// operations to further remove noise and put the masks of all blinks together to get hopefully
+		// only one intersection region, the region at which the controllers sphere resides.
+		calibration_mask_fold(images[i], off, t->calibration_t, &t->calib_rows, mask, i == 0, &t->calib_blink);
 
-		// use morphological operations to further remove noise
-		cvErode(diffs[i], diffs[i], t->kCalib, 1);
-		cvDilate(diffs[i], diffs[i], t->kCalib, 1);
-
-		// DEBUG log the even more cleaned up diff-image
-		psmove_html_trace_image_at(diffs[i], i, "erodediffs");
-	}
-
-	// put the diff images together to get hopefully only one intersection region
-	// the region at which the controllers sphere resides.
-	for (i = 1; i < BLINKS; i++) {
-		cvAnd(diffs[0], diffs[i], diffs[0], 0x0);
+		// DEBUG log the image with the lit sphere, the cleaned up diff-image and the intersection so far
+		psmove_html_trace_image_at(images[i], i, "originals");
+		psmove_tracker_trace_mask(t, &t->calib_blink, i, "erodediffs");
+		psmove_tracker_trace_mask(t, mask, i, "intersections");
 	}
 
-	// find the biggest contour
-	float sizeBest = 0;
-	CvSeq* contourBest = 0x0;
-	psmove_tracker_biggest_contour(diffs[0], t->storage, &contourBest, &sizeBest);
+	// find the biggest blob
+	bit_mask_blobs_find(t->blobs, mask, cvRect(0, 0, mask->width, mask->height));
+	int blobBest = bit_mask_blobs_biggest(t->blobs);
 
-	// blank out the image and repaint the blob where the sphere is deemed to be
-	cvSet(diffs[0], th_black, 0x0);
-	if (contourBest)
-		cvDrawContours(diffs[0], contourBest, th_white, th_white, -1, CV_FILLED, 8, cvPoint(0, 0));
-
-	cvClearMemStorage(t->storage);
+	// blank out the mask and repaint the blob where the sphere is deemed to be
+	bit_mask_clear(mask);
+	if (blobBest >= 0)
+		bit_mask_blobs_draw_mask(t->blobs, blobBest, mask);
 
 	// DEBUG log the final diff-image used for color estimation
-	psmove_html_trace_image_at(diffs[0], 0, "finaldiff");
+	psmove_tracker_trace_mask(t, mask, 0, "finaldiff");
 
 	// CHECK if the blob contains a minimum number of pixels
-	if (cvCountNonZero(diffs[0]) < CALIB_MIN_SIZE) {
+	if (blobBest < 0 || bit_mask_blobs_get(t->blobs, blobBest)->pixels < t->calib_min_size) {
 		psmove_html_trace_log_entry("WARNING", "The final mask my not be representative for color estimation.");
 	}
 
 	// calculate the avg color
-	CvScalar color = cvAvg(images[0], diffs[0]);
-	CvScalar hsv_assigned = th_brg2hsv(assignedColor);
-	CvScalar hsv_color = th_brg2hsv(color);
+	CvScalar color = blobBest >= 0 ? bit_mask_blobs_avg(t->blobs, blobBest, images[0]) : cvScalarAll(0);
+	CvScalar hsv_assigned = color_scalar_bgr2hsv(assignedColor);
+	CvScalar hsv_color = color_scalar_bgr2hsv(color);
 
 	psmove_html_trace_var_color("estimatedColor", color);
 	psmove_html_trace_var_int("estimated_hue", hsv_color.val[0]);
@@ -471,9 +961,6 @@ enum PSMoveTracker_Status psmove_tracker_enable_with_color(PSMoveTracker *tracke
 		psmove_html_trace_log_entry("WARNING", "The estimated color seems not to be similar to the color it should be.");
 	}
 
-	// just reusing the data structure
-	IplImage* mask = diffs[0];
-
 	int valid_countours = 0;
 	// calculate upper & lower bounds for the color filter
 	CvScalar min, max;
@@ -484,51 +971,43 @@ enum PSMoveTracker_Status psmove_tracker_enable_with_color(PSMoveTracker *tracke
 	CvPoint firstPosition = cvPoint(-9999, 9999);
 	for (i = 0; i < BLINKS; i++) {
 		// convert to HSV
-		cvCvtColor(images[i], images[i], CV_BGR2HSV);
+		color_bgr2hsv_image(images[i], cvRect(0, 0, images[i]->width, images[i]->height), images[i], cvPoint(0, 0));
 		// apply color filter
-		cvInRangeS(images[i], min, max, mask);
+		bit_mask_in_range(mask, cvRect(0, 0, mask->width, mask->height), images[i], min, max);
 
 		// use morphological operations to further remove noise
-		cvErode(mask, mask, t->kCalib, 1);
-		cvDilate(mask, mask, t->kCalib, 1);
+		bit_mask_erode(mask, mask, &t->calib_tmp, CALIBRATION_MASK_KERNEL, CALIBRATION_MASK_ANCHOR);
+		bit_mask_dilate(mask, mask, &t->calib_tmp, CALIBRATION_MASK_KERNEL, CALIBRATION_MASK_ANCHOR);
 
 		// DEBUG log the color filter and
-		psmove_html_trace_image_at(mask, i, "filtered");
+		psmove_tracker_trace_mask(t, mask, i, "filtered");
 
-		// find the biggest contour in the image and save its location and size
-		psmove_tracker_biggest_contour(mask, t->storage, &contourBest, &sizeBest);
+		// find the biggest blob in the image and save its location and size
+		bit_mask_blobs_find(t->blobs, mask, cvRect(0, 0, mask->width, mask->height));
+		blobBest = bit_mask_blobs_biggest(t->blobs);
 		sizes[i] = 0;
 		float dist = 9999;
-		CvRect bBox;
-		if (contourBest) {
-			bBox = cvBoundingRect(contourBest, 0);
+		if (blobBest >= 0) {
+			CvRect bBox = bit_mask_blobs_get(t->blobs, blobBest)->bbox;
 			if (i == 0) {
 				firstPosition = cvPoint(bBox.x, bBox.y);
 			}
 			dist = sqrt(pow(firstPosition.x - bBox.x, 2) + pow(firstPosition.y - bBox.y, 2));
-			sizes[i] = sizeBest;
+			sizes[i] = bit_mask_blobs_get(t->blobs, blobBest)->pixels;
 		}
 
 		// CHECK for errors (no contour, more than one contour, or contour too small)
-		if (contourBest == 0x0) {
+		if (blobBest < 0) {
 			psmove_html_trace_array_item_at(i, "contours", "no contour");
-		} else if (sizes[i] <= CALIB_MIN_SIZE) {
+		} else if (sizes[i] <= t->calib_min_size) {
 			psmove_html_trace_array_item_at(i, "contours", "too small");
-		} else if (dist >= CALIB_MAX_DIST) {
+		} else if (dist >= t->calib_max_dist) {
 			psmove_html_trace_array_item_at(i, "contours", "too far apart");
 		} else {
 			psmove_html_trace_array_item_at(i, "contours", "OK");
 			// all checks passed, increase the number of valid contours
 			valid_countours++;
 		}
-		cvClearMemStorage(t->storage);
-
-	}
-
-	// clean up all temporary images
-	for (i = 0; i < BLINKS; i++) {
-		cvReleaseImage(&images[i]);
-		cvReleaseImage(&diffs[i]);
 	}
 
 	int CHECK_HAS_ERRORS = 0;
@@ -551,6 +1030,7 @@ enum PSMoveTracker_Status psmove_tracker_enable_with_color(PSMoveTracker *tracke
 
 	// insert to list of tracked controllers
 	TrackedController* itm = tracked_controller_insert(&tracker->controllers, move);
+	psmove_tracker_assign_slot(tracker, itm);
 	// set current color
 	itm->dColor = cvScalar(b, g, r, 0);
 	// set first estimated color
@@ -559,11 +1039,42 @@ enum PSMoveTracker_Status psmove_tracker_enable_with_color(PSMoveTracker *tracke
 	// set current estimated color
 	itm->eColor = color;
 	itm->eColorHSV = hsv_color;
+	itm->exposure = psmove_tracker_current_exposure(t);
+	itm->cFColor = itm->eFColor;
+	itm->cExposure = itm->exposure;
 
 	// set, that this color is in use
 	tracked_color->is_used = 1;
 
-	tracked_controller_save_colors(tracker->controllers);
+	psmove_tracker_save_colors(tracker);
+	psmove_tracker_emit_event(tracker, itm, Tracker_EVENT_CALIBRATED, hp_timer_now_ns());
+	return Tracker_CALIBRATED;
+}
+
+enum PSMoveTracker_Status psmove_tracker_enable_with_known_color(PSMoveTracker *tracker, PSMove *move, unsigned char r, unsigned char g, unsigned char b) {
+	// check if the controller is already enabled!
+	if (tracked_controller_find(tracker->controllers, move))
+		return Tracker_CALIBRATED;
+
+	// the color does not need to be one of the available colors, but if it is, nobody else should use it
+	PSMoveTrackingColor* tracked_color = tracked_color_find(tracker->available_colors, r, g, b);
+	if (tracked_color != 0x0) {
+		if (tracked_color->is_used)
+			return Tracker_CALIBRATION_ERROR;
+		tracked_color->is_used = 1;
+	}
+
+	TrackedController* itm = tracked_controller_insert(&tracker->controllers, move);
+	psmove_tracker_assign_slot(tracker, itm);
+	itm->dColor = cvScalar(b, g, r, 0);
+	itm->eFColor = itm->dColor;
+	itm->eFColorHSV = color_scalar_bgr2hsv(itm->eFColor);
+	itm->eColor = itm->eFColor;
+	itm->eColorHSV = itm->eFColorHSV;
+	itm->exposure = psmove_tracker_current_exposure(tracker);
+	itm->cFColor = itm->eFColor;
+	itm->cExposure = itm->exposure;
+	psmove_tracker_emit_event(tracker, itm, Tracker_EVENT_CALIBRATED, hp_timer_now_ns());
 	return Tracker_CALIBRATED;
 }
 
@@ -606,8 +1117,16 @@ psmove_tracker_get_image(PSMoveTracker *tracker) {
 	return tracker->frame;
 }
 
+void psmove_tracker_get_size(PSMoveTracker *tracker, int *width, int *height) {
+	if (width != 0x0)
+		*width = tracker->roiI[0]->width;
+	if (height != 0x0)
+		*height = tracker->roiI[0]->height;
+}
+
 void psmove_tracker_update_image(PSMoveTracker *tracker) {
-	tracker->frame = camera_control_query_frame(tracker->cc);
+	tracker->frame = psmove_tracker_query_frame(tracker);
+	tracker->frame_ns = hp_timer_now_ns();
 }
 
 int psmove_tracker_update_controller(PSMoveTracker *tracker, TrackedController* tc, float* q1, float* q2, float* q3) {
@@ -621,52 +1140,67 @@ int psmove_tracker_update_controller(PSMoveTracker *tracker, TrackedController*
 	th_minus(tc->eColorHSV.val, t->rHSV.val, min.val, 3);
 	th_plus(tc->eColorHSV.val, t->rHSV.val, max.val, 3);
 
+	// with the decimated search, bigger ROIs are never searched: the ROI of a lost sphere has been placed on
+	// a candidate (see psmove_tracker_reacquire), and a sphere that is not found in its ROI is marked as lost,
+	// so that the scheduler searches it within its budget instead of climbing up to a search of the whole frame
+	int decimated_search = t->reacquire_decimation > 1;
+
+	// the ROI of a big sphere is classified at a lower resolution, so that the cost stays about the same at any distance
+	int decimation = psmove_tracker_roi_decimation(t, tc);
+
 	// this is the tracking algorithm
+	int retry = 0;
 	while (1) {
+		// every search after the first one is a search on a bigger ROI
+		if (retry)
+			psmove_profile_start(t->profiler, Tracker_STAGE_ROI_RETRIES);
+
 		// get pointers to data structures for the given ROI-Level
 		IplImage *roi_i = t->roiI[tc->roi_level];
-		IplImage *roi_m = t->roiM[tc->roi_level];
-
-		// adjust the ROI, so that the blob is fully visible, but only if we have a reasonable FPS
-		if (t->debug_fps > ROI_ADJUST_FPS_T) {
+		IplImage *roi_m = t->roiS[tc->roi_level];
+		if (tc->roi_level == 0)
+			tc->roi_full_searches++;
+
+		// apply the color filter to the whole ROI and find the biggest blob
+		CvSeq* contourBest;
+		if (tc->roi_level == 0 && t->stripes != 0x0) {
+			psmove_tracker_filter_in_stripes(t, min, max);
+			contourBest = psmove_tracker_find_blob(t, tc);
+		} else if (decimation > 1) {
+			psmove_tracker_filter_roi_decimated(t, tc, decimation, min, max);
+			contourBest = psmove_tracker_find_blob(t, tc);
+		} else {
+			psmove_tracker_filter_roi(t, tc, cvRect(0, 0, roi_i->width, roi_i->height), min, max);
+			contourBest = psmove_tracker_find_blob(t, tc);
+		}
 
-			CvPoint nRoiCenter = psmove_tracker_better_roi_center(tc, tracker);
-			if (nRoiCenter.x != -1) {
-				tc->roi_x = nRoiCenter.x;
-				tc->roi_y = nRoiCenter.y;
-				psmove_tracker_fix_roi(tc, roi_i->width, roi_i->height, t->roiI[0]->width, t->roiI[0]->height);
+		// if the blob touches the border of the ROI, it may not be fully visible: move the ROI
+		// onto the blob (which reuses the mask that has already been filtered) and analyze it again
+		if (contourBest) {
+			CvRect br = cvBoundingRect(contourBest, 0);
+			if (psmove_tracker_center_roi_on_blob(tc, t, br, min, max)) {
+				cvClearMemStorage(t->storage);
+				contourBest = psmove_tracker_find_blob(t, tc);
 			}
 		}
-
-		// apply the ROI
 		cvSetImageROI(t->frame, cvRect(tc->roi_x, tc->roi_y, roi_i->width, roi_i->height));
-		cvCvtColor(t->frame, roi_i, CV_BGR2HSV);
-
-		// apply color filter
-		cvInRangeS(roi_i, min, max, roi_m);
-		cvSmooth(roi_i, roi_i, CV_GAUSSIAN, 5, 5, 0, 0);
-
-		// find the biggest contour in the image
-		float sizeBest = 0;
-		CvSeq* contourBest = 0x0;
-		psmove_tracker_biggest_contour(roi_m, t->storage, &contourBest, &sizeBest);
 
 		if (contourBest) {
-			CvMoments mu;
 			CvRect br = cvBoundingRect(contourBest, 0);
 
-			// restore the biggest contour
-			cvSet(roi_m, th_black, 0x0);
+			// restore the biggest contour (the statistics only read its bounding box)
+			psmove_profile_start(t->profiler, Tracker_STAGE_CONTOURS);
+			cvSetImageROI(roi_m, br);
+			cvSetZero(roi_m);
+			cvResetImageROI(roi_m);
 			cvDrawContours(roi_m, contourBest, th_white, th_white, -1, CV_FILLED, 8, cvPoint(0, 0));
-#ifdef PRINT_DEBUG_STATS
-			if (tc->next == 0x0)
-				cvShowImage("0", roi_m);
-			else
-				cvShowImage("1", roi_m);
-#endif
-			// calucalte image-moments
-			cvMoments(roi_m, &mu, 0);
-			CvPoint p = cvPoint(mu.m10 / mu.m00, mu.m01 / mu.m00);
+			psmove_profile_stop(t->profiler, Tracker_STAGE_CONTOURS);
+			// calculate the center of mass, the size and the color sums of the blob in one pass
+			psmove_profile_start(t->profiler, Tracker_STAGE_MOMENTS);
+			PSMoveTrackerBlobStats stats;
+			psmove_tracker_blob_statistics(roi_m, t->frame, br, &stats);
+			psmove_profile_stop(t->profiler, Tracker_STAGE_MOMENTS);
+			CvPoint p = cvPoint(stats.sx / stats.pixels, stats.sy / stats.pixels);
 			CvPoint oldMCenter = cvPoint(tc->mx, tc->my);
 			tc->mx = p.x + tc->roi_x;
 			tc->my = p.y + tc->roi_y;
@@ -674,7 +1208,9 @@ int psmove_tracker_update_controller(PSMoveTracker *tracker, TrackedController*
 
 			// remember the old radius and calcutlate the new x/y position and radius of the found contour
 			float oldRadius = tc->r;
+			psmove_profile_start(t->profiler, Tracker_STAGE_RADIUS);
 			psmove_tracker_estimate_3d_pos(contourBest, &c, &tc->r);
+			psmove_profile_stop(t->profiler, Tracker_STAGE_RADIUS);
 
 			// apply radius-smoothing if enabled
 			if (t->tracker_adaptive_z) {
@@ -705,7 +1241,7 @@ int psmove_tracker_update_controller(PSMoveTracker *tracker, TrackedController*
 			}
 
 			// calculate the quality of the tracking
-			int pixelInBlob = cvCountNonZero(roi_m);
+			int pixelInBlob = stats.pixels;
 			float pixelInResult = tc->r * tc->r * th_PI;
 			float tq1 = 0;
 			float tq2 = FLT_MAX;
@@ -747,26 +1283,32 @@ int psmove_tracker_update_controller(PSMoveTracker *tracker, TrackedController*
 
 				// use adaptive color detection
 				// only if 	1) the sphere has been found
-				// AND		2) the UPDATE_RATE has passed
-				// AND		3) the tracking-quality is high;
-				int do_color_adaption = 0;
-				time_t now = time(0);
-				if (t->color_update_rate > 0 && difftime(now, tc->last_color_update) > t->color_update_rate)
-					do_color_adaption = 1;
-
-				if (do_color_adaption && tq1 > t->color_t1 && tq2 < t->color_t2 && tq3 > t->color_t3) {
-					// calculate the new estimated color (adaptive color estimation)
-					CvScalar newColor = cvAvg(t->frame, roi_m);
-					th_plus(tc->eColor.val, newColor.val, tc->eColor.val, 3);
-					th_mul(tc->eColor.val, 0.5, tc->eColor.val, 3);
-					tc->eColorHSV = th_brg2hsv(tc->eColor);
-					tc->last_color_update = now;
+				// AND		2) the tracking-quality is high;
+				if (t->color_adaption_rate > 0 && tq1 > t->color_t1 && tq2 < t->color_t2 && tq3 > t->color_t3) {
+					psmove_profile_start(t->profiler, Tracker_STAGE_COLOR_ADAPTION);
+					// exponentially weighted estimation from the color sums of the blob (there is no extra pass over the ROI)
+					float a = t->color_adaption_rate;
+					unsigned char bgr[3], hsv[3];
+					for (i = 0; i < 3; i++) {
+						tc->eColor.val[i] = tc->eColor.val[i] * (1 - a) + stats.sbgr[i] / stats.pixels * a;
+						bgr[i] = (unsigned char) (tc->eColor.val[i] + 0.5);
+					}
+					color_bgr2hsv(bgr, hsv);
+					// the filter only changes, if the color changes by at least one step in HSV
+					int adapted = hsv[0] != tc->eColorHSV.val[0] || hsv[1] != tc->eColorHSV.val[1] || hsv[2] != tc->eColorHSV.val[2];
+					tc->eColorHSV = cvScalar(hsv[0], hsv[1], hsv[2], 0);
 					// CHECK if the current estimate is too far away from its original estimation
 					if (psmove_tracker_hsvcolor_diff(tc) > t->adapt_t1) {
 						tc->eColor = tc->eFColor;
 						tc->eColorHSV = tc->eFColorHSV;
 						sphere_found = 0;
+						psmove_tracker_record_event(t, tc, FR_EVENT_COLOR_RESET, tq1, tq2, tq3, 0);
+						psmove_tracker_emit_event(t, tc, Tracker_EVENT_COLOR_RESET, t->frame_ns);
+					} else if (adapted) {
+						psmove_tracker_record_event(t, tc, FR_EVENT_COLOR_ADAPTED, tq1, tq2, tq3, 0);
+						psmove_tracker_emit_event(t, tc, Tracker_EVENT_COLOR_ADAPTED, t->frame_ns);
 					}
+					psmove_profile_stop(t->profiler, Tracker_STAGE_COLOR_ADAPTION);
 				}
 
 				// update the future roi box
@@ -779,7 +1321,7 @@ int psmove_tracker_update_controller(PSMoveTracker *tracker, TrackedController*
 					tc->roi_level = i;
 					// update easy accessors
 					roi_i = t->roiI[tc->roi_level];
-					roi_m = t->roiM[tc->roi_level];
+					roi_m = t->roiS[tc->roi_level];
 				}
 
 				// adjust the roi variables accordingly
@@ -797,18 +1339,23 @@ int psmove_tracker_update_controller(PSMoveTracker *tracker, TrackedController*
 		cvClearMemStorage(t->storage);
 		cvResetImageROI(t->frame);
 
-		if (sphere_found || roi_i->width == t->roiI[0]->width) {
-			// the sphere was found, or the max ROI was reached
+		if (retry)
+			psmove_profile_stop(t->profiler, Tracker_STAGE_ROI_RETRIES);
+		retry = 1;
+
+		if (sphere_found || roi_i->width == t->roiI[0]->width || decimated_search) {
+			// the sphere was found, or the max ROI was reached (or the sphere is left to the decimated search)
 			break;
 		} else {
 			// the sphere was not found, increase the ROI and search again!
+			tc->roi_fallbacks++;
 			tc->roi_x += roi_i->width / 2;
 			tc->roi_y += roi_i->height / 2;
 
 			tc->roi_level = tc->roi_level - 1;
 			// update easy accessors
 			roi_i = t->roiI[tc->roi_level];
-			roi_m = t->roiM[tc->roi_level];
+			roi_m = t->roiS[tc->roi_level];
 
 			tc->roi_x -= roi_i->width / 2;
 			tc->roi_y -= roi_i->height / 2;
@@ -826,34 +1373,107 @@ int psmove_tracker_update_controller(PSMoveTracker *tracker, TrackedController*
 int psmove_tracker_update(PSMoveTracker *tracker, PSMove *move) {
 	TrackedController* tc = 0x0;
 	int spheres_found = 0;
+	int lost = 0;
+	int n_lost = 0;
 	int UPDATE_ALL_CONTROLLERS = move == 0x0;
 	// used for FPS calculation (timer)
 	hp_timer_start(tracker->timer);
-	if (UPDATE_ALL_CONTROLLERS) {
-		// iterate trough all controllers and find their lit spheres
-		tc = tracker->controllers;
-		for (; tc != 0x0 && tracker->frame; tc = tc->next) {
-			spheres_found += psmove_tracker_update_controller(tracker, tc, 0, 0, 0);
+	tracker->frame_no++;
+
+	// the colors follow the changes of the exposure control
+	if (tracker->exposure_control != 0x0) {
+		int exposure = exposure_control_get_exposure(tracker->exposure_control);
+		for (tc = tracker->controllers; tc != 0x0; tc = tc->next)
+			psmove_tracker_rebase_color(tc, exposure);
+	}
+
+	tc = tracker->controllers;
+	for (; tc != 0x0 && tracker->frame; tc = tc->next) {
+		// update all controllers, or just that specific one
+		if (!UPDATE_ALL_CONTROLLERS && tc->move != move)
+			continue;
+
+		// tracked controllers come first, lost ones are searched afterwards within the budget
+		if (!tc->is_tracked && tracker->reacquire_decimation > 1) {
+			tc->reacquire_pending = 1;
+			n_lost++;
+			continue;
 		}
-	} else {
-		// find just that specific controller
-		tc = tracked_controller_find(tracker->controllers, move);
-		if (tracker->frame && tc) {
-			spheres_found = psmove_tracker_update_controller(tracker, tc, 0, 0, 0);
+
+		float q1 = 0, q2 = 0, q3 = 0;
+		int was_tracked = tc->is_tracked;
+		int found = 0;
+		int64_t controller_ns = 0;
+		HP_TIMER_SCOPE(controller_ns) {
+			found = psmove_tracker_update_controller(tracker, tc, &q1, &q2, &q3);
+		}
+
+		psmove_tracker_record_event(tracker, tc, found ? FR_EVENT_FOUND : FR_EVENT_NOT_FOUND, q1, q2, q3, controller_ns);
+		psmove_profile_commit(tracker->profiler, tc->slot);
+		psmove_tracker_emit_transition(tracker, tc, was_tracked, found);
+		lost = lost || (was_tracked && !found);
+		spheres_found += found;
+
+		// a sphere that is not found in its ROI is left to the scheduler from the next frame on
+		if (!found && tracker->reacquire_decimation > 1)
+			tc->reacquire_handoffs++;
+
+		// the search for a sphere that has just been lost starts where it has been seen the last time
+		if (was_tracked && !found)
+			tc->reacquire_tile = MIN(MAX((int) tc->y, 0) * REACQUIRE_TILES / tracker->frame->height, REACQUIRE_TILES - 1);
+	}
+	if (n_lost > 0 && tracker->frame)
+		spheres_found += psmove_tracker_schedule_reacquisition(tracker, n_lost);
+
+	// the camera space positions of all spheres found in this frame
+	for (tc = tracker->controllers; tc != 0x0; tc = tc->next) {
+		if (tc->is_tracked && (UPDATE_ALL_CONTROLLERS || tc->move == move))
+			psmove_tracker_update_camera_position(tracker, tc);
+	}
+
+	// keep the events that led to a tracking loss, but do not flood the file system (nor wait for it)
+	if (lost && tracker->recorder_writer != 0x0) {
+		int64_t now = hp_timer_now_ns();
+		if (tracker->recorder_last_dump == 0 || now - tracker->recorder_last_dump >= FLIGHT_RECORDER_DUMP_INTERVAL * 1000000000LL) {
+			if (flight_recorder_writer_dump(tracker->recorder_writer, tracker->recorder, tracker->recorder_dump_file))
+				tracker->recorder_last_dump = now;
 		}
 	}
 // used for FPS calculation (timer)
 	hp_timer_stop(tracker->timer);
+	tracker->debug_fps = 0.85 * tracker->debug_fps + 0.15 * (1.0 / hp_timer_get_seconds(tracker->timer));
 
-	// draw all/one controller information to camera image
-#ifdef PRINT_DEBUG_STATS
-	psmove_tracker_draw_tracking_stats(tracker);
-#endif
+	// the overlay is drawn on a copy of the frame on another thread, and only if it has been asked for
+	if (tracker_overlay_is_requested(tracker->overlay)) {
+		psmove_profile_start(tracker->profiler, Tracker_STAGE_OVERLAY);
+		psmove_tracker_publish_overlay(tracker);
+		psmove_profile_stop(tracker->profiler, Tracker_STAGE_OVERLAY);
+		psmove_profile_commit(tracker->profiler, tracker->frame_slot);
+	}
+
+	psmove_tracker_publish_snapshot(tracker);
+	if (tracker->shm != 0x0)
+		psmove_tracker_publish_shm(tracker, move);
+	if (tracker->stream != 0x0)
+		psmove_tracker_publish_stream(tracker);
 	// return the number of spheres found
 	return spheres_found;
 
 }
 
+int psmove_tracker_get_camera_position(PSMoveTracker *tracker, PSMove *move, float *x, float *y, float *z) {
+	TrackedController* tc = tracked_controller_find(tracker->controllers, move);
+	if (tc == 0x0)
+		return 0;
+	if (x != 0x0)
+		*x = tc->cam_x;
+	if (y != 0x0)
+		*y = tc->cam_y;
+	if (z != 0x0)
+		*z = tc->cam_z;
+	return 1;
+}
+
 int psmove_tracker_get_position(PSMoveTracker *tracker, PSMove *move, float *x, float *y, float *radius) {
 	TrackedController* tc = tracked_controller_find(tracker->controllers, move);
 	if (tc != 0x0) {
@@ -870,71 +1490,152 @@ int psmove_tracker_get_position(PSMoveTracker *tracker, PSMove *move, float *x,
 	return 1;
 }
 
+int psmove_tracker_get_roi_statistics(PSMoveTracker *tracker, PSMove *move, int *fallbacks, int *full_searches) {
+	TrackedController* tc = tracked_controller_find(tracker->controllers, move);
+	if (tc == 0x0)
+		return 0;
+	if (fallbacks != 0x0)
+		*fallbacks = tc->roi_fallbacks;
+	if (full_searches != 0x0)
+		*full_searches = tc->roi_full_searches;
+	return 1;
+}
+
+int psmove_tracker_get_reacquisition_statistics(PSMoveTracker *tracker, PSMove *move, int *handoffs, int *searches) {
+	TrackedController* tc = tracked_controller_find(tracker->controllers, move);
+	if (tc == 0x0)
+		return 0;
+	if (handoffs != 0x0)
+		*handoffs = tc->reacquire_handoffs;
+	if (searches != 0x0)
+		*searches = tc->reacquire_searches;
+	return 1;
+}
+
+int psmove_tracker_get_capture_statistics(PSMoveTracker *tracker, unsigned int *processed, unsigned int *dropped, float *delay_avg, float *delay_max) {
+	if (tracker->grabber == 0x0)
+		return 0;
+	frame_grabber_get_statistics(tracker->grabber, processed, dropped, delay_avg, delay_max);
+	return 1;
+}
+
+unsigned int psmove_tracker_get_image_allocations(PSMoveTracker *tracker) {
+	return image_arena_get_heap_allocations(tracker->arena);
+}
+
+int psmove_tracker_get_camera_color(PSMoveTracker *tracker, PSMove *move, unsigned char *r, unsigned char *g, unsigned char *b) {
+	TrackedController* tc = tracked_controller_find(tracker->controllers, move);
+	if (tc == 0x0)
+		return 0;
+	*r = (unsigned char) tc->eFColor.val[2];
+	*g = (unsigned char) tc->eFColor.val[1];
+	*b = (unsigned char) tc->eFColor.val[0];
+	return 1;
+}
+
+int psmove_tracker_get_stage_timing(PSMoveTracker *tracker, PSMove *move, enum PSMoveTracker_Stage stage, float *p50, float *p99, float *max) {
+	int slot = tracker->frame_slot;
+	if (move != 0x0) {
+		TrackedController* tc = tracked_controller_find(tracker->controllers, move);
+		if (tc == 0x0)
+			return 0;
+		slot = tc->slot;
+	}
+	return stage_profiler_get_stats(tracker->profiler, slot, stage, p50, p99, max);
+}
+
+int psmove_tracker_dump_flight_recorder(PSMoveTracker *tracker, const char* file) {
+	return flight_recorder_dump(tracker->recorder, file);
+}
+
+void psmove_tracker_set_dump_on_loss(PSMoveTracker *tracker, const char* file) {
+	free(tracker->recorder_dump_file);
+	tracker->recorder_dump_file = 0x0;
+	if (file != 0x0) {
+		tracker->recorder_dump_file = (char*) malloc(strlen(file) + 1);
+		strcpy(tracker->recorder_dump_file, file);
+		if (tracker->recorder_writer == 0x0)
+			tracker->recorder_writer = flight_recorder_writer_new(FLIGHT_RECORDER_EVENTS);
+	} else {
+		flight_recorder_writer_release(tracker->recorder_writer);
+		tracker->recorder_writer = 0x0;
+	}
+}
+
+int psmove_tracker_set_shared_memory(PSMoveTracker *tracker, const char* name) {
+	tracker_shm_close(tracker->shm);
+	tracker->shm = 0x0;
+	if (name != 0x0) {
+		tracker->shm = tracker_shm_create(name);
+		memset(&tracker->shm_frame, 0, sizeof(TrackerShmFrame));
+		return tracker->shm != 0x0;
+	}
+	return 1;
+}
+
+int psmove_tracker_set_stream(PSMoveTracker *tracker, const char* address, int batch) {
+	if (tracker->stream != 0x0) {
+		tracker_stream_flush(tracker->stream);
+		tracker_stream_release(tracker->stream);
+	}
+	tracker->stream = 0x0;
+	if (address != 0x0) {
+		tracker->stream = tracker_stream_new(address, batch);
+		return tracker->stream != 0x0;
+	}
+	return 1;
+}
+
+int psmove_tracker_get_stream_statistics(PSMoveTracker *tracker, unsigned int *sent, unsigned int *dropped) {
+	if (tracker->stream == 0x0)
+		return 0;
+	tracker_stream_get_statistics(tracker->stream, sent, dropped);
+	return 1;
+}
+
+int psmove_tracker_subscribe(PSMoveTracker *tracker, PSMoveTrackerEventCallback callback, void *user_data) {
+	return tracker_events_subscribe(tracker->events, callback, user_data);
+}
+
+void psmove_tracker_unsubscribe(PSMoveTracker *tracker, PSMoveTrackerEventCallback callback, void *user_data) {
+	tracker_events_unsubscribe(tracker->events, callback, user_data);
+}
+
+void psmove_tracker_set_event_queue(PSMoveTracker *tracker, int capacity) {
+	tracker_events_set_queue(tracker->events, capacity);
+}
+
+int psmove_tracker_poll_event(PSMoveTracker *tracker, PSMoveTrackerEvent *event) {
+	return tracker_events_poll(tracker->events, event);
+}
+
 void psmove_tracker_free(PSMoveTracker *tracker) {
-	tracked_controller_save_colors(tracker->controllers);
+	psmove_tracker_save_colors(tracker);
 
-	if (th_file_exists(PSEYE_BACKUP_FILE))
+	frame_grabber_release(tracker->grabber);
+	exposure_control_release(tracker->exposure_control);
+	if (tracker->cc != 0x0 && th_file_exists(PSEYE_BACKUP_FILE))
 		camera_control_restore_sytem_settings(tracker->cc, PSEYE_BACKUP_FILE);
+	tracker_overlay_release(tracker->overlay);
+	tracker_shm_close(tracker->shm);
+	psmove_tracker_set_stream(tracker, 0x0, 0);
+	tracker_events_release(tracker->events);
 	hp_timer_release(tracker->timer);
+	stage_profiler_release(tracker->profiler);
+	flight_recorder_writer_release(tracker->recorder_writer);
+	flight_recorder_release(tracker->recorder);
+	free(tracker->recorder_dump_file);
 	cvReleaseMemStorage(&tracker->storage);
-	int i = 0;
-	for (; i < ROIS; i++) {
-		cvReleaseImage(&tracker->roiM[0]);
-		cvReleaseImage(&tracker->roiI[0]);
-	}
-	cvReleaseStructuringElement(&tracker->kCalib);
+	image_arena_release(tracker->arena);
+	bit_mask_blobs_release(tracker->blobs);
+	stripe_search_release(tracker->stripes);
+	tracker_pool_release(tracker->pool);
 	tracked_controller_release(&tracker->controllers, 1);
 	tracked_color_release(&tracker->available_colors, 1);
 }
 
 // -------- Implementation: internal functions only
-int psmove_tracker_adapt_to_light(PSMoveTracker *tracker, int lumMin, int expMin, int expMax) {
-	int exp = expMin;
-	// set the camera parameters to minimal exposure
-	camera_control_set_parameters(tracker->cc, 0, 0, 0, exp, 0, 0xffff, 0xffff, 0xffff, -1, -1);
-	IplImage* frame;
-	// calculate a stepsize to increase the exposure, so that not more than 5 steps are neccessary
-	int step = (expMax - expMin) / 10;
-	if (step == 0)
-		step = 1;
-	int lastExp = exp;
-	while (1) {
-		// wait a little for the new parameters to be applied
-		usleep(1000000 / 10);
-		frame = camera_control_query_frame(tracker->cc);
-		//}
-		if (!frame)
-			continue;
-
-		// calculate the average color
-		CvScalar avgColor = cvAvg(frame, 0x0);
-		// calculate the average luminance (energy)
-		float avgLum = th_avg(avgColor.val, 3);
-
-		printf("exp:%d: lum:%f\n", exp, avgLum);
-		// if the minimal luminance "limMin" has not been reached, increase the current exposure "exp"
-		if (avgLum < lumMin)
-			exp = exp + step;
-
-		// check exposure boundaries
-		if (exp < expMin)
-			exp = expMin;
-		if (exp > expMax)
-			exp = expMax;
-
-		// if the current exposure has been modified, apply it!
-		if (lastExp != exp) {
-			// reconfigure the camera
-			camera_control_set_parameters(tracker->cc, 0, 0, 0, exp, 0, 0xffff, 0xffff, 0xffff, -1, -1);
-			lastExp = exp;
-		} else
-			break;
-	}
-	printf("exposure set to %d(0x%x)\n", exp, exp);
-	return exp;
-}
-
-void psmove_tracker_get_diff(PSMoveTracker* tracker, PSMove* move, int r, int g, int b, IplImage* on, IplImage* diff, int delay) {
+IplImage* psmove_tracker_get_blink(PSMoveTracker* tracker, PSMove* move, int r, int g, int b, IplImage* on, int delay) {
 	int elapsedTime = 0;
 	int step = 10;
 	// the time to wait for the controller to set the color up
@@ -946,7 +1647,7 @@ void psmove_tracker_get_diff(PSMoveTracker* tracker, PSMove* move, int r, int g,
 	// take the first frame (sphere lit)
 	while (1) {
 		usleep(1000 * step);
-		frame = camera_control_query_frame(tracker->cc);
+		frame = psmove_tracker_query_frame(tracker);
 		// break if delay has been reached
 		if (elapsedTime >= delay)
 			break;
@@ -961,24 +1662,13 @@ void psmove_tracker_get_diff(PSMoveTracker* tracker, PSMove* move, int r, int g,
 	// take the second frame (sphere iff)
 	while (1) {
 		usleep(1000 * step);
-		frame = camera_control_query_frame(tracker->cc);
+		frame = psmove_tracker_query_frame(tracker);
 		// break if delay has been reached
 		if (elapsedTime >= delay * 2)
 			break;
 		elapsedTime += step;
 	}
-	// convert both to grayscale images
-	IplImage* grey1 = cvCloneImage(diff);
-	IplImage* grey2 = cvCloneImage(diff);
-	cvCvtColor(frame, grey1, CV_BGR2GRAY);
-	cvCvtColor(on, grey2, CV_BGR2GRAY);
-
-	// calculate the diff of to images and save it in "diff"
-	cvAbsDiff(grey1, grey2, diff);
-
-	// clean up
-	cvReleaseImage(&grey1);
-	cvReleaseImage(&grey2);
+	return frame;
 }
 
 void psmove_tracker_fix_roi(TrackedController* tc, int roi_width, int roi_height, int cam_width, int cam_height) {
@@ -1003,71 +1693,117 @@ void psmove_tracker_prepare_colors(PSMoveTracker* tracker) {
 
 }
 
-void psmove_tracker_draw_tracking_stats(PSMoveTracker* tracker) {
-	CvPoint p;
-	IplImage* frame = psmove_tracker_get_image(tracker);
+void psmove_tracker_publish_overlay(PSMoveTracker* tracker) {
+	TrackerOverlaySnapshot snapshot;
+	TrackedController* tc;
+	int i = 0;
+
+	snapshot.fps = tracker->debug_fps;
+	for (tc = tracker->controllers; tc != 0x0 && i < TRACKER_OVERLAY_MAX_CONTROLLERS; tc = tc->next, i++) {
+		TrackerOverlayController* oc = &snapshot.controller[i];
+		oc->is_tracked = tc->is_tracked;
+		oc->x = tc->x;
+		oc->y = tc->y;
+		oc->r = tc->r;
+		oc->roi = cvRect(tc->roi_x, tc->roi_y, tracker->roiI[tc->roi_level]->width, tracker->roiI[tc->roi_level]->height);
+		oc->color = tc->eColor;
+		oc->distance = psmove_tracker_get_distance(tracker, tc->r * 2);
+	}
+	snapshot.controllers = i;
+	tracker_overlay_publish(tracker->overlay, tracker->frame, &snapshot);
+}
 
-	float textSmall = 0.8;
-	float textNormal = 1;
-	char text[256];
-	CvScalar c;
-	CvScalar avgC;
-	float avgLum = 0;
-	int roi_w = 0;
-	int roi_h = 0;
+void psmove_tracker_publish_shm(PSMoveTracker* tracker, PSMove* move) {
+	TrackerShmFrame* f = &tracker->shm_frame;
+	TrackedController* tc;
+	int i = 0;
 
-	// general statistics
-	avgC = cvAvg(frame, 0x0);
-	avgLum = th_avg(avgC.val, 3);
-	cvRectangle(frame, cvPoint(0, 0), cvPoint(frame->width, 25), th_black, CV_FILLED, 8, 0);
-	sprintf(text, "fps:%.0f", tracker->debug_fps);
-	th_put_text(frame, text, cvPoint(10, 20), th_white, textNormal);
-	tracker->debug_fps = 0.85 * tracker->debug_fps + 0.15 * (1.0 / hp_timer_get_seconds(tracker->timer));
-	sprintf(text, "avg(lum):%.0f", avgLum);
-	th_put_text(frame, text, cvPoint(255, 20), th_white, textNormal);
+	f->frame = tracker->frame_no;
+	f->timestamp = tracker->frame_ns;
+	for (tc = tracker->controllers; tc != 0x0 && i < TRACKER_SHM_MAX_CONTROLLERS; tc = tc->next, i++) {
+		TrackerShmController* sc = &f->controller[i];
+		sc->color[0] = (uint8_t) tc->dColor.val[2];
+		sc->color[1] = (uint8_t) tc->dColor.val[1];
+		sc->color[2] = (uint8_t) tc->dColor.val[0];
+		if (move != 0x0 && tc->move != move)
+			continue;
+		sc->x = tc->x;
+		sc->y = tc->y;
+		sc->r = tc->r;
+		sc->is_tracked = tc->is_tracked;
+		sc->frame = tracker->frame_no;
+		sc->timestamp = tracker->frame_ns;
+	}
+	f->controllers = i;
+	tracker_shm_write(tracker->shm, f);
+}
 
+void psmove_tracker_publish_snapshot(PSMoveTracker* tracker) {
+	PSMoveTrackerSnapshot s;
 	TrackedController* tc;
-	// draw all/one controller information to camera image
-	tc = tracker->controllers;
-	for (; tc != 0x0 && tracker->frame; tc = tc->next) {
-		if (tc->is_tracked) {
-			// controller specific statistics
-			p.x = tc->x;
-			p.y = tc->y;
-			roi_w = tracker->roiI[tc->roi_level]->width;
-			roi_h = tracker->roiI[tc->roi_level]->height;
-			c = tc->eColor;
-
-			cvRectangle(frame, cvPoint(tc->roi_x, tc->roi_y), cvPoint(tc->roi_x + roi_w, tc->roi_y + roi_h), th_white, 3, 8, 0);
-			cvRectangle(frame, cvPoint(tc->roi_x, tc->roi_y), cvPoint(tc->roi_x + roi_w, tc->roi_y + roi_h), th_red, 1, 8, 0);
-			cvRectangle(frame, cvPoint(tc->roi_x, tc->roi_y - 45), cvPoint(tc->roi_x + roi_w, tc->roi_y - 5), th_black, CV_FILLED, 8, 0);
-
-			int vOff = 0;
-			if (roi_h == frame->height)
-				vOff = roi_h;
-			sprintf(text, "RGB:%x,%x,%x", (int) c.val[2], (int) c.val[1], (int) c.val[0]);
-			th_put_text(frame, text, cvPoint(tc->roi_x, tc->roi_y + vOff - 5), c, textSmall);
-
-			sprintf(text, "ROI:%dx%d", roi_w, roi_h);
-			th_put_text(frame, text, cvPoint(tc->roi_x, tc->roi_y + vOff - 15), c, textSmall);
-
-			double distance = psmove_tracker_get_distance(tracker, tc->r * 2);
-
-			sprintf(text, "radius: %.2f", tc->r);
-			th_put_text(frame, text, cvPoint(tc->roi_x, tc->roi_y + vOff - 35), c, textSmall);
-			sprintf(text, "dist: %.2fmm", distance);
-			th_put_text(frame, text, cvPoint(tc->roi_x, tc->roi_y + vOff - 25), c, textSmall);
-
-			cvCircle(frame, p, tc->r, th_white, 1, 8, 0);
-		}
+	int i = 0;
+
+	s.frame = tracker->frame_no;
+	s.timestamp = tracker->frame_ns;
+	for (tc = tracker->controllers; tc != 0x0 && i < SNAPSHOT_MAX_CONTROLLERS; tc = tc->next, i++) {
+		PSMoveTrackerControllerState* cs = &s.controller[i];
+		cs->move = tc->move;
+		cs->x = tc->x;
+		cs->y = tc->y;
+		cs->r = tc->r;
+		cs->cam_x = tc->cam_x;
+		cs->cam_y = tc->cam_y;
+		cs->cam_z = tc->cam_z;
+		cs->is_tracked = tc->is_tracked;
 	}
+	s.controllers = i;
+	// only the filled elements need to be copied
+	tracker_seqlock_write(&tracker->snapshot_sequence, &tracker->snapshot, &s,
+			offsetof(PSMoveTrackerSnapshot, controller) + i * sizeof(PSMoveTrackerControllerState));
+}
+
+int psmove_tracker_get_snapshot(PSMoveTracker *tracker, PSMoveTrackerControllerState *states, int max, unsigned int *frame, int64_t *timestamp) {
+	PSMoveTrackerSnapshot copy;
+
+	// the tracker has not been updated yet
+	if (!tracker_seqlock_read(&tracker->snapshot_sequence, &tracker->snapshot, &copy, sizeof(PSMoveTrackerSnapshot), 0))
+		return 0;
+
+	int n = MIN(copy.controllers, max);
+	if (n > 0)
+		memcpy(states, copy.controller, n * sizeof(PSMoveTrackerControllerState));
+	if (frame != 0x0)
+		*frame = copy.frame;
+	if (timestamp != 0x0)
+		*timestamp = copy.timestamp;
+	return n;
+}
+
+void psmove_tracker_publish_stream(PSMoveTracker* tracker) {
+	TrackerStreamFrame f;
+	TrackedController* tc;
+	int i = 0;
 
-	// every second save a debug-image to the filesystem
-	time_t now = time(0);
-	if (difftime(now, tracker->debug_last_live) > 1) {
-		psmove_trace_image(frame, "livefeed", tracker->debug_last_live);
-		tracker->debug_last_live = now;
+	f.frame = tracker->frame_no;
+	f.timestamp = tracker->frame_ns;
+	for (tc = tracker->controllers; tc != 0x0 && i < TRACKER_STREAM_MAX_CONTROLLERS; tc = tc->next, i++) {
+		TrackerStreamController* sc = &f.controller[i];
+		memset(sc, 0, sizeof(TrackerStreamController));
+		sc->x = tc->x;
+		sc->y = tc->y;
+		sc->r = tc->r;
+		sc->is_tracked = tc->is_tracked;
 	}
+	f.controllers = i;
+	tracker_stream_add(tracker->stream, &f);
+}
+
+int psmove_tracker_get_overlay(PSMoveTracker *tracker, IplImage *dst) {
+	if (tracker->overlay == 0x0)
+		tracker->overlay = tracker_overlay_new();
+	if (tracker->overlay == 0x0)
+		return 0;
+	return tracker_overlay_get(tracker->overlay, dst);
 }
 
 float psmove_tracker_hsvcolor_diff(TrackedController* tc) {
@@ -1078,6 +1814,34 @@ float psmove_tracker_hsvcolor_diff(TrackedController* tc) {
 	return diff;
 }
 
+int psmove_tracker_current_exposure(PSMoveTracker* t) {
+	if (t->exposure_control != 0x0)
+		return exposure_control_get_exposure(t->exposure_control);
+	return t->exposure;
+}
+
+void psmove_tracker_rebase_color(TrackedController* tc, int exposure) {
+	int i;
+	if (tc->cExposure <= 0 || exposure <= 0 || tc->exposure == exposure)
+		return;
+	float f = (float) exposure / tc->cExposure;
+	tc->eFColor = tc->cFColor;
+	for (i = 0; i < 3; i++)
+		tc->eFColor.val[i] = MIN(tc->cFColor.val[i] * f, 255);
+	tc->eFColorHSV = color_scalar_bgr2hsv(tc->eFColor);
+	tc->exposure = exposure;
+}
+
+void psmove_tracker_save_colors(PSMoveTracker* t) {
+	TrackedController* tc;
+	// colors found in recorded frames must not replace the ones of the camera
+	if (t->source != 0x0)
+		return;
+	for (tc = t->controllers; tc != 0x0; tc = tc->next)
+		psmove_tracker_rebase_color(tc, t->exposure);
+	tracked_controller_save_colors(t->controllers);
+}
+
 float psmove_tracker_get_distance(PSMoveTracker* t, float blob_diameter) {
 
 	// PS Eye uses OV7725 Chip --> http://image-sensors-world.blogspot.co.at/2010/10/omnivision-vga-sensor-inside-sony-eye.html
@@ -1088,8 +1852,35 @@ float psmove_tracker_get_distance(PSMoveTracker* t, float blob_diameter) {
 	 ---------------------------------------------------------------------------
 	 object height (pixels) * sensor height (mm)
 	 */
+	// the focal length in pixels (fx, fy) is the focal length divided by the pixel size (or taken from the calibration)
+	return ((t->fx + t->fy) * 0.5 * t->ps_move_diameter) / (blob_diameter + FLT_EPSILON);
+}
 
-	return (t->cam_focal_length * t->ps_move_diameter * t->user_factor_dist) / (blob_diameter * t->cam_pixel_height / 100.0 + FLT_EPSILON);
+void psmove_tracker_update_camera_position(PSMoveTracker* t, TrackedController* tc) {
+	float xn, yn;
+	if (t->intrinsic != 0x0) {
+		// undistort just the center, instead of remapping the whole frame
+		CvPoint2D32f src = cvPoint2D32f(tc->x, tc->y);
+		CvPoint2D32f dst;
+		CvMat src_m = cvMat(1, 1, CV_32FC2, &src);
+		CvMat dst_m = cvMat(1, 1, CV_32FC2, &dst);
+		cvUndistortPoints(&src_m, &dst_m, t->intrinsic, t->distortion, 0x0, 0x0);
+		xn = dst.x;
+		yn = dst.y;
+	} else {
+		xn = (tc->x - t->cx) / t->fx;
+		yn = (tc->y - t->cy) / t->fy;
+	}
+	tc->cam_z = psmove_tracker_get_distance(t, tc->r * 2);
+	tc->cam_x = xn * tc->cam_z;
+	tc->cam_y = yn * tc->cam_z;
+}
+
+void psmove_tracker_filter_in_stripes(PSMoveTracker* t, CvScalar min, CvScalar max) {
+	// color conversion and color filter run on all threads
+	psmove_profile_start(t->profiler, Tracker_STAGE_COLOR_CONVERSION);
+	stripe_search_run(t->stripes, t->frame, t->roiI[0], &t->roiM[0], min, max);
+	psmove_profile_stop(t->profiler, Tracker_STAGE_COLOR_CONVERSION);
 }
 
 void psmove_tracker_biggest_contour(IplImage* img, CvMemStorage* stor, CvSeq** resContour, float* resSize) {
@@ -1143,38 +1934,365 @@ void psmove_tracker_estimate_3d_pos(CvSeq* cont, CvPoint* center, float* radius)
 	*radius = sqrt(d) / 2;
 }
 
-CvPoint psmove_tracker_better_roi_center(TrackedController* tc, PSMoveTracker* t) {
-	CvPoint erg = cvPoint(-1, -1);
-	CvScalar min, max;
-	th_minus(tc->eColorHSV.val, t->rHSV.val, min.val, 3);
-	th_plus(tc->eColorHSV.val, t->rHSV.val, max.val, 3);
+int psmove_tracker_reacquire(PSMoveTracker* t, int tile, CvScalar min, CvScalar max, CvRect* candidates) {
+	IplImage* frame = t->frame;
+	IplImage* coarse = t->coarseM;
+	int d = t->reacquire_decimation;
+	int y0 = tile * coarse->height / REACQUIRE_TILES;
+	int y1 = (tile + 1) * coarse->height / REACQUIRE_TILES;
+	int x, y, i;
+	int lo[3], hi[3];
+	float sizes[REACQUIRE_CANDIDATES];
+	int n = 0;
+
+	color_range_bounds(min, max, lo, hi);
+
+	// apply the color filter to the rows of the tile while decimating
+	for (y = y0; y < y1; y++) {
+		const unsigned char* src = (const unsigned char*) frame->imageData + y * d * frame->widthStep;
+		unsigned char* dst = (unsigned char*) coarse->imageData + y * coarse->widthStep;
+		for (x = 0; x < coarse->width; x++, src += 3 * d)
+			dst[x] = color_in_range(src, lo, hi) ? 0xFF : 0;
+	}
+
+	// keep the biggest blobs, ordered by their size
+	CvSeq* contour;
+	cvSetImageROI(coarse, cvRect(0, y0, coarse->width, y1 - y0));
+	cvFindContours(coarse, t->storage, &contour, sizeof(CvContour), CV_RETR_LIST, CV_CHAIN_APPROX_SIMPLE, cvPoint(0, 0));
+	cvResetImageROI(coarse);
+	for (; contour != 0x0; contour = contour->h_next) {
+		float f = cvContourArea(contour, CV_WHOLE_SEQ, 0);
+		if (f <= 0 || (n == REACQUIRE_CANDIDATES && f <= sizes[n - 1]))
+			continue;
+		i = n < REACQUIRE_CANDIDATES ? n++ : n - 1;
+		for (; i > 0 && sizes[i - 1] < f; i--) {
+			sizes[i] = sizes[i - 1];
+			candidates[i] = candidates[i - 1];
+		}
+		sizes[i] = f;
+		candidates[i] = cvBoundingRect(contour, 0);
+		candidates[i].y += y0;
+	}
+	cvClearMemStorage(t->storage);
+	return n;
+}
+
+void psmove_tracker_place_roi_on_candidate(TrackedController* tc, PSMoveTracker* t, CvRect br) {
+	int d = t->reacquire_decimation;
+	int i;
+
+	// place a ROI on the candidate that is big enough for the sphere and its surroundings
+	int size = (MAX(br.width, br.height) + 2) * d * 2;
+	tc->roi_level = 0;
+	for (i = 0; i < ROIS; i++) {
+		if (size > t->roiI[i]->width || size > t->roiI[i]->height)
+			break;
+		tc->roi_level = i;
+	}
+	tc->roi_x = (br.x * 2 + br.width) * d / 2 - t->roiI[tc->roi_level]->width / 2;
+	tc->roi_y = (br.y * 2 + br.height) * d / 2 - t->roiI[tc->roi_level]->height / 2;
+	psmove_tracker_fix_roi(tc, t->roiI[tc->roi_level]->width, t->roiI[tc->roi_level]->height, t->roiI[0]->width, t->roiI[0]->height);
+}
+
+int psmove_tracker_schedule_reacquisition(PSMoveTracker* t, int n_lost) {
+	TrackedController* tc;
+	int64_t deadline = hp_timer_now_ns() + t->reacquire_budget * 1000LL;
+	int first = t->reacquire_next++ % n_lost;
+	int spheres_found = 0;
+	int tiles = 0;
+	int k = 0;
+	int pass, c;
+
+	// walk the list twice: the first pass starts with the "first"-th lost controller,
+	// the second one serves those that have been skipped
+	for (pass = 0; pass < 2; pass++) {
+		for (tc = t->controllers; tc != 0x0; tc = tc->next) {
+			if (!tc->reacquire_pending || (pass == 0 && k++ < first))
+				continue;
+			tc->reacquire_pending = 0;
+			tc->reacquire_searches++;
+
+			float q1 = 0, q2 = 0, q3 = 0;
+			int found = 0;
+			int searched = 0;
+			int64_t controller_ns = 0;
+			HP_TIMER_SCOPE(controller_ns) {
+				CvScalar min, max;
+				th_minus(tc->eColorHSV.val, t->rHSV.val, min.val, 3);
+				th_plus(tc->eColorHSV.val, t->rHSV.val, max.val, 3);
+
+				while (!found && searched < REACQUIRE_TILES && (tiles == 0 || hp_timer_now_ns() < deadline)) {
+					int tile = tc->reacquire_tile;
+					tc->reacquire_tile = (tile + 1) % REACQUIRE_TILES;
+					tiles++;
+					searched++;
+
+					psmove_profile_start(t->profiler, Tracker_STAGE_REACQUIRE);
+					CvRect candidates[REACQUIRE_CANDIDATES];
+					int n = psmove_tracker_reacquire(t, tile, min, max, candidates);
+					psmove_profile_stop(t->profiler, Tracker_STAGE_REACQUIRE);
+
+					// a candidate that is not the sphere must not change the state the next one is judged by
+					float x = tc->x, y = tc->y, r = tc->r, rs = tc->rs, mx = tc->mx, my = tc->my;
+					for (c = 0; c < n && !found; c++) {
+						tc->x = x;
+						tc->y = y;
+						tc->r = r;
+						tc->rs = rs;
+						tc->mx = mx;
+						tc->my = my;
+						psmove_tracker_place_roi_on_candidate(tc, t, candidates[c]);
+						found = psmove_tracker_update_controller(t, tc, &q1, &q2, &q3);
+					}
+				}
+			}
+
+			psmove_tracker_record_event(t, tc, found ? FR_EVENT_FOUND : FR_EVENT_NOT_FOUND, q1, q2, q3, controller_ns);
+			psmove_profile_commit(t->profiler, tc->slot);
+			psmove_tracker_emit_transition(t, tc, 0, found);
+			spheres_found += found;
+		}
+	}
+	return spheres_found;
+}
+
+void psmove_tracker_blob_statistics(IplImage* mask, IplImage* frame, CvRect br, PSMoveTrackerBlobStats* stats) {
+	CvRect roi = cvGetImageROI(frame);
+	int x, y;
+
+	memset(stats, 0, sizeof(PSMoveTrackerBlobStats));
+	for (y = br.y; y < br.y + br.height; y++) {
+		const unsigned char* m = (const unsigned char*) mask->imageData + y * mask->widthStep;
+		const unsigned char* p = (const unsigned char*) frame->imageData + (roi.y + y) * frame->widthStep + roi.x * 3;
+		// integer sums per row, they cannot overflow
+		unsigned int n = 0, sx = 0, sb = 0, sg = 0, sr = 0;
+		for (x = br.x; x < br.x + br.width; x++) {
+			if (m[x]) {
+				n++;
+				sx += x;
+				sb += p[3 * x];
+				sg += p[3 * x + 1];
+				sr += p[3 * x + 2];
+			}
+		}
+		stats->pixels += n;
+		stats->sx += sx;
+		stats->sy += (double) n * y;
+		stats->sbgr[0] += sb;
+		stats->sbgr[1] += sg;
+		stats->sbgr[2] += sr;
+	}
+}
 
+void psmove_tracker_filter_roi(PSMoveTracker* t, TrackedController* tc, CvRect rect, CvScalar min, CvScalar max) {
 	IplImage *roi_i = t->roiI[tc->roi_level];
-	IplImage *roi_m = t->roiM[tc->roi_level];
 
-	// cut out the roi!
-	cvSetImageROI(t->frame, cvRect(tc->roi_x, tc->roi_y, roi_i->width, roi_i->height));
-	cvCvtColor(t->frame, roi_i, CV_BGR2HSV);
+	// cut out the rectangle
+	psmove_profile_start(t->profiler, Tracker_STAGE_COLOR_CONVERSION);
+	color_bgr2hsv_image(t->frame, cvRect(tc->roi_x + rect.x, tc->roi_y + rect.y, rect.width, rect.height), roi_i, cvPoint(rect.x, rect.y));
+	psmove_profile_stop(t->profiler, Tracker_STAGE_COLOR_CONVERSION);
 
 	// apply color filter
-	cvInRangeS(roi_i, min, max, roi_m);
-	cvSmooth(roi_i, roi_i, CV_GAUSSIAN, 5, 5, 0, 0);
+	psmove_profile_start(t->profiler, Tracker_STAGE_RANGE_FILTER);
+	bit_mask_in_range(&t->roiM[tc->roi_level], rect, roi_i, min, max);
+	psmove_profile_stop(t->profiler, Tracker_STAGE_RANGE_FILTER);
+}
+
+int psmove_tracker_roi_decimation(PSMoveTracker* t, TrackedController* tc) {
+	int d = 1;
+	// the radius of the last frame is the expected radius
+	if (!tc->is_tracked)
+		return d;
+	while (d * 2 <= t->roi_decimation_max && tc->r >= d * 2 * t->roi_decimation_radius)
+		d *= 2;
+	return d;
+}
+
+void psmove_tracker_filter_roi_decimated(PSMoveTracker* t, TrackedController* tc, int d, CvScalar min, CvScalar max) {
+	BitMask* roi_m = &t->roiM[tc->roi_level];
+	CvRect roi = cvRect(tc->roi_x, tc->roi_y, roi_m->width, roi_m->height);
+	int lo[3], hi[3];
 
+	color_range_bounds(min, max, lo, hi);
+
+	// the conversion to HSV is part of the classification
+	psmove_profile_start(t->profiler, Tracker_STAGE_COLOR_CONVERSION);
+	decimated_mask_cells(t->frame, roi, d, lo, hi, &t->decM);
+	psmove_profile_stop(t->profiler, Tracker_STAGE_COLOR_CONVERSION);
+
+	psmove_profile_start(t->profiler, Tracker_STAGE_RANGE_FILTER);
+	decimated_mask_refine(t->frame, roi, d, lo, hi, &t->decM, &t->decI, &t->decO, &t->decT, roi_m);
+	psmove_profile_stop(t->profiler, Tracker_STAGE_RANGE_FILTER);
+}
+
+CvSeq* psmove_tracker_find_blob(PSMoveTracker* t, TrackedController* tc) {
+	BitMask* roi_m = &t->roiM[tc->roi_level];
+	IplImage* roi_s = t->roiS[tc->roi_level];
 	float sizeBest = 0;
 	CvSeq* contourBest = 0x0;
-	psmove_tracker_biggest_contour(roi_m, t->storage, &contourBest, &sizeBest);
-	if (contourBest) {
-		cvSet(roi_m, th_black, 0x0);
-		cvDrawContours(roi_m, contourBest, th_white, th_white, -1, CV_FILLED, 8, cvPoint(0, 0));
-		// calucalte image-moments to estimate the better ROI center
-		CvMoments mu;
-		cvMoments(roi_m, &mu, 0);
-
-		erg = cvPoint(mu.m10 / mu.m00, mu.m01 / mu.m00);
-		erg.x = erg.x + tc->roi_x - roi_m->width / 2;
-		erg.y = erg.y + tc->roi_y - roi_m->height / 2;
+	CvSeq* contour;
+	int i;
+
+	// the area of a contour is smaller than the area of the bounding box of its blob, and the blobs
+	// are ordered by the latter: once it is not bigger than the best contour, no other blob can win
+	psmove_profile_start(t->profiler, Tracker_STAGE_CONTOURS);
+	int blobs = bit_mask_blobs_find(t->blobs, roi_m, cvRect(0, 0, roi_m->width, roi_m->height));
+	for (i = 0; i < blobs; i++) {
+		const BitMaskBlob* blob = bit_mask_blobs_get(t->blobs, i);
+		if (blob->bbox.width * blob->bbox.height <= sizeBest)
+			break;
+
+		// trace the blob alone, with a background border around it (as cvFindContours ignores the outermost pixels);
+		// cvFindContours does not look beyond the ROI, so only the bounding box and its border need to be cleared
+		CvRect rect = cvRect(blob->bbox.x - 1, blob->bbox.y - 1, blob->bbox.width + 2, blob->bbox.height + 2);
+		cvSetImageROI(roi_s, rect);
+		cvSetZero(roi_s);
+		bit_mask_blobs_draw(t->blobs, i, roi_s);
+		cvFindContours(roi_s, t->storage, &contour, sizeof(CvContour), CV_RETR_LIST, CV_CHAIN_APPROX_SIMPLE, cvPoint(rect.x, rect.y));
+		for (; contour != 0x0; contour = contour->h_next) {
+			float f = cvContourArea(contour, CV_WHOLE_SEQ, 0);
+			if (f > sizeBest) {
+				sizeBest = f;
+				contourBest = contour;
+			}
+		}
+		cvResetImageROI(roi_s);
 	}
-	cvClearMemStorage(t->storage);
-	cvResetImageROI(t->frame);
-	return erg;
+	psmove_profile_stop(t->profiler, Tracker_STAGE_CONTOURS);
+	return contourBest;
+}
+
+void psmove_tracker_trace_mask(PSMoveTracker* t, BitMask* mask, int index, char* target) {
+#ifdef USE_TRACKER_TRACE
+	bit_mask_to_image(mask, t->calib_trace);
+	psmove_html_trace_image_at(t->calib_trace, index, target);
+#endif
+}
+
+int psmove_tracker_center_roi_on_blob(TrackedController* tc, PSMoveTracker* t, CvRect blob, CvScalar min, CvScalar max) {
+	BitMask *roi_m = &t->roiM[tc->roi_level];
+	int w = roi_m->width;
+	int h = roi_m->height;
+
+	// a blob that does not touch the border is fully visible
+	if (blob.x > 0 && blob.y > 0 && blob.x + blob.width < w && blob.y + blob.height < h)
+		return 0;
+
+	int old_x = tc->roi_x;
+	int old_y = tc->roi_y;
+	tc->roi_x += blob.x + blob.width / 2 - w / 2;
+	tc->roi_y += blob.y + blob.height / 2 - h / 2;
+	psmove_tracker_fix_roi(tc, w, h, t->roiI[0]->width, t->roiI[0]->height);
+	int dx = tc->roi_x - old_x;
+	int dy = tc->roi_y - old_y;
+	if (dx == 0 && dy == 0)
+		return 0;
+
+	if (abs(dx) >= w || abs(dy) >= h) {
+		// nothing of the old ROI is covered anymore
+		psmove_tracker_filter_roi(t, tc, cvRect(0, 0, w, h), min, max);
+		return 1;
+	}
+
+	// move the still covered part of the mask to its new position
+	psmove_profile_start(t->profiler, Tracker_STAGE_RANGE_FILTER);
+	bit_mask_shift(roi_m, dx, dy);
+	psmove_profile_stop(t->profiler, Tracker_STAGE_RANGE_FILTER);
+
+	// filter the newly uncovered rows and columns (the corner is part of the rows)
+	if (dy > 0)
+		psmove_tracker_filter_roi(t, tc, cvRect(0, h - dy, w, dy), min, max);
+	else if (dy < 0)
+		psmove_tracker_filter_roi(t, tc, cvRect(0, 0, w, -dy), min, max);
+	int rows_y = dy < 0 ? -dy : 0;
+	int rows_h = h - abs(dy);
+	if (dx > 0)
+		psmove_tracker_filter_roi(t, tc, cvRect(w - dx, rows_y, dx, rows_h), min, max);
+	else if (dx < 0)
+		psmove_tracker_filter_roi(t, tc, cvRect(0, rows_y, -dx, rows_h), min, max);
+	return 1;
+}
+
+int psmove_tracker_controller_index(PSMoveTracker* t, TrackedController* tc) {
+	// there are only a few controllers, a linear search is fine
+	int index = 0;
+	TrackedController* tmp = t->controllers;
+	for (; tmp != 0x0; tmp = tmp->next, index++) {
+		if (tmp == tc)
+			return index;
+	}
+	return -1;
+}
+
+void psmove_tracker_assign_slot(PSMoveTracker* t, TrackedController* tc) {
+	TrackedController* tmp;
+	int slot;
+	tc->slot = -1;
+	for (slot = 0; slot < PROFILER_CONTROLLERS; slot++) {
+		for (tmp = t->controllers; tmp != 0x0 && tmp->slot != slot; tmp = tmp->next)
+			;
+		if (tmp == 0x0)
+			break;
+	}
+	if (slot < PROFILER_CONTROLLERS) {
+		tc->slot = slot;
+		stage_profiler_reset(t->profiler, slot);
+	}
+}
+
+void psmove_tracker_record_event(PSMoveTracker* t, TrackedController* tc, int type, float q1, float q2, float q3, int64_t nanos) {
+	int i;
+	int index = tc->slot;
+
+	FlightRecorderEvent* e = flight_recorder_next(t->recorder);
+	e->frame = t->frame_no;
+	e->time_ms = (hp_timer_now_ns() - t->created_ns) / 1000000;
+	e->type = type;
+	e->controller = index >= 0 ? index : FLIGHT_RECORDER_NO_CONTROLLER;
+	e->roi_level = tc->roi_level;
+	e->color[0] = tc->eColor.val[0];
+	e->color[1] = tc->eColor.val[1];
+	e->color[2] = tc->eColor.val[2];
+	e->roi_x = tc->roi_x;
+	e->roi_y = tc->roi_y;
+	e->roi_w = t->roiI[tc->roi_level]->width;
+	e->roi_h = t->roiI[tc->roi_level]->height;
+	e->x = tc->x;
+	e->y = tc->y;
+	e->r = tc->r;
+	e->q1 = q1;
+	e->q2 = q2;
+	e->q3 = q3;
+	e->duration_us = nanos / 1000;
+
+	// the stages measured so far for this controller (not yet committed to the profiler)
+	for (i = 0; i < FLIGHT_RECORDER_STAGES && i < Tracker_STAGE_COUNT; i++) {
+		int64_t us = stage_profiler_get_current(t->profiler, i) / 1000;
+		e->stage_us[i] = us < 0xFFFF ? us : 0xFFFF;
+	}
+}
+
+void psmove_tracker_emit_event(PSMoveTracker* t, TrackedController* tc, enum PSMoveTracker_Event type, int64_t timestamp) {
+	// checked first, so that nobody listening costs nothing on the hot path
+	if (!tracker_events_is_wanted(t->events) || psmove_tracker_controller_index(t, tc) < 0)
+		return;
+
+	PSMoveTrackerEvent e;
+	e.type = type;
+	e.move = tc->move;
+	e.frame = t->frame_no;
+	e.timestamp = timestamp;
+	e.x = tc->x;
+	e.y = tc->y;
+	e.r = tc->r;
+	tracker_events_emit(t->events, &e);
+}
+
+void psmove_tracker_emit_transition(PSMoveTracker* t, TrackedController* tc, int was_tracked, int found) {
+	if (was_tracked && !found)
+		psmove_tracker_emit_event(t, tc, Tracker_EVENT_LOST, t->frame_ns);
+	else if (!was_tracked && found)
+		psmove_tracker_emit_event(t, tc, tc->found_once ? Tracker_EVENT_REACQUIRED : Tracker_EVENT_FOUND, t->frame_ns);
+	if (found)
+		tc->found_once = 1;
 }
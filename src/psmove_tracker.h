@@ -29,16 +29,33 @@
  * POSSIBILITY OF SUCH DAMAGE.
  **/
 
+#include <stdint.h>
+
 #include "psmove.h"
 #include "opencv2/core/types_c.h"
 
-/* Defines the range of x/y values for the position getting, etc.. */
+/* Defines the range of x/y values for the position getting, etc. at the
+ * default resolution (see psmove_tracker_get_size() for other modes) */
 #define PSMOVE_TRACKER_POSITION_X_MAX 640
 #define PSMOVE_TRACKER_POSITION_Y_MAX 480
 
 /* For now, we only allow 1 controller to be tracked */
 #define PSMOVE_TRACKER_MAX_CONTROLLERS 2
 
+/* Stages of psmove_tracker_update that are profiled individually */
+enum PSMoveTracker_Stage {
+    Tracker_STAGE_COLOR_CONVERSION, /* conversion of the ROI to HSV */
+    Tracker_STAGE_RANGE_FILTER, /* color filter applied to the ROI */
+    Tracker_STAGE_CONTOURS, /* contour/blob extraction */
+    Tracker_STAGE_MOMENTS, /* image moments and pixel count of the blob */
+    Tracker_STAGE_RADIUS, /* estimation of the radius */
+    Tracker_STAGE_ROI_RETRIES, /* searches on bigger ROI levels (includes the stages above) */
+    Tracker_STAGE_COLOR_ADAPTION, /* adaptive color estimation */
+    Tracker_STAGE_OVERLAY, /* hand-over of the results to the overlay (not per controller) */
+    Tracker_STAGE_REACQUIRE, /* search of a lost sphere on the decimated frame */
+    Tracker_STAGE_COUNT,
+};
+
 /* Opaque data structure, defined only in psmove_tracker.c */
 struct _PSMoveTracker;
 typedef struct _PSMoveTracker PSMoveTracker;
@@ -53,6 +70,47 @@ enum PSMoveTracker_Status {
     Tracker_CALIBRATED_AND_NOT_FOUND,
 };
 
+/* Transitions of a controller, reported by psmove_tracker_subscribe() */
+enum PSMoveTracker_Event {
+    Tracker_EVENT_CALIBRATED, /* the controller has been enabled */
+    Tracker_EVENT_FOUND, /* the sphere has been found for the first time */
+    Tracker_EVENT_LOST, /* the sphere has been tracked, but is not found anymore */
+    Tracker_EVENT_REACQUIRED, /* the sphere has been found again after it was lost */
+    Tracker_EVENT_COLOR_ADAPTED, /* the estimated color of the sphere has been adapted */
+    Tracker_EVENT_COLOR_RESET, /* the adapted color drifted too far and has been reset */
+};
+
+/* A transition of a controller */
+typedef struct {
+    enum PSMoveTracker_Event type;
+    PSMove *move; /* the controller */
+    unsigned int frame; /* number of the frame the event happened in */
+    int64_t timestamp; /* monotonic capture time of that frame (in nano-seconds) */
+    float x, y, r; /* position and radius of the sphere at the time of the event */
+} PSMoveTrackerEvent;
+
+/**
+ * Function that is called for every event of the tracker
+ *
+ * The function is called from the thread that runs psmove_tracker_update()
+ * (or psmove_tracker_enable()), while the tracker processes the frame, so
+ * it should return quickly. It must not call any other function of the
+ * tracker except psmove_tracker_subscribe()/psmove_tracker_unsubscribe().
+ *
+ * event - The event (only valid during the call)
+ * user_data - The pointer passed to psmove_tracker_subscribe()
+ **/
+typedef void (*PSMoveTrackerEventCallback)(const PSMoveTrackerEvent *event,
+        void *user_data);
+
+/* State of a controller, as returned by psmove_tracker_get_snapshot() */
+typedef struct {
+    PSMove *move; /* the controller */
+    float x, y, r; /* position and radius of the sphere (in pixels) */
+    float cam_x, cam_y, cam_z; /* position of the sphere's center in camera space (in mm) */
+    int is_tracked; /* 1 if the sphere has been found in the last update */
+} PSMoveTrackerControllerState;
+
 /**
  * Create a new PS Move tracker and set up tracking
  *
@@ -69,6 +127,55 @@ psmove_tracker_new();
 PSMoveTracker *
 psmove_tracker_new_with_camera(int camera);
 
+/**
+ * Create a new PS Move tracker with a given resolution and frame rate
+ *
+ * The PS Eye delivers 640x480 at up to 75 fps and 320x240 at up to
+ * 187 fps: a lower resolution trades precision for a lower latency
+ * per frame (e.g. for fast gestures). The driver may choose the
+ * nearest mode it supports, the tracker adapts to the size of the
+ * frames it receives (see psmove_tracker_get_size()). If the tracker
+ * reads the raw Bayer mosaic of the camera (CAMERA_RAW_BAYER), its
+ * frames have half the requested resolution.
+ *
+ * camera - The index of the camera
+ * width, height - The requested resolution (e.g. 320x240)
+ * fps - The requested frame rate
+ *
+ * Returns a new PSMoveTracker * instance or NULL (indicates error)
+ **/
+PSMoveTracker *
+psmove_tracker_new_with_camera_mode(int camera, int width, int height,
+        int fps);
+
+
+/**
+ * Function that delivers frames to the tracker instead of a camera
+ *
+ * user_data - The pointer passed to psmove_tracker_new_with_frame_source()
+ *
+ * Returns: the next frame (owned by the frame source), or NULL if no
+ *          frame is available yet
+ **/
+typedef IplImage* (*PSMoveTrackerFrameSource)(void *user_data);
+
+/**
+ * Create a new PS Move tracker that reads its frames from a function
+ *
+ * No camera is opened. This is used to run the tracker on recorded or
+ * synthetic frames (e.g. for benchmarks and regression tests). The
+ * function is called until it returns the first frame, the tracker is
+ * not created if it does not deliver one. The colors found while
+ * calibrating are not saved for the camera.
+ *
+ * source - The function that delivers the frames
+ * user_data - Passed to every call of "source"
+ *
+ * Returns a new PSMoveTracker * instance or NULL (indicates error)
+ **/
+PSMoveTracker *
+psmove_tracker_new_with_frame_source(PSMoveTrackerFrameSource source,
+        void *user_data);
 
 /**
  * Enable tracking for a given PSMove * instance
@@ -107,6 +214,21 @@ psmove_tracker_enable_with_color(PSMoveTracker *tracker, PSMove *move,
         unsigned char r, unsigned char g, unsigned char b);
 
 
+/**
+ * Enable tracking with a sphere color that is known to the camera
+ *
+ * Skips the calibration (no LEDs are set, no frames are captured) and
+ * uses the given color as the color of the sphere as seen by the camera.
+ * This is meant for frame sources with known content. The PSMove *
+ * is only used as a handle and is never dereferenced.
+ *
+ * Returns: Tracker_CALIBRATED, or Tracker_CALIBRATION_ERROR if the
+ *          color is already in use by another controller
+ **/
+enum PSMoveTracker_Status
+psmove_tracker_enable_with_known_color(PSMoveTracker *tracker, PSMove *move,
+        unsigned char r, unsigned char g, unsigned char b);
+
 /**
  * Get the current sphere color of a given controller
  *
@@ -119,6 +241,19 @@ int
 psmove_tracker_get_color(PSMoveTracker *tracker, PSMove *move,
         unsigned char *r, unsigned char *g, unsigned char *b);
 
+/**
+ * Get the sphere color of a given controller as seen by the camera
+ *
+ * This is the color estimated during calibration; it can be passed to
+ * psmove_tracker_enable_with_known_color() when frames are replayed.
+ *
+ * Returns nonzero if the color was successfully returned, zero if
+ * the controller is not enabled.
+ **/
+int
+psmove_tracker_get_camera_color(PSMoveTracker *tracker, PSMove *move,
+        unsigned char *r, unsigned char *g, unsigned char *b);
+
 
 /**
  * Disable tracking for a given PSMove * instance
@@ -154,6 +289,10 @@ psmove_tracker_get_status(PSMoveTracker *tracker, PSMove *move);
  * move - A valid PSMove * instance (if only one controller should
  *        be updated), or NULL to update all enabled controllers
  *
+ * Tracked controllers are updated first. Lost controllers are searched
+ * for afterwards, within a fixed time budget per frame; a search that
+ * does not fit into the budget is continued in the following frames.
+ *
  * Returns: nonzero if tracking was successful (sphere found), zero otherwise
  **/
 int
@@ -179,6 +318,18 @@ psmove_tracker_get_image(PSMoveTracker *tracker);
 void
 psmove_tracker_update_image(PSMoveTracker *tracker);
 
+/**
+ * Get the size of the frames the tracker works on
+ *
+ * The positions returned by psmove_tracker_get_position() are within
+ * this size, which depends on the mode of the camera.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * width, height - Pointers to store the size (can be NULL)
+ **/
+void
+psmove_tracker_get_size(PSMoveTracker *tracker, int *width, int *height);
+
 /**
  * Get the currently-tracked low-level position of the controllers
  *
@@ -194,6 +345,313 @@ int
 psmove_tracker_get_position(PSMoveTracker *tracker,
         PSMove *move, float *x, float *y, float *radius);
 
+/**
+ * Get the position of the sphere's center in camera space
+ *
+ * The position is calculated from the position and the radius of the
+ * sphere in the image, using the camera calibration (Intrinsics.xml and
+ * Distortion.xml) if it is available. The X axis points to the right,
+ * the Y axis down and the Z axis away from the camera. The position is
+ * kept while the sphere is not found.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * move - A valid (and enabled, with status Tracker_CALIBRATED) controller
+ * x - A pointer to a float for storing the X coordinate (in mm), or NULL
+ * y - A pointer to a float for storing the Y coordinate (in mm), or NULL
+ * z - A pointer to a float for storing the Z coordinate (in mm), or NULL
+ *
+ * Returns: nonzero on success, zero if the controller is not enabled
+ **/
+int
+psmove_tracker_get_camera_position(PSMoveTracker *tracker,
+        PSMove *move, float *x, float *y, float *z);
+
+/**
+ * Get the state of all enabled controllers as of the last update
+ *
+ * The states are published at the end of every call of
+ * psmove_tracker_update(). If only a single controller has been updated,
+ * the states of the others are those of their own last update. A
+ * controller that has been disabled is reported until the next update.
+ * This function may be called from any thread while the tracker is
+ * running; it never blocks the tracker (if an update is published
+ * during the copy, the copy is simply repeated).
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * states - An array for storing the states of the controllers
+ * max - The number of elements of "states"
+ * frame - A pointer to an unsigned int for storing the frame number, or NULL
+ * timestamp - A pointer to an int64_t for storing the monotonic capture
+ *             time of the frame (in nano-seconds), or NULL
+ *
+ * Returns: the number of states stored in "states"
+ **/
+int
+psmove_tracker_get_snapshot(PSMoveTracker *tracker,
+        PSMoveTrackerControllerState *states, int max,
+        unsigned int *frame, int64_t *timestamp);
+
+
+/**
+ * Get a copy of the camera image with the tracking results drawn on it
+ *
+ * The overlay is rendered on a copy of the camera image by a background
+ * thread, which is started by the first call. Every call asks the
+ * tracker to hand over the results of its next psmove_tracker_update;
+ * the tracker does not spend any time on the overlay while nobody asks
+ * for it and never draws into the image it tracks on.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * dst - An image of the size of the camera image (8 bit, 3 channels)
+ *
+ * Returns: nonzero if a new overlay has been copied to dst, zero if no
+ *          overlay has been rendered since the last call
+ **/
+int
+psmove_tracker_get_overlay(PSMoveTracker *tracker, IplImage *dst);
+
+/**
+ * Get the number of times the region of interest (ROI) of a controller
+ * had to be enlarged, because the sphere was not found in it
+ *
+ * Every enlargement means another search in the same frame; a search on
+ * the whole image is the last fallback. The counters start when the
+ * controller is enabled. With the decimated reacquisition (the default),
+ * ROIs are never enlarged: a sphere that is not found in its ROI is left
+ * to the reacquisition, see psmove_tracker_get_reacquisition_statistics().
+ *
+ * fallbacks - A pointer to an int for storing the number of enlargements, or NULL
+ * full_searches - A pointer to an int for storing the number of searches
+ *                 on the whole image, or NULL
+ *
+ * Returns nonzero on success, zero if the controller is not enabled
+ **/
+int
+psmove_tracker_get_roi_statistics(PSMoveTracker *tracker, PSMove *move,
+        int *fallbacks, int *full_searches);
+
+/**
+ * Get the number of times a controller's sphere had to be reacquired
+ *
+ * A sphere that is not found in its ROI is handed over to the
+ * reacquisition, which searches lost spheres on a decimated frame within
+ * a time budget per frame. The counters start when the controller is
+ * enabled; they stay 0 if the reacquisition is disabled.
+ *
+ * handoffs - A pointer to an int for storing the number of times the
+ *            sphere was not found in its ROI and has been handed over, or NULL
+ * searches - A pointer to an int for storing the number of frames in which
+ *            the reacquisition searched the sphere, or NULL
+ *
+ * Returns nonzero on success, zero if the controller is not enabled
+ **/
+int
+psmove_tracker_get_reacquisition_statistics(PSMoveTracker *tracker, PSMove *move,
+        int *handoffs, int *searches);
+
+/**
+ * Get the statistics of the camera capture
+ *
+ * The camera is read on its own thread, and only the newest frame is
+ * processed: if the tracker falls behind the camera, frames are dropped
+ * instead of queueing up. The queueing delay is the time between the
+ * arrival of a frame and psmove_tracker_update_image() taking it.
+ *
+ * processed - A pointer to an unsigned int for storing the number of
+ *             frames that have been taken by the tracker, or NULL
+ * dropped - A pointer to an unsigned int for storing the number of
+ *           frames that have been dropped, or NULL
+ * delay_avg - A pointer to a float for storing the smoothed queueing
+ *             delay (in ms), or NULL
+ * delay_max - A pointer to a float for storing the maximal queueing
+ *             delay (in ms), or NULL
+ *
+ * Returns nonzero on success, zero if the tracker does not read a
+ * camera on its own thread (e.g. it reads from a frame source)
+ **/
+int
+psmove_tracker_get_capture_statistics(PSMoveTracker *tracker,
+        unsigned int *processed, unsigned int *dropped,
+        float *delay_avg, float *delay_max);
+
+/**
+ * Get the number of heap allocations made for the tracker's images
+ *
+ * All images of the tracker (regions of interest, masks, calibration
+ * and scratch buffers) are taken from a single allocation that is made
+ * when the tracker is created, so this stays at 1 while tracking and
+ * calibrating. A larger value means that the images did not fit into
+ * that allocation (debugging aid).
+ *
+ * tracker - A valid PSMoveTracker * instance
+ *
+ * Returns the number of heap allocations
+ **/
+unsigned int
+psmove_tracker_get_image_allocations(PSMoveTracker *tracker);
+
+/**
+ * Get timing statistics of a single stage of psmove_tracker_update
+ *
+ * The statistics are calculated over the most recent frames in which
+ * the stage has been executed. All values are in micro-seconds.
+ * Profiling can be compiled away (see USE_STAGE_PROFILER in the makefile), in which
+ * case no samples are available.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * move - A valid (and enabled) controller, or NULL for stages that
+ *        are not specific to a controller (Tracker_STAGE_OVERLAY)
+ * stage - The stage to query
+ * p50 - A pointer to a float for storing the median, or NULL
+ * p99 - A pointer to a float for storing the 99th percentile, or NULL
+ * max - A pointer to a float for storing the maximum, or NULL
+ *
+ * This function may be called from any thread, e.g. a monitoring
+ * thread, while another thread calls psmove_tracker_update(). It must
+ * not run while controllers are enabled or disabled.
+ *
+ * Returns: the number of samples the statistics are based on
+ **/
+int
+psmove_tracker_get_stage_timing(PSMoveTracker *tracker, PSMove *move,
+        enum PSMoveTracker_Stage stage, float *p50, float *p99, float *max);
+
+/**
+ * Writes the content of the tracker's flight recorder to a file
+ *
+ * The flight recorder is an in-memory ring buffer that always holds
+ * the most recent per frame/controller tracking events (ROI, quality,
+ * radius, color adaption and timing). Use "FlightRecorderDecoder" to
+ * convert the binary file to CSV or JSON.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * file - The path of the file to write
+ *
+ * Returns: the number of written events, or -1 on error
+ **/
+int
+psmove_tracker_dump_flight_recorder(PSMoveTracker *tracker, const char* file);
+
+/**
+ * Automatically dump the flight recorder whenever a controller is lost
+ *
+ * At most one dump per second is written, each one overwriting
+ * the previous dump. The dumps are written on a background thread
+ * from a copy of the events, so that tracking does not wait for the
+ * file system.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * file - The path of the file to write, or NULL to disable automatic dumps
+ **/
+void
+psmove_tracker_set_dump_on_loss(PSMoveTracker *tracker, const char* file);
+
+/**
+ * Publish the results of every frame in a shared memory segment
+ *
+ * After each psmove_tracker_update(), the position, radius and status
+ * of every controller are written to the segment, together with the
+ * frame number and a timestamp. Other processes read them with
+ * tracker_shm_open() and tracker_shm_read() (see shm/tracker_shm.h),
+ * without ever blocking the tracker.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * name - The name of the segment (e.g. TRACKER_SHM_DEFAULT_NAME),
+ *        or NULL to stop publishing
+ *
+ * Returns nonzero on success, zero if the segment could not be created
+ **/
+int
+psmove_tracker_set_shared_memory(PSMoveTracker *tracker, const char* name);
+
+/**
+ * Stream the results of every frame to another process on the same host
+ *
+ * The position, radius and status of all controllers are sent as
+ * binary packets (see stream/tracker_stream.h) over a Unix domain
+ * socket or loopback UDP. Sending never blocks: if the receiver does
+ * not keep up, packets are dropped and counted.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * address - "unix:<path>" or "udp:<port>", or NULL to stop streaming
+ * batch - The number of frames sent per packet (1 for the lowest latency)
+ *
+ * Returns nonzero on success, zero if the socket could not be created
+ **/
+int
+psmove_tracker_set_stream(PSMoveTracker *tracker, const char* address, int batch);
+
+/**
+ * Get the number of packets that have been streamed and the number of
+ * frames that have been dropped, because the receiver did not keep up
+ * (or was not running)
+ *
+ * sent - A pointer to an unsigned int for storing the number of packets, or NULL
+ * dropped - A pointer to an unsigned int for storing the number of frames, or NULL
+ *
+ * Returns nonzero on success, zero if streaming is disabled
+ **/
+int
+psmove_tracker_get_stream_statistics(PSMoveTracker *tracker,
+        unsigned int *sent, unsigned int *dropped);
+
+/**
+ * Register a function that is called for every event of the tracker
+ *
+ * Events are reported when a controller has been calibrated, when its
+ * sphere is found, lost or found again and when its estimated color is
+ * adapted or reset. This replaces polling psmove_tracker_get_status()
+ * after every frame.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * callback - The function to call
+ * user_data - Passed to every call of "callback"
+ *
+ * Returns nonzero on success, zero if too many functions are registered
+ **/
+int
+psmove_tracker_subscribe(PSMoveTracker *tracker,
+        PSMoveTrackerEventCallback callback, void *user_data);
+
+/**
+ * Unregister a function registered with psmove_tracker_subscribe()
+ *
+ * Once this returns, the function is not called anymore, so user_data
+ * may be freed. If an event is being delivered on another thread, this
+ * waits until the function has returned; so it must not be called
+ * while holding a lock that the function takes.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * callback - The function passed to psmove_tracker_subscribe()
+ * user_data - The pointer passed to psmove_tracker_subscribe()
+ **/
+void
+psmove_tracker_unsubscribe(PSMoveTracker *tracker,
+        PSMoveTrackerEventCallback callback, void *user_data);
+
+/**
+ * Queue the events of the tracker, so that another thread can poll them
+ *
+ * If the queue is full, its oldest event is dropped.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * capacity - The maximum number of queued events, or 0 to disable the queue
+ **/
+void
+psmove_tracker_set_event_queue(PSMoveTracker *tracker, int capacity);
+
+/**
+ * Take the oldest event from the queue (see psmove_tracker_set_event_queue())
+ *
+ * This function never blocks and may be called from any thread.
+ *
+ * tracker - A valid PSMoveTracker * instance
+ * event - A pointer to a PSMoveTrackerEvent for storing the event
+ *
+ * Returns nonzero if an event has been stored, zero if the queue is empty
+ **/
+int
+psmove_tracker_poll_event(PSMoveTracker *tracker, PSMoveTrackerEvent *event);
 
 /**
  * Destroy an existing tracker instance and free allocated resources
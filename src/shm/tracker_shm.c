@@ -0,0 +1,149 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "tracker_shm.h"
+#include "../thread/tracker_seqlock.h"
+
+#define SHM_READ_RETRIES 1000 // number of attempts to get a consistent copy before giving up
+
+struct _TrackerShm {
+	TrackerShmSegment* segment; // the mapped segment
+	int writer; // 1 for the writing end
+	char* name; // name of the segment (used to remove it)
+#ifdef WIN32
+	HANDLE mapping;
+#endif
+};
+
+// all accesses before the barrier are completed before all accesses after it (for the compiler and the CPU)
+#define tracker_shm_barrier() __sync_synchronize()
+
+TrackerShm* tracker_shm_map(const char* name, int writer) {
+	TrackerShmSegment* segment;
+	size_t size = sizeof(TrackerShmSegment);
+#ifdef WIN32
+	HANDLE mapping;
+	if (writer)
+		mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, 0x0, PAGE_READWRITE, 0, size, name);
+	else
+		mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+	if (mapping == 0x0)
+		return 0x0;
+	segment = (TrackerShmSegment*) MapViewOfFile(mapping, writer ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+	if (segment == 0x0) {
+		CloseHandle(mapping);
+		return 0x0;
+	}
+#else
+	int fd = shm_open(name, writer ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+	if (fd < 0)
+		return 0x0;
+	if (writer && ftruncate(fd, size) != 0) {
+		close(fd);
+		return 0x0;
+	}
+	segment = (TrackerShmSegment*) mmap(0x0, size, writer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED)
+		return 0x0;
+#endif
+
+	TrackerShm* s = (TrackerShm*) calloc(1, sizeof(TrackerShm));
+	s->segment = segment;
+	s->writer = writer;
+	s->name = (char*) malloc(strlen(name) + 1);
+	strcpy(s->name, name);
+#ifdef WIN32
+	s->mapping = mapping;
+#endif
+	return s;
+}
+
+TrackerShm* tracker_shm_create(const char* name) {
+	TrackerShm* s = tracker_shm_map(name, 1);
+	if (s == 0x0)
+		return 0x0;
+
+	// readers check the header before they trust the data
+	TrackerShmSegment* seg = s->segment;
+	seg->sequence = 0;
+	memset(&seg->data, 0, sizeof(TrackerShmFrame));
+	seg->version = TRACKER_SHM_VERSION;
+	seg->size = sizeof(TrackerShmSegment);
+	tracker_shm_barrier();
+	memcpy(seg->magic, TRACKER_SHM_MAGIC, 4);
+	return s;
+}
+
+void tracker_shm_write(TrackerShm* s, const TrackerShmFrame* frame) {
+	TrackerShmSegment* seg = s->segment;
+	tracker_seqlock_write(&seg->sequence, &seg->data, frame, sizeof(TrackerShmFrame));
+}
+
+TrackerShm* tracker_shm_open(const char* name) {
+	TrackerShm* s = tracker_shm_map(name, 0);
+	if (s == 0x0)
+		return 0x0;
+	TrackerShmSegment* seg = s->segment;
+	if (memcmp(seg->magic, TRACKER_SHM_MAGIC, 4) != 0 || seg->version != TRACKER_SHM_VERSION || seg->size != sizeof(TrackerShmSegment)) {
+		tracker_shm_close(s);
+		return 0x0;
+	}
+	return s;
+}
+
+int tracker_shm_read(TrackerShm* s, TrackerShmFrame* frame) {
+	TrackerShmSegment* seg = s->segment;
+	return tracker_seqlock_read(&seg->sequence, &seg->data, frame, sizeof(TrackerShmFrame), SHM_READ_RETRIES);
+}
+
+void tracker_shm_close(TrackerShm* s) {
+	if (s == 0x0)
+		return;
+#ifdef WIN32
+	UnmapViewOfFile(s->segment);
+	CloseHandle(s->mapping);
+#else
+	munmap(s->segment, sizeof(TrackerShmSegment));
+	if (s->writer)
+		shm_unlink(s->name);
+#endif
+	free(s->name);
+	free(s);
+}
@@ -0,0 +1,92 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef TRACKER_SHM_H_
+#define TRACKER_SHM_H_
+
+#include <stdint.h>
+
+/*
+ * Publishes the tracking results of every frame in a shared memory segment, so that
+ * other processes on the same host can read them without calling into the tracker.
+ * The segment is protected by a sequence lock (see thread/tracker_seqlock.h): the tracker
+ * never waits for a reader, a reader retries if the tracker has written the results while
+ * it was copying them.
+ *
+ * Readers only need this header, tracker_shm.c and thread/tracker_seqlock.c (no OpenCV, no tracker).
+ */
+
+#define TRACKER_SHM_DEFAULT_NAME "/psmove_tracker"	// name of the segment (POSIX shared memory object or win32 file mapping)
+#define TRACKER_SHM_MAGIC "PSSM"					// first four bytes of the segment
+#define TRACKER_SHM_VERSION 1						// increase whenever the layout of TrackerShmFrame changes
+#define TRACKER_SHM_MAX_CONTROLLERS 8				// number of controllers in a frame
+
+/* The results of a single controller */
+typedef struct {
+	float x, y, r; // position and radius of the sphere (in pixels)
+	int32_t is_tracked; // 1 if the sphere has been found in the frame "frame"
+	uint8_t color[4]; // the color of the sphere's LEDs (RGB, the 4th byte is unused)
+	uint32_t frame; // the frame these results belong to (the controller may not be updated in every frame)
+	int64_t timestamp; // monotonic time of that frame (in nano-seconds)
+} TrackerShmController;
+
+/* The results of all enabled controllers */
+typedef struct {
+	uint32_t frame; // the frame that has been published last
+	int32_t controllers; // number of valid entries in "controller" (in the order in which they have been enabled)
+	int64_t timestamp; // monotonic time of that frame (in nano-seconds, comparable to CLOCK_MONOTONIC_RAW)
+	TrackerShmController controller[TRACKER_SHM_MAX_CONTROLLERS];
+} TrackerShmFrame;
+
+/* Layout of the shared memory segment */
+typedef struct {
+	char magic[4]; // TRACKER_SHM_MAGIC
+	uint32_t version; // TRACKER_SHM_VERSION
+	uint32_t size; // sizeof(TrackerShmSegment)
+	volatile uint32_t sequence; // odd while the tracker is writing "data", incremented twice per frame
+	TrackerShmFrame data; // the results of the last frame
+} TrackerShmSegment;
+
+/* Opaque data type for the writing and the reading end */
+struct _TrackerShm;
+typedef struct _TrackerShm TrackerShm;
+
+// creates (or reuses) the segment and maps it for writing, returns NULL on error
+TrackerShm* tracker_shm_create(const char* name);
+// copies the results of a frame into the segment, never blocks
+void tracker_shm_write(TrackerShm* s, const TrackerShmFrame* frame);
+
+// maps an existing segment for reading, returns NULL if it does not exist or has another layout
+TrackerShm* tracker_shm_open(const char* name);
+// copies a consistent snapshot of the last frame, returns 0 if nothing has been published yet
+int tracker_shm_read(TrackerShm* s, TrackerShmFrame* frame);
+
+// unmaps the segment (the writing end also removes its name)
+void tracker_shm_close(TrackerShm* s);
+
+#endif /* TRACKER_SHM_H_ */
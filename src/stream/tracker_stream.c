@@ -0,0 +1,242 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WIN32
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "tracker_stream.h"
+
+// the largest possible packet
+#define STREAM_PACKET_SIZE (sizeof(TrackerStreamHeader) + TRACKER_STREAM_MAX_BATCH * \
+		(sizeof(TrackerStreamFrameHeader) + TRACKER_STREAM_MAX_CONTROLLERS * sizeof(TrackerStreamController)))
+
+struct _TrackerStream {
+	int fd; // the datagram socket
+	int receiver; // 1 for the receiving end
+#ifndef WIN32
+	struct sockaddr_storage addr; // the address of the receiver
+	socklen_t addr_len;
+#endif
+	int batch; // number of frames per packet
+	int frames; // number of frames in the current packet
+	size_t used; // number of bytes in the current packet
+	unsigned char packet[STREAM_PACKET_SIZE]; // the current packet (sending end) or the last one received
+	uint32_t sequence; // number of the next packet
+	unsigned int sent; // number of packets sent
+	unsigned int dropped; // number of frames dropped
+	char path[108]; // path of the socket file (receiving end of a Unix domain socket)
+};
+
+#ifndef WIN32
+// parses "unix:<path>" or "udp:<port>" into a socket address of the loopback interface
+int tracker_stream_parse(TrackerStream* s, const char* address) {
+	memset(&s->addr, 0, sizeof(s->addr));
+	if (strncmp(address, "unix:", 5) == 0) {
+		struct sockaddr_un* un = (struct sockaddr_un*) &s->addr;
+		if (strlen(address + 5) >= sizeof(un->sun_path))
+			return -1;
+		un->sun_family = AF_UNIX;
+		strcpy(un->sun_path, address + 5);
+		s->addr_len = sizeof(struct sockaddr_un);
+		return AF_UNIX;
+	}
+	if (strncmp(address, "udp:", 4) == 0) {
+		struct sockaddr_in* in = (struct sockaddr_in*) &s->addr;
+		in->sin_family = AF_INET;
+		in->sin_port = htons(atoi(address + 4));
+		in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		s->addr_len = sizeof(struct sockaddr_in);
+		return AF_INET;
+	}
+	return -1;
+}
+
+TrackerStream* tracker_stream_open(const char* address, int receiver) {
+	TrackerStream* s = (TrackerStream*) calloc(1, sizeof(TrackerStream));
+	int family = tracker_stream_parse(s, address);
+	if (family < 0) {
+		free(s);
+		return 0x0;
+	}
+	s->fd = socket(family, SOCK_DGRAM, 0);
+	if (s->fd < 0) {
+		free(s);
+		return 0x0;
+	}
+	s->receiver = receiver;
+	if (receiver) {
+		if (family == AF_UNIX) {
+			// a socket file left behind by a previous receiver would make bind fail
+			strcpy(s->path, ((struct sockaddr_un*) &s->addr)->sun_path);
+			unlink(s->path);
+		}
+		if (bind(s->fd, (struct sockaddr*) &s->addr, s->addr_len) != 0) {
+			s->path[0] = 0;
+			tracker_stream_release(s);
+			return 0x0;
+		}
+	}
+	return s;
+}
+#endif
+
+TrackerStream* tracker_stream_new(const char* address, int batch) {
+#ifdef WIN32
+	return 0x0;
+#else
+	TrackerStream* s = tracker_stream_open(address, 0);
+	if (s == 0x0)
+		return 0x0;
+	if (batch < 1)
+		batch = 1;
+	if (batch > TRACKER_STREAM_MAX_BATCH)
+		batch = TRACKER_STREAM_MAX_BATCH;
+	s->batch = batch;
+	s->used = sizeof(TrackerStreamHeader);
+	return s;
+#endif
+}
+
+void tracker_stream_add(TrackerStream* s, const TrackerStreamFrame* frame) {
+	TrackerStreamFrameHeader fh;
+	int n = frame->controllers < TRACKER_STREAM_MAX_CONTROLLERS ? frame->controllers : TRACKER_STREAM_MAX_CONTROLLERS;
+
+	fh.frame = frame->frame;
+	fh.controllers = n;
+	fh.reserved = 0;
+	fh.timestamp = frame->timestamp;
+	memcpy(s->packet + s->used, &fh, sizeof(fh));
+	s->used += sizeof(fh);
+	memcpy(s->packet + s->used, frame->controller, n * sizeof(TrackerStreamController));
+	s->used += n * sizeof(TrackerStreamController);
+
+	if (++s->frames >= s->batch)
+		tracker_stream_flush(s);
+}
+
+void tracker_stream_flush(TrackerStream* s) {
+#ifndef WIN32
+	TrackerStreamHeader h;
+	if (s->frames == 0)
+		return;
+
+	memcpy(h.magic, TRACKER_STREAM_MAGIC, 4);
+	h.version = TRACKER_STREAM_VERSION;
+	h.frames = s->frames;
+	h.sequence = s->sequence++;
+	h.dropped = s->dropped;
+	memcpy(s->packet, &h, sizeof(h));
+
+	// never wait for the receiver: a full socket buffer (or no receiver at all) drops the packet
+	if (sendto(s->fd, s->packet, s->used, MSG_DONTWAIT, (struct sockaddr*) &s->addr, s->addr_len) == (ssize_t) s->used)
+		s->sent++;
+	else
+		s->dropped += s->frames;
+
+	s->frames = 0;
+	s->used = sizeof(TrackerStreamHeader);
+#endif
+}
+
+void tracker_stream_get_statistics(TrackerStream* s, unsigned int* sent, unsigned int* dropped) {
+	if (sent != 0x0)
+		*sent = s->sent;
+	if (dropped != 0x0)
+		*dropped = s->dropped;
+}
+
+TrackerStream* tracker_stream_listen(const char* address) {
+#ifdef WIN32
+	return 0x0;
+#else
+	return tracker_stream_open(address, 1);
+#endif
+}
+
+int tracker_stream_receive(TrackerStream* s, TrackerStreamHeader* header, TrackerStreamFrame* frames, int max, int timeout_ms) {
+#ifdef WIN32
+	return -1;
+#else
+	TrackerStreamHeader h;
+	TrackerStreamFrameHeader fh;
+	struct pollfd pfd;
+	int i;
+
+	pfd.fd = s->fd;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, timeout_ms) <= 0)
+		return 0;
+	ssize_t len = recv(s->fd, s->packet, sizeof(s->packet), 0);
+	if (len < (ssize_t) sizeof(h))
+		return -1;
+
+	memcpy(&h, s->packet, sizeof(h));
+	if (memcmp(h.magic, TRACKER_STREAM_MAGIC, 4) != 0 || h.version != TRACKER_STREAM_VERSION)
+		return -1;
+	if (header != 0x0)
+		*header = h;
+
+	// decode the frames, never trusting the counts in the packet
+	size_t pos = sizeof(h);
+	for (i = 0; i < h.frames && i < max; i++) {
+		if (pos + sizeof(fh) > (size_t) len)
+			return -1;
+		memcpy(&fh, s->packet + pos, sizeof(fh));
+		pos += sizeof(fh);
+		if (fh.controllers > TRACKER_STREAM_MAX_CONTROLLERS || pos + fh.controllers * sizeof(TrackerStreamController) > (size_t) len)
+			return -1;
+		frames[i].frame = fh.frame;
+		frames[i].timestamp = fh.timestamp;
+		frames[i].controllers = fh.controllers;
+		memcpy(frames[i].controller, s->packet + pos, fh.controllers * sizeof(TrackerStreamController));
+		pos += fh.controllers * sizeof(TrackerStreamController);
+	}
+	return i;
+#endif
+}
+
+void tracker_stream_release(TrackerStream* s) {
+	if (s == 0x0)
+		return;
+#ifndef WIN32
+	close(s->fd);
+	if (s->receiver && s->path[0] != 0)
+		unlink(s->path);
+#endif
+	free(s);
+}
@@ -0,0 +1,105 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef TRACKER_STREAM_H_
+#define TRACKER_STREAM_H_
+
+#include <stdint.h>
+
+/*
+ * Streams the tracking results to another process on the same host, as datagrams over
+ * a Unix domain socket or loopback UDP. Each packet carries one or more frames. Sending
+ * never blocks: if the receiver does not keep up and its socket buffer is full, the
+ * packet is dropped and counted. The packets use the byte order of the host.
+ *
+ * Addresses are "unix:<path>" (the receiver creates the socket file) or "udp:<port>".
+ */
+
+#define TRACKER_STREAM_MAGIC "PSST"			// first four bytes of every packet
+#define TRACKER_STREAM_VERSION 1			// increase whenever the packet layout changes
+#define TRACKER_STREAM_MAX_CONTROLLERS 8	// maximum number of controllers per frame
+#define TRACKER_STREAM_MAX_BATCH 32			// maximum number of frames per packet
+
+/* Header of every packet, followed by "frames" frames */
+typedef struct {
+	char magic[4]; // TRACKER_STREAM_MAGIC
+	uint16_t version; // TRACKER_STREAM_VERSION
+	uint16_t frames; // number of frames in this packet
+	uint32_t sequence; // incremented with every packet, including dropped ones (gaps reveal lost packets)
+	uint32_t dropped; // number of frames the sender has dropped so far
+} TrackerStreamHeader;
+
+/* Header of a frame within a packet, followed by "controllers" TrackerStreamController */
+typedef struct {
+	uint32_t frame; // the number of the frame
+	uint16_t controllers; // number of controllers (in the order in which they have been enabled)
+	uint16_t reserved;
+	int64_t timestamp; // monotonic time when the frame has been taken from the camera (in nano-seconds)
+} TrackerStreamFrameHeader;
+
+/* The results of a single controller */
+typedef struct {
+	float x, y, r; // position and radius of the sphere (in pixels)
+	uint8_t is_tracked; // 1 if the sphere has been found
+	uint8_t reserved[3];
+} TrackerStreamController;
+
+/* A decoded frame */
+typedef struct {
+	uint32_t frame;
+	int64_t timestamp;
+	int controllers;
+	TrackerStreamController controller[TRACKER_STREAM_MAX_CONTROLLERS];
+} TrackerStreamFrame;
+
+/* Opaque data type for the sending and the receiving end */
+struct _TrackerStream;
+typedef struct _TrackerStream TrackerStream;
+
+// creates the sending end, a packet is sent for every "batch" frames, returns NULL on error
+TrackerStream* tracker_stream_new(const char* address, int batch);
+// appends a frame to the current packet and sends the packet once it is full
+void tracker_stream_add(TrackerStream* s, const TrackerStreamFrame* frame);
+// sends the frames of the current packet, even if it is not full
+void tracker_stream_flush(TrackerStream* s);
+// number of packets that have been sent and of frames that have been dropped
+void tracker_stream_get_statistics(TrackerStream* s, unsigned int* sent, unsigned int* dropped);
+
+// creates the receiving end, returns NULL on error
+TrackerStream* tracker_stream_listen(const char* address);
+/*
+ * Waits up to "timeout_ms" for the next packet and decodes up to "max" of its frames.
+ * header - (out) the header of the packet, or NULL
+ * Returns the number of decoded frames, 0 on timeout, -1 if an invalid packet has been received
+ */
+int tracker_stream_receive(TrackerStream* s, TrackerStreamHeader* header, TrackerStreamFrame* frames, int max, int timeout_ms);
+
+// closes the socket (the receiving end also removes the socket file)
+void tracker_stream_release(TrackerStream* s);
+
+#endif /* TRACKER_STREAM_H_ */
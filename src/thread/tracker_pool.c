@@ -0,0 +1,158 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+#include "tracker_pool.h"
+#include "tracker_thread.h"
+
+#define POOL_MAX_THREADS 16 // upper bound of the threads of a pool
+
+struct _TrackerPool {
+	int threads; // number of threads including the caller
+	TrackerThread workers[POOL_MAX_THREADS]; // the worker threads (threads - 1)
+	TrackerMutex mutex; // protects everything below
+	TrackerCond work; // signals a new batch (or the end of the workers)
+	TrackerCond done; // signals that the last job of a batch has finished
+	TrackerPoolFunc func; // the function of the current batch
+	void* arg; // the argument of the current batch
+	int jobs; // number of jobs of the current batch
+	int next; // the next job that has not been started yet
+	int pending; // number of jobs that have not finished yet
+	unsigned int batch; // incremented with every batch, so that the workers notice new ones
+	int running; // 0 if the workers shall end
+};
+
+// takes jobs of the current batch until all have been started, the mutex must be locked
+void tracker_pool_work(TrackerPool* p) {
+	while (p->next < p->jobs) {
+		int job = p->next++;
+		tracker_mutex_unlock(&p->mutex);
+		p->func(p->arg, job);
+		tracker_mutex_lock(&p->mutex);
+		if (--p->pending == 0)
+			tracker_cond_signal(&p->done);
+	}
+}
+
+void tracker_pool_main(void* arg) {
+	TrackerPool* p = (TrackerPool*) arg;
+	unsigned int batch = 0;
+
+	tracker_mutex_lock(&p->mutex);
+	while (1) {
+		while (p->running && p->batch == batch)
+			tracker_cond_wait(&p->work, &p->mutex);
+		if (!p->running)
+			break;
+		batch = p->batch;
+		tracker_pool_work(p);
+	}
+	tracker_mutex_unlock(&p->mutex);
+}
+
+TrackerPool* tracker_pool_new(int threads) {
+	TrackerPool* p = (TrackerPool*) calloc(1, sizeof(TrackerPool));
+	int i;
+	if (threads <= 0)
+		threads = tracker_pool_cpu_count();
+	if (threads > POOL_MAX_THREADS)
+		threads = POOL_MAX_THREADS;
+
+	tracker_mutex_init(&p->mutex);
+	tracker_cond_init(&p->work);
+	tracker_cond_init(&p->done);
+	p->running = 1;
+	p->threads = 1;
+	for (i = 0; i < threads - 1; i++) {
+		if (!tracker_thread_create(&p->workers[i], tracker_pool_main, p))
+			break;
+		p->threads++;
+	}
+	return p;
+}
+
+void tracker_pool_release(TrackerPool* p) {
+	int i;
+	if (p == 0x0)
+		return;
+
+	tracker_mutex_lock(&p->mutex);
+	p->running = 0;
+	tracker_cond_broadcast(&p->work);
+	tracker_mutex_unlock(&p->mutex);
+	for (i = 0; i < p->threads - 1; i++)
+		tracker_thread_join(p->workers[i]);
+
+	tracker_cond_destroy(&p->done);
+	tracker_cond_destroy(&p->work);
+	tracker_mutex_destroy(&p->mutex);
+	free(p);
+}
+
+int tracker_pool_get_threads(TrackerPool* p) {
+	return p->threads;
+}
+
+void tracker_pool_run(TrackerPool* p, TrackerPoolFunc func, void* arg, int jobs) {
+	int i;
+	if (p->threads == 1) {
+		for (i = 0; i < jobs; i++)
+			func(arg, i);
+		return;
+	}
+
+	tracker_mutex_lock(&p->mutex);
+	p->func = func;
+	p->arg = arg;
+	p->jobs = jobs;
+	p->next = 0;
+	p->pending = jobs;
+	p->batch++;
+	tracker_cond_broadcast(&p->work);
+
+	// help with the batch, then wait for the jobs that are still running on the workers
+	tracker_pool_work(p);
+	while (p->pending > 0)
+		tracker_cond_wait(&p->done, &p->mutex);
+	tracker_mutex_unlock(&p->mutex);
+}
+
+int tracker_pool_cpu_count() {
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int) info.dwNumberOfProcessors : 1;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int) n : 1;
+#endif
+}
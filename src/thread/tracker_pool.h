@@ -0,0 +1,51 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef TRACKER_POOL_H_
+#define TRACKER_POOL_H_
+
+/* Opaque data type for the thread pool */
+struct _TrackerPool;
+typedef struct _TrackerPool TrackerPool;
+
+typedef void (*TrackerPoolFunc)(void* arg, int job);
+
+/*
+ * A fixed set of worker threads that process a batch of independent jobs (e.g. the
+ * stripes of a frame). The calling thread takes part in the work, so a pool of n
+ * threads starts n - 1 workers; a pool of one thread runs all jobs on the caller.
+ */
+TrackerPool* tracker_pool_new(int threads); // constructor, 0 threads means one per CPU
+void tracker_pool_release(TrackerPool* p); // destructor, waits for the workers to end
+int tracker_pool_get_threads(TrackerPool* p); // number of threads including the caller
+// calls func(arg, job) for every job in 0 .. jobs - 1 and returns when all of them are done
+void tracker_pool_run(TrackerPool* p, TrackerPoolFunc func, void* arg, int jobs);
+
+int tracker_pool_cpu_count(); // number of online CPUs (at least 1)
+
+#endif /* TRACKER_POOL_H_ */
@@ -0,0 +1,73 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+#include "tracker_seqlock.h"
+
+// all accesses before the barrier are completed before all accesses after it (for the compiler and the CPU)
+#define tracker_seqlock_barrier() __sync_synchronize()
+
+void tracker_seqlock_write(volatile uint32_t* sequence, volatile void* data, const void* src, size_t size) {
+	// an odd sequence tells the readers that the data is being changed
+	(*sequence)++;
+	tracker_seqlock_barrier();
+	memcpy((void*) data, src, size);
+	tracker_seqlock_barrier();
+	(*sequence)++;
+}
+
+int tracker_seqlock_read(volatile const uint32_t* sequence, volatile const void* data, void* dst, size_t size, int retries) {
+	int i;
+	for (i = 0; retries == 0 || i < retries; i++) {
+		uint32_t before = *sequence;
+		tracker_seqlock_barrier();
+		if (before == 0)
+			return 0;
+		if (before & 1) {
+			// the writer is busy, which takes less than a micro-second
+#ifdef WIN32
+			SwitchToThread();
+#else
+			sched_yield();
+#endif
+			continue;
+		}
+		memcpy(dst, (const void*) data, size);
+		tracker_seqlock_barrier();
+		if (*sequence == before)
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef TRACKER_SEQLOCK_H_
+#define TRACKER_SEQLOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A sequence lock guards data that is written by a single thread (or process) and read by
+ * any number of others: the sequence is odd while the data is being written and is incremented
+ * twice per write. The writer never waits; a reader copies the data and retries if the sequence
+ * has changed meanwhile. A sequence of 0 means that nothing has been written yet.
+ * The sequence and the data may live in shared memory, nothing else is needed to read them.
+ */
+
+// copies "size" bytes from "src" to the guarded "data" (single writer only)
+void tracker_seqlock_write(volatile uint32_t* sequence, volatile void* data, const void* src, size_t size);
+// copies a consistent version of the guarded "data" to "dst", gives up after "retries" attempts (0 = never)
+// returns 1 on success, 0 if nothing has been written yet or no consistent copy could be made
+int tracker_seqlock_read(volatile const uint32_t* sequence, volatile const void* data, void* dst, size_t size, int retries);
+
+#endif /* TRACKER_SEQLOCK_H_ */
@@ -0,0 +1,150 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+
+#include "tracker_thread.h"
+
+typedef struct {
+	TrackerThreadFunc func;
+	void* arg;
+} TrackerThreadStart;
+
+#ifdef WIN32
+DWORD WINAPI tracker_thread_main(LPVOID param) {
+#else
+void* tracker_thread_main(void* param) {
+#endif
+	TrackerThreadStart start = *(TrackerThreadStart*) param;
+	free(param);
+	start.func(start.arg);
+	return 0;
+}
+
+int tracker_thread_create(TrackerThread* thread, TrackerThreadFunc func, void* arg) {
+	TrackerThreadStart* start = (TrackerThreadStart*) calloc(1, sizeof(TrackerThreadStart));
+	start->func = func;
+	start->arg = arg;
+#ifdef WIN32
+	*thread = CreateThread(0x0, 0, tracker_thread_main, start, 0, 0x0);
+	if (*thread != 0x0)
+		return 1;
+#else
+	if (pthread_create(thread, 0x0, tracker_thread_main, start) == 0)
+		return 1;
+#endif
+	free(start);
+	return 0;
+}
+
+void tracker_thread_join(TrackerThread thread) {
+#ifdef WIN32
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, 0x0);
+#endif
+}
+
+void tracker_mutex_init(TrackerMutex* m) {
+#ifdef WIN32
+	InitializeCriticalSection(m);
+#else
+	pthread_mutex_init(m, 0x0);
+#endif
+}
+
+void tracker_mutex_destroy(TrackerMutex* m) {
+#ifdef WIN32
+	DeleteCriticalSection(m);
+#else
+	pthread_mutex_destroy(m);
+#endif
+}
+
+void tracker_mutex_lock(TrackerMutex* m) {
+#ifdef WIN32
+	EnterCriticalSection(m);
+#else
+	pthread_mutex_lock(m);
+#endif
+}
+
+int tracker_mutex_trylock(TrackerMutex* m) {
+#ifdef WIN32
+	return TryEnterCriticalSection(m) != 0;
+#else
+	return pthread_mutex_trylock(m) == 0;
+#endif
+}
+
+void tracker_mutex_unlock(TrackerMutex* m) {
+#ifdef WIN32
+	LeaveCriticalSection(m);
+#else
+	pthread_mutex_unlock(m);
+#endif
+}
+
+void tracker_cond_init(TrackerCond* c) {
+#ifdef WIN32
+	InitializeConditionVariable(c);
+#else
+	pthread_cond_init(c, 0x0);
+#endif
+}
+
+void tracker_cond_destroy(TrackerCond* c) {
+#ifndef WIN32
+	pthread_cond_destroy(c);
+#endif
+}
+
+void tracker_cond_wait(TrackerCond* c, TrackerMutex* m) {
+#ifdef WIN32
+	SleepConditionVariableCS(c, m, INFINITE);
+#else
+	pthread_cond_wait(c, m);
+#endif
+}
+
+void tracker_cond_signal(TrackerCond* c) {
+#ifdef WIN32
+	WakeConditionVariable(c);
+#else
+	pthread_cond_signal(c);
+#endif
+}
+
+void tracker_cond_broadcast(TrackerCond* c) {
+#ifdef WIN32
+	WakeAllConditionVariable(c);
+#else
+	pthread_cond_broadcast(c);
+#endif
+}
@@ -0,0 +1,73 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef TRACKER_THREAD_H_
+#define TRACKER_THREAD_H_
+
+/*
+ * A minimal layer over the threads of the operating system (pthreads or win32),
+ * so that the tracker can move work off its hot path.
+ */
+
+#ifdef WIN32
+#include <windows.h>
+typedef HANDLE TrackerThread;
+typedef CRITICAL_SECTION TrackerMutex;
+typedef CONDITION_VARIABLE TrackerCond;
+#else
+#include <pthread.h>
+typedef pthread_t TrackerThread;
+typedef pthread_mutex_t TrackerMutex;
+typedef pthread_cond_t TrackerCond;
+#endif
+
+// storage class of a variable that every thread has its own copy of
+#ifdef _MSC_VER
+#define TRACKER_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACKER_THREAD_LOCAL __thread
+#endif
+
+typedef void (*TrackerThreadFunc)(void* arg);
+
+int tracker_thread_create(TrackerThread* thread, TrackerThreadFunc func, void* arg); // starts a thread, returns 0 on error
+void tracker_thread_join(TrackerThread thread); // waits until the thread has finished
+
+void tracker_mutex_init(TrackerMutex* m);
+void tracker_mutex_destroy(TrackerMutex* m);
+void tracker_mutex_lock(TrackerMutex* m);
+int tracker_mutex_trylock(TrackerMutex* m); // returns 1 if the mutex has been locked, 0 if it is held by another thread
+void tracker_mutex_unlock(TrackerMutex* m);
+
+void tracker_cond_init(TrackerCond* c);
+void tracker_cond_destroy(TrackerCond* c);
+void tracker_cond_wait(TrackerCond* c, TrackerMutex* m); // the mutex must be locked
+void tracker_cond_signal(TrackerCond* c);
+void tracker_cond_broadcast(TrackerCond* c);
+
+#endif /* TRACKER_THREAD_H_ */
@@ -1,36 +1,102 @@
 #include "high_precision_timer.h"
 #include <stdlib.h>
 
+#if defined(HP_TIMER_USE_TSC) && (defined(__i386__) || defined(__x86_64__))
+#	define HP_TIMER_TSC_AVAILABLE
+#	include <x86intrin.h>
+#	include <cpuid.h>
+#endif
+
+#if !defined(WIN32) && !defined(CLOCK_MONOTONIC_RAW)
+#	define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+
 struct _HPTimer {
-	double startTimeInMicroSec; // starting time in micro-second
-	double endTimeInMicroSec; // ending time in micro-second
+	int64_t startCount; // starting time in nano-second
+	int64_t endCount; // ending time in nano-second
 	int stopped; // stop flag
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// time sources
+///////////////////////////////////////////////////////////////////////////////
+int64_t hp_timer_os_now_ns() {
 #ifdef WIN32
-	LARGE_INTEGER frequency; // ticks per second
-	LARGE_INTEGER startCount; //
-	LARGE_INTEGER endCount; //
+	static LARGE_INTEGER frequency; // ticks per second
+	LARGE_INTEGER count;
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&count);
+	// split the conversion to avoid an overflow of count * 10^9
+	return (count.QuadPart / frequency.QuadPart) * 1000000000LL + ((count.QuadPart % frequency.QuadPart) * 1000000000LL) / frequency.QuadPart;
 #else
-	struct timeval startCount;
-	struct timeval endCount;
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
 #endif
-};
+}
+
+#ifdef HP_TIMER_TSC_AVAILABLE
+static int tsc_state = 0; // 0: not calibrated, 1: calibrated, -1: not usable, 2: being calibrated
+static uint64_t tsc_base; // tsc at calibration time
+static int64_t tsc_base_ns; // monotonic time at calibration time
+static uint64_t tsc_mult; // ns per tick as 32.32 fixed point
+
+// runs only once, on the thread that has moved tsc_state from 0 to 2
+void hp_timer_calibrate_tsc() {
+	unsigned int eax, ebx, ecx, edx;
+	// invariant TSC is reported in CPUID.80000007H:EDX[8]
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8))) {
+		__atomic_store_n(&tsc_state, -1, __ATOMIC_RELEASE);
+		return;
+	}
+
+	// measure the tick rate over ~10ms against the monotonic clock
+	int64_t ns0 = hp_timer_os_now_ns();
+	uint64_t t0 = __rdtsc();
+	int64_t ns1;
+	do {
+		ns1 = hp_timer_os_now_ns();
+	} while (ns1 - ns0 < 10000000);
+	uint64_t t1 = __rdtsc();
+	if (t1 <= t0) {
+		__atomic_store_n(&tsc_state, -1, __ATOMIC_RELEASE);
+		return;
+	}
+
+	tsc_mult = (((uint64_t) (ns1 - ns0)) << 32) / (t1 - t0);
+	tsc_base = t1;
+	tsc_base_ns = ns1;
+	// publish the factors before other threads may use them
+	__atomic_store_n(&tsc_state, 1, __ATOMIC_RELEASE);
+}
+#endif
+
+int64_t hp_timer_now_ns() {
+#ifdef HP_TIMER_TSC_AVAILABLE
+	// the first caller calibrates, all others use the monotonic clock (the TSC is based on) until it is done
+	int state = __atomic_load_n(&tsc_state, __ATOMIC_ACQUIRE);
+	if (state == 0 && __sync_bool_compare_and_swap(&tsc_state, 0, 2)) {
+		hp_timer_calibrate_tsc();
+		state = __atomic_load_n(&tsc_state, __ATOMIC_ACQUIRE);
+	}
+	if (state == 1) {
+		uint64_t d = __rdtsc() - tsc_base;
+		// split the ticks into high and low 32 bits, so that the product with the 32.32 fixed point factor cannot overflow
+		return tsc_base_ns + (int64_t) ((d >> 32) * tsc_mult + (((d & 0xFFFFFFFF) * tsc_mult) >> 32));
+	}
+#endif
+	return hp_timer_os_now_ns();
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 // constructor
 ///////////////////////////////////////////////////////////////////////////////
 HPTimer* hp_timer_create() {
 	HPTimer* t = (HPTimer*) calloc(1, sizeof(HPTimer));
-#ifdef WIN32
-	QueryPerformanceFrequency(&t->frequency);
-	t->startCount.QuadPart = 0;
-	t->endCount.QuadPart = 0;
-#else
-	t->startCount.tv_sec = t->startCount.tv_usec = 0;
-	t->endCount.tv_sec = t->endCount.tv_usec = 0;
-#endif
+	t->startCount = 0;
+	t->endCount = 0;
 	t->stopped = 0;
-	t->startTimeInMicroSec = 0;
-	t->endTimeInMicroSec = 0;
 	return t;
 }
 
@@ -44,11 +110,7 @@ void hp_timer_release(HPTimer* t) {
 ///////////////////////////////////////////////////////////////////////////////
 void hp_timer_start(HPTimer* t) {
 	t->stopped = 0; // reset stop flag
-#ifdef WIN32
-	QueryPerformanceCounter(&t->startCount);
-#else
-	gettimeofday(&t->startCount, NULL);
-#endif
+	t->startCount = hp_timer_now_ns();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -57,48 +119,36 @@ void hp_timer_start(HPTimer* t) {
 ///////////////////////////////////////////////////////////////////////////////
 void hp_timer_stop(HPTimer* t) {
 	t->stopped = 1; // set timer stopped flag
-
-#ifdef WIN32
-	QueryPerformanceCounter(&t->endCount);
-#else
-	gettimeofday(&t->endCount, NULL);
-#endif
+	t->endCount = hp_timer_now_ns();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// compute elapsed time in micro-second resolution.
+// compute elapsed time in nano-second resolution.
 // other getElapsedTime will call this first, then convert to correspond resolution.
 ///////////////////////////////////////////////////////////////////////////////
-double hp_timer_get_micros(HPTimer* t) {
-#ifdef WIN32
+int64_t hp_timer_get_nanos(HPTimer* t) {
 	if (!t->stopped)
-		QueryPerformanceCounter(&t->endCount);
-
-	t->startTimeInMicroSec = t->startCount.QuadPart
-			* (1000000.0 / t->frequency.QuadPart);
-	t->endTimeInMicroSec = t->endCount.QuadPart
-			* (1000000.0 / t->frequency.QuadPart);
-#else
-	if(!t->stopped)
-	gettimeofday(&t->endCount, NULL);
-
-	t->startTimeInMicroSec = (t->startCount.tv_sec * 1000000.0) + t->startCount.tv_usec;
-	t->endTimeInMicroSec = (t->endCount.tv_sec * 1000000.0) + t->endCount.tv_usec;
-#endif
+		t->endCount = hp_timer_now_ns();
+	return t->endCount - t->startCount;
+}
 
-	return t->endTimeInMicroSec - t->startTimeInMicroSec;
+///////////////////////////////////////////////////////////////////////////////
+// divide elapsedTimeInNanoSec by 1000
+///////////////////////////////////////////////////////////////////////////////
+double hp_timer_get_micros(HPTimer* t) {
+	return hp_timer_get_nanos(t) * 0.001;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// divide elapsedTimeInMicroSec by 1000
+// divide elapsedTimeInNanoSec by 1000000
 ///////////////////////////////////////////////////////////////////////////////
 double hp_timer_get_millis(HPTimer* t) {
-	return hp_timer_get_micros(t) * 0.001;
+	return hp_timer_get_nanos(t) * 0.000001;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// divide elapsedTimeInMicroSec by 1000000
+// divide elapsedTimeInNanoSec by 1000000000
 ///////////////////////////////////////////////////////////////////////////////
 double hp_timer_get_seconds(HPTimer* t) {
-	return hp_timer_get_micros(t) * 0.000001;
+	return hp_timer_get_nanos(t) * 0.000000001;
 }
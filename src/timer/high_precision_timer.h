@@ -4,8 +4,15 @@
 #ifdef WIN32   // Windows system specific
 #include <windows.h>
 #else          // Unix based system specific
-#include <sys/time.h>
+#include <time.h>
 #endif
+#include <stdint.h>
+
+// uncomment to read the time stamp counter of x86 CPUs instead of calling into the OS.
+// it is calibrated against the monotonic clock on first use and is only used if the CPU
+// reports an invariant TSC (constant rate, not stopped in sleep states). the first caller
+// calibrates it, other threads read the monotonic clock until the calibration is done
+//#define HP_TIMER_USE_TSC
 
 /* Opaque data type for the PS Move internal data */
 struct _HPTimer;
@@ -18,5 +25,22 @@ void hp_timer_stop(HPTimer* t); // stop the timer
 double hp_timer_get_seconds(HPTimer* t); // get elapsed time in second
 double hp_timer_get_millis(HPTimer* t); // get elapsed time in milli-second
 double hp_timer_get_micros(HPTimer* t); // get elapsed time in micro-second
+int64_t hp_timer_get_nanos(HPTimer* t); // get elapsed time in nano-second
+
+// monotonic time in nano-seconds (not affected by changes of the wall clock, e.g. NTP).
+// only differences between two values are meaningful.
+int64_t hp_timer_now_ns();
+
+/*
+ * Measures the time spent in the following block and adds it to "acc" (an int64_t in
+ * nano-seconds). Blocks may be nested. Leaving the block with break/return/goto skips
+ * the measurement.
+ *
+ *   HP_TIMER_SCOPE(tracker->convert_ns) {
+ *       cvCvtColor(src, dst, CV_BGR2HSV);
+ *   }
+ */
+#define HP_TIMER_SCOPE(acc) \
+	for (int64_t _hp_start = hp_timer_now_ns(), _hp_once = 1; _hp_once; _hp_once = 0, (acc) += hp_timer_now_ns() - _hp_start)
 
 #endif // HIGH_PRECISION_TIMER_H_DEF
@@ -0,0 +1,108 @@
+#include "stage_profiler.h"
+#include "../thread/tracker_thread.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+	int64_t samples[STAGE_PROFILER_WINDOW]; // ring buffer of the most recent samples (in nano-seconds)
+	int count; // total number of samples ever added
+} StageWindow;
+
+struct _StageProfiler {
+	int slots; // number of slots (e.g. controllers)
+	int stages; // number of stages per slot
+	int64_t started[STAGE_PROFILER_MAX_STAGES]; // start time per stage, so that stages may be nested
+	int64_t current[STAGE_PROFILER_MAX_STAGES]; // accumulated time per stage since the last commit
+	int touched; // bit mask of the stages that have been measured since the last commit
+	StageWindow* windows; // slots * stages rolling windows
+	TrackerMutex mutex; // guards the windows, the statistics may be read by other threads
+};
+
+StageProfiler* stage_profiler_create(int slots, int stages) {
+	StageProfiler* p = (StageProfiler*) calloc(1, sizeof(StageProfiler));
+	if (stages > STAGE_PROFILER_MAX_STAGES)
+		stages = STAGE_PROFILER_MAX_STAGES;
+	p->slots = slots;
+	p->stages = stages;
+	p->windows = (StageWindow*) calloc(slots * stages, sizeof(StageWindow));
+	tracker_mutex_init(&p->mutex);
+	p->touched = 0;
+	return p;
+}
+
+void stage_profiler_release(StageProfiler* p) {
+	if (p == 0x0)
+		return;
+	free(p->windows);
+	tracker_mutex_destroy(&p->mutex);
+	free(p);
+}
+
+void stage_profiler_start(StageProfiler* p, int stage) {
+	p->started[stage] = hp_timer_now_ns();
+}
+
+void stage_profiler_stop(StageProfiler* p, int stage) {
+	p->current[stage] += hp_timer_now_ns() - p->started[stage];
+	p->touched |= 1 << stage;
+}
+
+int64_t stage_profiler_get_current(StageProfiler* p, int stage) {
+	return p->current[stage];
+}
+
+void stage_profiler_commit(StageProfiler* p, int slot) {
+	int i;
+	tracker_mutex_lock(&p->mutex);
+	for (i = 0; i < p->stages; i++) {
+		if (slot >= 0 && slot < p->slots && (p->touched & (1 << i))) {
+			StageWindow* w = &p->windows[slot * p->stages + i];
+			w->samples[w->count % STAGE_PROFILER_WINDOW] = p->current[i];
+			w->count++;
+		}
+		p->current[i] = 0;
+	}
+	tracker_mutex_unlock(&p->mutex);
+	p->touched = 0;
+}
+
+void stage_profiler_reset(StageProfiler* p, int slot) {
+	int i;
+	if (slot < 0 || slot >= p->slots)
+		return;
+	tracker_mutex_lock(&p->mutex);
+	for (i = 0; i < p->stages; i++)
+		p->windows[slot * p->stages + i].count = 0;
+	tracker_mutex_unlock(&p->mutex);
+}
+
+int stage_profiler_compare(const void* a, const void* b) {
+	int64_t ia = *(const int64_t*) a;
+	int64_t ib = *(const int64_t*) b;
+	return (ia > ib) - (ia < ib);
+}
+
+int stage_profiler_get_stats(StageProfiler* p, int slot, int stage, float* p50, float* p99, float* max) {
+	if (slot < 0 || slot >= p->slots || stage < 0 || stage >= p->stages)
+		return 0;
+
+	// the window is small, sorting a copy of it is cheap compared to keeping it sorted on the hot path.
+	// only the copy is made under the lock, so that the tracking thread is not held up by the sorting
+	int64_t sorted[STAGE_PROFILER_WINDOW];
+	StageWindow* w = &p->windows[slot * p->stages + stage];
+	tracker_mutex_lock(&p->mutex);
+	int n = w->count < STAGE_PROFILER_WINDOW ? w->count : STAGE_PROFILER_WINDOW;
+	memcpy(sorted, w->samples, n * sizeof(int64_t));
+	tracker_mutex_unlock(&p->mutex);
+	if (n == 0)
+		return 0;
+	qsort(sorted, n, sizeof(int64_t), stage_profiler_compare);
+
+	if (p50 != 0x0)
+		*p50 = sorted[(n - 1) * 50 / 100] * 0.001f;
+	if (p99 != 0x0)
+		*p99 = sorted[(n - 1) * 99 / 100] * 0.001f;
+	if (max != 0x0)
+		*max = sorted[n - 1] * 0.001f;
+	return n;
+}
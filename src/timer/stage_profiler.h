@@ -0,0 +1,42 @@
+#ifndef STAGE_PROFILER_H_DEF
+#define STAGE_PROFILER_H_DEF
+
+#include "high_precision_timer.h"
+
+#define STAGE_PROFILER_MAX_STAGES 16 // maximum number of stages per slot
+#define STAGE_PROFILER_WINDOW 512 // number of samples per slot and stage the statistics are calculated from
+
+/* Opaque data type for the stage profiler */
+struct _StageProfiler;
+typedef struct _StageProfiler StageProfiler;
+
+/*
+ * The profiler measures the time spent in a number of stages. The time of a stage is
+ * accumulated (a stage may run several times) until the measurements are committed to
+ * a slot (e.g. one slot per controller). Each committed value becomes one sample of the
+ * rolling window of that slot and stage; stages that did not run are not committed.
+ * All measurements are kept in integer nano-seconds, stages may be nested.
+ */
+StageProfiler* stage_profiler_create(int slots, int stages); // constructor, creates internal data structures of the profiler
+void stage_profiler_release(StageProfiler* p); // destructor
+void stage_profiler_start(StageProfiler* p, int stage); // start measuring a stage
+void stage_profiler_stop(StageProfiler* p, int stage); // stop measuring a stage and accumulate its time
+int64_t stage_profiler_get_current(StageProfiler* p, int stage); // accumulated time of a stage since the last commit (in nano-seconds)
+void stage_profiler_commit(StageProfiler* p, int slot); // move all accumulated times to the rolling windows of a slot
+void stage_profiler_reset(StageProfiler* p, int slot); // forget all samples of a slot (e.g. before it is reused)
+// calculates statistics of the rolling window of a slot/stage (in micro-seconds), returns the number of samples.
+// unlike the other calls it may be used from any thread
+int stage_profiler_get_stats(StageProfiler* p, int slot, int stage, float* p50, float* p99, float* max);
+
+// the profiling calls are compiled away, unless USE_STAGE_PROFILER is defined (see the makefile)
+#ifdef USE_STAGE_PROFILER
+	#define psmove_profile_start(p, stage) stage_profiler_start((p), (stage))
+	#define psmove_profile_stop(p, stage) stage_profiler_stop((p), (stage))
+	#define psmove_profile_commit(p, slot) stage_profiler_commit((p), (slot))
+#else
+	#define psmove_profile_start(p, stage)
+	#define psmove_profile_stop(p, stage)
+	#define psmove_profile_commit(p, slot)
+#endif
+
+#endif // STAGE_PROFILER_H_DEF
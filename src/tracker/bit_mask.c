@@ -0,0 +1,481 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bit_mask.h"
+
+#define BIT_MASK_WORD_BITS 64
+
+/* A horizontal run of set pixels: [x0, x1) in row y */
+typedef struct {
+	int y;
+	int x0, x1;
+} BitMaskRun;
+
+typedef struct {
+	int area; // area of the bounding box
+	int blob; // index into "blobs"
+} BitMaskOrder;
+
+struct _BitMaskBlobs {
+	int max_runs; // number of runs the arrays below can hold
+	BitMaskRun* runs; // the runs of the last labelling, row by row
+	int* row_start; // index of the first run of each row (and one entry past the last row)
+	int* parent; // union-find forest of the runs
+	int* run_blob; // blob index of each run (and of each root run while labelling)
+	BitMaskBlob* blobs; // the blobs of the last labelling, in the order they have been found
+	int* first_run; // index of the first and the last run of each blob
+	int* last_run;
+	BitMaskOrder* order; // the blobs ordered by the area of their bounding box
+	int count; // number of blobs of the last labelling
+};
+
+// the bits of the last word of a row that belong to the row
+uint64_t bit_mask_last_word(int width) {
+	int tail = width % BIT_MASK_WORD_BITS;
+	return tail ? (((uint64_t) 1) << tail) - 1 : ~((uint64_t) 0);
+}
+
+size_t bit_mask_size_of(CvSize size) {
+	return (size_t) ((size.width + BIT_MASK_WORD_BITS - 1) / BIT_MASK_WORD_BITS) * size.height * sizeof(uint64_t);
+}
+
+void bit_mask_init(BitMask* m, CvSize size, void* bits) {
+	m->width = size.width;
+	m->height = size.height;
+	m->stride = (size.width + BIT_MASK_WORD_BITS - 1) / BIT_MASK_WORD_BITS;
+	m->bits = (uint64_t*) bits;
+	bit_mask_clear(m);
+}
+
+void bit_mask_clear(BitMask* m) {
+	memset(m->bits, 0, (size_t) m->stride * m->height * sizeof(uint64_t));
+}
+
+void bit_mask_clear_border(BitMask* m) {
+	int last = m->width - 1;
+	int y;
+	for (y = 0; y < m->height; y++) {
+		uint64_t* row = bit_mask_row(m, y);
+		if (y == 0 || y == m->height - 1)
+			memset(row, 0, m->stride * sizeof(uint64_t));
+		row[0] &= ~((uint64_t) 1);
+		row[last / BIT_MASK_WORD_BITS] &= ~(((uint64_t) 1) << (last % BIT_MASK_WORD_BITS));
+	}
+}
+
+void bit_mask_and(BitMask* dst, const BitMask* src) {
+	size_t i, n = (size_t) dst->stride * dst->height;
+	for (i = 0; i < n; i++)
+		dst->bits[i] &= src->bits[i];
+}
+
+void bit_mask_or(BitMask* dst, const BitMask* src) {
+	size_t i, n = (size_t) dst->stride * dst->height;
+	for (i = 0; i < n; i++)
+		dst->bits[i] |= src->bits[i];
+}
+
+int bit_mask_count(const BitMask* m) {
+	size_t i, n = (size_t) m->stride * m->height;
+	int count = 0;
+	for (i = 0; i < n; i++)
+		count += __builtin_popcountll(m->bits[i]);
+	return count;
+}
+
+// shifts a row by "dx" pixels (see bit_mask_shift), "src" and "dst" may be the same
+void bit_mask_shift_row(const uint64_t* src, uint64_t* dst, int words, int dx, uint64_t last) {
+	int i;
+	if (dx >= 0) {
+		int q = dx / BIT_MASK_WORD_BITS, r = dx % BIT_MASK_WORD_BITS;
+		// only words at or right of "i" are read, which have not been written yet
+		for (i = 0; i < words; i++) {
+			uint64_t lo = i + q < words ? src[i + q] : 0;
+			uint64_t hi = i + q + 1 < words ? src[i + q + 1] : 0;
+			dst[i] = r ? (lo >> r) | (hi << (BIT_MASK_WORD_BITS - r)) : lo;
+		}
+	} else {
+		int q = -dx / BIT_MASK_WORD_BITS, r = -dx % BIT_MASK_WORD_BITS;
+		for (i = words - 1; i >= 0; i--) {
+			uint64_t hi = i - q >= 0 ? src[i - q] : 0;
+			uint64_t lo = i - q - 1 >= 0 ? src[i - q - 1] : 0;
+			dst[i] = r ? (hi << r) | (lo >> (BIT_MASK_WORD_BITS - r)) : hi;
+		}
+	}
+	dst[words - 1] &= last;
+}
+
+void bit_mask_shift(BitMask* m, int dx, int dy) {
+	uint64_t last = bit_mask_last_word(m->width);
+	int y;
+	if (dy > 0) {
+		for (y = 0; y < m->height; y++) {
+			if (y + dy < m->height)
+				bit_mask_shift_row(bit_mask_row(m, y + dy), bit_mask_row(m, y), m->stride, dx, last);
+			else
+				memset(bit_mask_row(m, y), 0, m->stride * sizeof(uint64_t));
+		}
+	} else {
+		for (y = m->height - 1; y >= 0; y--) {
+			if (y + dy >= 0)
+				bit_mask_shift_row(bit_mask_row(m, y + dy), bit_mask_row(m, y), m->stride, dx, last);
+			else
+				memset(bit_mask_row(m, y), 0, m->stride * sizeof(uint64_t));
+		}
+	}
+}
+
+void bit_mask_set_run(uint64_t* row, int x0, int x1) {
+	while (x0 < x1) {
+		// the pixels of the run within the word of "x0"
+		int b0 = x0 % BIT_MASK_WORD_BITS;
+		int n = MIN(BIT_MASK_WORD_BITS - b0, x1 - x0);
+		row[x0 / BIT_MASK_WORD_BITS] |= (n == BIT_MASK_WORD_BITS ? ~((uint64_t) 0) : (((uint64_t) 1) << n) - 1) << b0;
+		x0 += n;
+	}
+}
+
+// the word of a row whose bit b is pixel 64 * i + b + o (|o| < 64), pixels outside of the row are "fill"
+uint64_t bit_mask_word_at(const uint64_t* src, int words, int i, int o, uint64_t fill, uint64_t last) {
+	int j = i + (o > 0 ? 1 : -1);
+	uint64_t a = src[i];
+	uint64_t b = j >= 0 && j < words ? src[j] : fill;
+	// the bits beyond the width belong to the outside
+	if (i == words - 1)
+		a |= fill & ~last;
+	else if (j == words - 1)
+		b |= fill & ~last;
+	if (o > 0)
+		return (a >> o) | (b << (BIT_MASK_WORD_BITS - o));
+	return (a << -o) | (b >> (BIT_MASK_WORD_BITS + o));
+}
+
+void bit_mask_morph_row(const uint64_t* src, uint64_t* dst, int width, int size, int anchor, int dilate) {
+	int words = (width + BIT_MASK_WORD_BITS - 1) / BIT_MASK_WORD_BITS;
+	uint64_t last = bit_mask_last_word(width);
+	uint64_t fill = dilate ? 0 : ~((uint64_t) 0);
+	int i, o;
+	for (i = 0; i < words; i++) {
+		uint64_t v = src[i];
+		for (o = -anchor; o < size - anchor; o++) {
+			if (o == 0)
+				continue;
+			uint64_t n = bit_mask_word_at(src, words, i, o, fill, last);
+			v = dilate ? (v | n) : (v & n);
+		}
+		dst[i] = v;
+	}
+	dst[words - 1] &= last;
+}
+
+// the vertical part of the erosion/dilation, combines the rows around each row of "src" into "dst"
+void bit_mask_morph_columns(const BitMask* src, BitMask* dst, int size, int anchor, int dilate) {
+	int x, y, i;
+	for (y = 0; y < src->height; y++) {
+		int y0 = y - anchor < 0 ? 0 : y - anchor;
+		int y1 = y - anchor + size > src->height ? src->height : y - anchor + size;
+		uint64_t* d = bit_mask_row(dst, y);
+		memcpy(d, bit_mask_row(src, y0), src->stride * sizeof(uint64_t));
+		for (i = y0 + 1; i < y1; i++) {
+			const uint64_t* s = bit_mask_row(src, i);
+			if (dilate) {
+				for (x = 0; x < src->stride; x++)
+					d[x] |= s[x];
+			} else {
+				for (x = 0; x < src->stride; x++)
+					d[x] &= s[x];
+			}
+		}
+	}
+}
+
+void bit_mask_morph(const BitMask* src, BitMask* dst, BitMask* tmp, int size, int anchor, int dilate) {
+	int y;
+	for (y = 0; y < src->height; y++)
+		bit_mask_morph_row(bit_mask_row(src, y), bit_mask_row(tmp, y), src->width, size, anchor, dilate);
+	bit_mask_morph_columns(tmp, dst, size, anchor, dilate);
+}
+
+void bit_mask_erode(const BitMask* src, BitMask* dst, BitMask* tmp, int size, int anchor) {
+	bit_mask_morph(src, dst, tmp, size, anchor, 0);
+}
+
+void bit_mask_dilate(const BitMask* src, BitMask* dst, BitMask* tmp, int size, int anchor) {
+	bit_mask_morph(src, dst, tmp, size, anchor, 1);
+}
+
+void bit_mask_in_range(BitMask* m, CvRect rect, const IplImage* img, CvScalar min, CvScalar max) {
+	int lo[3], hi[3];
+	int c, x, y, k;
+	// the same bounds as cvInRangeS uses for 8 bit images (rounded, lo <= value <= hi)
+	for (c = 0; c < 3; c++) {
+		lo[c] = cvRound(min.val[c]);
+		hi[c] = cvRound(max.val[c]);
+	}
+	for (y = rect.y; y < rect.y + rect.height; y++) {
+		const unsigned char* p = (const unsigned char*) img->imageData + y * img->widthStep + rect.x * 3;
+		uint64_t* row = bit_mask_row(m, y);
+		x = rect.x;
+		while (x < rect.x + rect.width) {
+			// the pixels of the rectangle within the word of "x"
+			int b0 = x % BIT_MASK_WORD_BITS;
+			int n = MIN(BIT_MASK_WORD_BITS - b0, rect.x + rect.width - x);
+			uint64_t w = 0;
+			for (k = 0; k < n; k++, p += 3) {
+				if (p[0] >= lo[0] && p[0] <= hi[0] && p[1] >= lo[1] && p[1] <= hi[1] && p[2] >= lo[2] && p[2] <= hi[2])
+					w |= ((uint64_t) 1) << (b0 + k);
+			}
+			uint64_t keep = n == BIT_MASK_WORD_BITS ? 0 : ~(((((uint64_t) 1) << n) - 1) << b0);
+			row[x / BIT_MASK_WORD_BITS] = (row[x / BIT_MASK_WORD_BITS] & keep) | w;
+			x += n;
+		}
+	}
+}
+
+void bit_mask_from_image(BitMask* m, const IplImage* img) {
+	int x, y;
+	for (y = 0; y < m->height; y++) {
+		const unsigned char* p = (const unsigned char*) img->imageData + y * img->widthStep;
+		uint64_t* row = bit_mask_row(m, y);
+		memset(row, 0, m->stride * sizeof(uint64_t));
+		for (x = 0; x < m->width; x++) {
+			if (p[x])
+				row[x / BIT_MASK_WORD_BITS] |= ((uint64_t) 1) << (x % BIT_MASK_WORD_BITS);
+		}
+	}
+}
+
+void bit_mask_to_image(const BitMask* m, IplImage* img) {
+	int x, y;
+	for (y = 0; y < m->height; y++) {
+		unsigned char* p = (unsigned char*) img->imageData + y * img->widthStep;
+		const uint64_t* row = bit_mask_row(m, y);
+		for (x = 0; x < m->width; x++)
+			p[x] = (row[x / BIT_MASK_WORD_BITS] >> (x % BIT_MASK_WORD_BITS)) & 1 ? 0xFF : 0;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// labelling
+///////////////////////////////////////////////////////////////////////////////
+BitMaskBlobs* bit_mask_blobs_new(CvSize size) {
+	BitMaskBlobs* b = (BitMaskBlobs*) calloc(1, sizeof(BitMaskBlobs));
+	// runs are separated by at least one pixel
+	b->max_runs = size.height * (size.width / 2 + 1);
+	b->runs = (BitMaskRun*) calloc(b->max_runs, sizeof(BitMaskRun));
+	b->row_start = (int*) calloc(size.height + 1, sizeof(int));
+	b->parent = (int*) calloc(b->max_runs, sizeof(int));
+	b->run_blob = (int*) calloc(b->max_runs, sizeof(int));
+	b->blobs = (BitMaskBlob*) calloc(b->max_runs, sizeof(BitMaskBlob));
+	b->first_run = (int*) calloc(b->max_runs, sizeof(int));
+	b->last_run = (int*) calloc(b->max_runs, sizeof(int));
+	b->order = (BitMaskOrder*) calloc(b->max_runs, sizeof(BitMaskOrder));
+	return b;
+}
+
+void bit_mask_blobs_release(BitMaskBlobs* b) {
+	if (b == 0x0)
+		return;
+	free(b->runs);
+	free(b->row_start);
+	free(b->parent);
+	free(b->run_blob);
+	free(b->blobs);
+	free(b->first_run);
+	free(b->last_run);
+	free(b->order);
+	free(b);
+}
+
+int bit_mask_next(const uint64_t* row, int x, int end, int value) {
+	while (x < end) {
+		uint64_t w = row[x / BIT_MASK_WORD_BITS];
+		if (!value)
+			w = ~w;
+		w >>= x % BIT_MASK_WORD_BITS;
+		if (w)
+			return MIN(x + __builtin_ctzll(w), end);
+		x = (x / BIT_MASK_WORD_BITS + 1) * BIT_MASK_WORD_BITS;
+	}
+	return end;
+}
+
+int bit_mask_find(int* parent, int i) {
+	while (parent[i] != i) {
+		// path halving
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+void bit_mask_union(int* parent, int a, int b) {
+	a = bit_mask_find(parent, a);
+	b = bit_mask_find(parent, b);
+	// the smaller index becomes the root, so that the result does not depend on the order
+	if (a < b)
+		parent[b] = a;
+	else if (b < a)
+		parent[a] = b;
+}
+
+int bit_mask_compare(const void* a, const void* b) {
+	const BitMaskOrder* oa = (const BitMaskOrder*) a;
+	const BitMaskOrder* ob = (const BitMaskOrder*) b;
+	if (oa->area != ob->area)
+		return ob->area - oa->area;
+	return oa->blob - ob->blob;
+}
+
+int bit_mask_blobs_find(BitMaskBlobs* b, const BitMask* m, CvRect rect) {
+	int x, y, i, n = 0;
+
+	// collect the runs, leaving out the outermost pixels of the rectangle
+	for (y = rect.y; y < rect.y + rect.height; y++) {
+		b->row_start[y - rect.y] = n;
+		if (y == rect.y || y == rect.y + rect.height - 1)
+			continue;
+		const uint64_t* row = bit_mask_row(m, y);
+		int end = rect.x + rect.width - 1;
+		x = rect.x + 1;
+		while ((x = bit_mask_next(row, x, end, 1)) < end) {
+			BitMaskRun* r = &b->runs[n];
+			r->y = y;
+			r->x0 = x;
+			x = bit_mask_next(row, x, end, 0);
+			r->x1 = x;
+			b->parent[n] = n;
+			n++;
+		}
+	}
+	b->row_start[rect.height] = n;
+
+	// connect the 8-connected runs of neighboring rows
+	for (y = 1; y < rect.height; y++) {
+		int a = b->row_start[y - 1], a_end = b->row_start[y];
+		int c = b->row_start[y], c_end = b->row_start[y + 1];
+		while (a < a_end && c < c_end) {
+			BitMaskRun* ra = &b->runs[a];
+			BitMaskRun* rc = &b->runs[c];
+			if (ra->x0 <= rc->x1 && rc->x0 <= ra->x1)
+				bit_mask_union(b->parent, a, c);
+			if (ra->x1 < rc->x1)
+				a++;
+			else
+				c++;
+		}
+	}
+
+	// the root runs come first in their component, so each blob is created before its other runs are added
+	b->count = 0;
+	for (i = 0; i < n; i++) {
+		BitMaskRun* r = &b->runs[i];
+		int root = bit_mask_find(b->parent, i);
+		BitMaskBlob* blob;
+		if (root == i) {
+			b->run_blob[i] = b->count;
+			b->first_run[b->count] = i;
+			blob = &b->blobs[b->count++];
+			blob->bbox = cvRect(r->x0, r->y, r->x1 - r->x0, 1);
+			blob->pixels = 0;
+		} else {
+			b->run_blob[i] = b->run_blob[root];
+			blob = &b->blobs[b->run_blob[i]];
+			int x0 = MIN(blob->bbox.x, r->x0);
+			int x1 = MAX(blob->bbox.x + blob->bbox.width, r->x1);
+			blob->bbox.x = x0;
+			blob->bbox.width = x1 - x0;
+			blob->bbox.height = r->y - blob->bbox.y + 1;
+		}
+		blob->pixels += r->x1 - r->x0;
+		b->last_run[b->run_blob[i]] = i;
+	}
+
+	for (i = 0; i < b->count; i++) {
+		b->order[i].area = b->blobs[i].bbox.width * b->blobs[i].bbox.height;
+		b->order[i].blob = i;
+	}
+	qsort(b->order, b->count, sizeof(BitMaskOrder), bit_mask_compare);
+	return b->count;
+}
+
+const BitMaskBlob* bit_mask_blobs_get(BitMaskBlobs* b, int i) {
+	return &b->blobs[b->order[i].blob];
+}
+
+int bit_mask_blobs_biggest(BitMaskBlobs* b) {
+	int i, best = -1;
+	for (i = 0; i < b->count; i++) {
+		if (best < 0 || bit_mask_blobs_get(b, i)->pixels > bit_mask_blobs_get(b, best)->pixels)
+			best = i;
+	}
+	return best;
+}
+
+void bit_mask_blobs_draw(BitMaskBlobs* b, int i, IplImage* dst) {
+	int blob = b->order[i].blob;
+	int r;
+	for (r = b->first_run[blob]; r <= b->last_run[blob]; r++) {
+		BitMaskRun* run = &b->runs[r];
+		if (b->run_blob[r] == blob)
+			memset(dst->imageData + run->y * dst->widthStep + run->x0, 0xFF, run->x1 - run->x0);
+	}
+}
+
+void bit_mask_blobs_draw_mask(BitMaskBlobs* b, int i, BitMask* dst) {
+	int blob = b->order[i].blob;
+	int r;
+	for (r = b->first_run[blob]; r <= b->last_run[blob]; r++) {
+		BitMaskRun* run = &b->runs[r];
+		if (b->run_blob[r] != blob)
+			continue;
+		bit_mask_set_run(bit_mask_row(dst, run->y), run->x0, run->x1);
+	}
+}
+
+CvScalar bit_mask_blobs_avg(BitMaskBlobs* b, int i, const IplImage* img) {
+	int blob = b->order[i].blob;
+	double sum[3] = { 0, 0, 0 };
+	int r, x;
+	for (r = b->first_run[blob]; r <= b->last_run[blob]; r++) {
+		BitMaskRun* run = &b->runs[r];
+		if (b->run_blob[r] != blob)
+			continue;
+		const unsigned char* p = (const unsigned char*) img->imageData + run->y * img->widthStep + run->x0 * 3;
+		for (x = run->x0; x < run->x1; x++, p += 3) {
+			sum[0] += p[0];
+			sum[1] += p[1];
+			sum[2] += p[2];
+		}
+	}
+	int n = b->blobs[blob].pixels;
+	return cvScalar(sum[0] / n, sum[1] / n, sum[2] / n, 0);
+}
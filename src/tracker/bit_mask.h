@@ -0,0 +1,112 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef BIT_MASK_H_
+#define BIT_MASK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "opencv2/core/core_c.h"
+
+/*
+ * A binary mask with one bit per pixel: pixel x of row y is bit (x % 64) of the word
+ * y * stride + x / 64. The bits beyond the width of a row are always 0. Masks do not own
+ * their memory (see bit_mask_size_of), so that they can be taken from an image arena.
+ */
+typedef struct {
+	int width, height; // size in pixels
+	int stride; // number of words per row
+	uint64_t* bits; // the rows of the mask
+} BitMask;
+
+size_t bit_mask_size_of(CvSize size); // number of bytes of the bits of a mask of the given size
+void bit_mask_init(BitMask* m, CvSize size, void* bits); // initializes "m" to use "bits" (of bit_mask_size_of(size) bytes), all pixels are 0
+
+static inline uint64_t* bit_mask_row(const BitMask* m, int y) {
+	return m->bits + (size_t) y * m->stride;
+}
+
+void bit_mask_clear(BitMask* m); // sets all pixels to 0
+void bit_mask_clear_border(BitMask* m); // sets the outermost pixels (first and last row and column) to 0
+void bit_mask_and(BitMask* dst, const BitMask* src); // dst &= src (masks of the same size)
+void bit_mask_or(BitMask* dst, const BitMask* src); // dst |= src (masks of the same size)
+int bit_mask_count(const BitMask* m); // number of pixels set
+// moves the content, so that afterwards m(x, y) = m(x + dx, y + dy); the uncovered pixels are 0
+void bit_mask_shift(BitMask* m, int dx, int dy);
+// sets the pixels [x0, x1) of a row
+void bit_mask_set_run(uint64_t* row, int x0, int x1);
+// the first pixel at or after "x" (and before "end") of a row whose value is "value" (0 or 1), or "end"
+int bit_mask_next(const uint64_t* row, int x, int end, int value);
+
+/*
+ * Erodes/dilates with a size x size rectangle whose anchor is at (anchor, anchor), pixels outside
+ * the mask are ignored: the same as cvErode/cvDilate with cvCreateStructuringElementEx(size, size,
+ * anchor, anchor, CV_SHAPE_RECT). "tmp" is a scratch mask of the same size, "src" and "dst" may be
+ * the same. Both are separable, bit_mask_morph_row is the horizontal part of a single row.
+ */
+void bit_mask_erode(const BitMask* src, BitMask* dst, BitMask* tmp, int size, int anchor);
+void bit_mask_dilate(const BitMask* src, BitMask* dst, BitMask* tmp, int size, int anchor);
+void bit_mask_morph_row(const uint64_t* src, uint64_t* dst, int width, int size, int anchor, int dilate);
+
+// sets the pixels of "rect" whose values in the 8 bit 3 channel image "img" are within [min, max] (as cvInRangeS), clears the others
+void bit_mask_in_range(BitMask* m, CvRect rect, const IplImage* img, CvScalar min, CvScalar max);
+// converts between bit masks and 8 bit images (0 / 0xFF) of the same size
+void bit_mask_from_image(BitMask* m, const IplImage* img);
+void bit_mask_to_image(const BitMask* m, IplImage* img);
+
+/* A connected component of a bit mask */
+typedef struct {
+	CvRect bbox; // bounding box of the component
+	int pixels; // number of pixels of the component
+} BitMaskBlob;
+
+/* Opaque data type for the labelling of the components of bit masks */
+struct _BitMaskBlobs;
+typedef struct _BitMaskBlobs BitMaskBlobs;
+
+/*
+ * Labels the components of a rectangle of a mask as runs of pixels, which are extracted a word
+ * at a time. Like cvFindContours, the outermost pixels of the rectangle are treated as background
+ * and pixels are 8-connected, so that each blob corresponds to exactly one outer contour.
+ */
+BitMaskBlobs* bit_mask_blobs_new(CvSize size); // constructor, for masks up to the given size
+void bit_mask_blobs_release(BitMaskBlobs* b); // destructor
+// labels the blobs of "rect" of "m", returns the number of blobs
+int bit_mask_blobs_find(BitMaskBlobs* b, const BitMask* m, CvRect rect);
+// returns the i-th blob of the last labelling, ordered by the area of their bounding box (biggest first)
+const BitMaskBlob* bit_mask_blobs_get(BitMaskBlobs* b, int i);
+// returns the index of the blob with the most pixels of the last labelling, or -1 if there is none
+int bit_mask_blobs_biggest(BitMaskBlobs* b);
+// sets the pixels of the i-th blob to 0xFF in the 8 bit image "dst" / to 1 in "dst" (all other pixels are left untouched)
+void bit_mask_blobs_draw(BitMaskBlobs* b, int i, IplImage* dst);
+void bit_mask_blobs_draw_mask(BitMaskBlobs* b, int i, BitMask* dst);
+// returns the average color of the pixels of the i-th blob in the 8 bit 3 channel image "img" (as cvAvg with the blob as mask)
+CvScalar bit_mask_blobs_avg(BitMaskBlobs* b, int i, const IplImage* img);
+
+#endif /* BIT_MASK_H_ */
@@ -0,0 +1,111 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "calibration_mask.h"
+#include "color_conversion.h"
+
+#define K CALIBRATION_MASK_KERNEL
+#define A CALIBRATION_MASK_ANCHOR
+#define U (CALIBRATION_MASK_KERNEL - 1 - CALIBRATION_MASK_ANCHOR) // offset of the last row of the window
+
+// thresholded grey diff of one row, packed into bits
+void calibration_mask_diff_row(const unsigned char* on, const unsigned char* off, uint64_t* dst, int n, int threshold) {
+	int x;
+	memset(dst, 0, (n + 63) / 64 * sizeof(uint64_t));
+	for (x = 0; x < n; x++, on += 3, off += 3) {
+		int g1 = COLOR_DESCALE(on[0] * 1868 + on[1] * 9617 + on[2] * 4899);
+		int g2 = COLOR_DESCALE(off[0] * 1868 + off[1] * 9617 + off[2] * 4899);
+		if (abs(g1 - g2) > threshold)
+			dst[x / 64] |= ((uint64_t) 1) << (x % 64);
+	}
+}
+
+// vertical part of the erosion/dilation: combines the window of rows around "y" (from the ring "ring") into "dst"
+void calibration_mask_morph_column(uint64_t** ring, int y, int height, uint64_t* dst, int words, int dilate) {
+	int y0 = y - A < 0 ? 0 : y - A;
+	int y1 = y + U >= height ? height - 1 : y + U;
+	int x, i;
+	memcpy(dst, ring[y0 % K], words * sizeof(uint64_t));
+	for (i = y0 + 1; i <= y1; i++) {
+		const uint64_t* src = ring[i % K];
+		if (dilate) {
+			for (x = 0; x < words; x++)
+				dst[x] |= src[x];
+		} else {
+			for (x = 0; x < words; x++)
+				dst[x] &= src[x];
+		}
+	}
+}
+
+void calibration_mask_fold(IplImage* on, IplImage* off, int threshold, BitMask* rows, BitMask* mask, int first, BitMask* blink) {
+	int w = on->width;
+	int h = on->height;
+	int words = mask->stride;
+	int s, x;
+
+	// the ring of horizontally eroded diff rows, the ring of horizontally dilated eroded rows
+	// and one row for the intermediate results of each step
+	uint64_t* eroded[K];
+	uint64_t* dilated[K];
+	for (s = 0; s < K; s++) {
+		eroded[s] = bit_mask_row(rows, s);
+		dilated[s] = bit_mask_row(rows, K + s);
+	}
+	uint64_t* tmp = bit_mask_row(rows, 2 * K);
+
+	// row "s" of the frames enters the pipeline, which completes the erosion of row s - U and the dilation of row s - 2 * U
+	for (s = 0; s < h + 2 * U; s++) {
+		if (s < h) {
+			calibration_mask_diff_row((unsigned char*) on->imageData + s * on->widthStep, (unsigned char*) off->imageData + s * off->widthStep, tmp,
+					w, threshold);
+			bit_mask_morph_row(tmp, eroded[s % K], w, K, A, 0);
+		}
+		int e = s - U;
+		if (e >= 0 && e < h) {
+			calibration_mask_morph_column(eroded, e, h, tmp, words, 0);
+			bit_mask_morph_row(tmp, dilated[e % K], w, K, A, 1);
+		}
+		int d = e - U;
+		if (d >= 0 && d < h) {
+			uint64_t* dst = bit_mask_row(mask, d);
+			calibration_mask_morph_column(dilated, d, h, tmp, words, 1);
+			if (blink != 0x0)
+				memcpy(bit_mask_row(blink, d), tmp, words * sizeof(uint64_t));
+			if (first) {
+				memcpy(dst, tmp, words * sizeof(uint64_t));
+			} else {
+				for (x = 0; x < words; x++)
+					dst[x] &= tmp[x];
+			}
+		}
+	}
+}
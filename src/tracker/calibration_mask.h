@@ -0,0 +1,59 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef CALIBRATION_MASK_H_
+#define CALIBRATION_MASK_H_
+
+#include "opencv2/core/core_c.h"
+
+#include "bit_mask.h"
+
+#define CALIBRATION_MASK_KERNEL 5 // size of the square structuring element of the erosion/dilation
+#define CALIBRATION_MASK_ANCHOR 3 // anchor of the structuring element (as in cvCreateStructuringElementEx(5, 5, 3, 3, ...))
+#define CALIBRATION_MASK_ROWS (2 * CALIBRATION_MASK_KERNEL + 1) // number of rows of scratch memory needed by calibration_mask_fold
+
+/*
+ * Calculates the mask of the pixels that changed between a frame with the lit sphere ("on")
+ * and one with the unlit sphere ("off") in a single pass over both frames. It yields exactly
+ * the same result as converting both frames to grey, cvAbsDiff, cvThreshold(..., threshold, 0xFF,
+ * CV_THRESH_BINARY), cvErode and cvDilate (once each, with the structuring element above) followed
+ * by cvAnd with "mask" - but without any intermediate full size image: the frames are streamed row
+ * by row and the morphology is done on a window of bit mask rows that stays in the cache. The grey
+ * values are those of OpenCV 2.x (14 bit coefficients); newer versions use 15 bit coefficients,
+ * which differ by one grey level for a few colors.
+ *
+ * on, off	- (in) the 8 bit BGR frames with the lit and unlit sphere
+ * threshold- (in) grey values of the diff below or equal to this are black
+ * rows		- (in) scratch mask, as wide as the frames and CALIBRATION_MASK_ROWS high
+ * mask		- (in/out) the running intersection, overwritten instead if "first" is set
+ * first	- (in) nonzero for the first pair of frames
+ * blink	- (out) receives the mask of this pair of frames alone (for debugging), may be NULL
+ */
+void calibration_mask_fold(IplImage* on, IplImage* off, int threshold, BitMask* rows, BitMask* mask, int first, BitMask* blink);
+
+#endif /* CALIBRATION_MASK_H_ */
@@ -0,0 +1,148 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef COLOR_CONVERSION_H_
+#define COLOR_CONVERSION_H_
+
+#include "opencv2/core/core_c.h"
+
+/*
+ * Conversions between 8 bit BGR, HSV and YUV colors that yield exactly the same results
+ * as cvCvtColor(..., CV_BGR2HSV / CV_HSV2BGR / CV_BGR2YUV / CV_YUV2BGR) on 8 bit images:
+ * H is in [0, 180), S and V in [0, 255]; U and V are offset by 128. HSV2BGR follows the
+ * float based conversion of OpenCV 2.x (newer versions round differently). All functions
+ * are pure (no allocations, no hidden state), so they may be used from any thread.
+ */
+
+// fixed point (12 bit) divisions of OpenCV's BGR2HSV conversion
+extern const int color_hsv_sdiv[256];
+extern const int color_hsv_hdiv[256];
+
+#define COLOR_YUV_SHIFT 14 // fixed point precision of the YUV conversions
+#define COLOR_DESCALE(x) (((x) + (1 << (COLOR_YUV_SHIFT - 1))) >> COLOR_YUV_SHIFT)
+
+static inline unsigned char color_saturate(int v) {
+	return (unsigned char) (v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline void color_bgr2hsv(const unsigned char* bgr, unsigned char* hsv) {
+	int b = bgr[0], g = bgr[1], r = bgr[2];
+	int v = b, vmin = b;
+	if (g > v)
+		v = g;
+	if (r > v)
+		v = r;
+	if (g < vmin)
+		vmin = g;
+	if (r < vmin)
+		vmin = r;
+
+	int diff = v - vmin;
+	int vr = v == r ? -1 : 0;
+	int vg = v == g ? -1 : 0;
+	int s = (diff * color_hsv_sdiv[v] + (1 << 11)) >> 12;
+	int h = (vr & (g - b)) + (~vr & ((vg & (b - r + 2 * diff)) + ((~vg) & (r - g + 4 * diff))));
+	h = (h * color_hsv_hdiv[diff] + (1 << 11)) >> 12;
+	h += h < 0 ? 180 : 0;
+
+	hsv[0] = (unsigned char) h;
+	hsv[1] = (unsigned char) s;
+	hsv[2] = (unsigned char) v;
+}
+
+static inline void color_hsv2bgr(const unsigned char* hsv, unsigned char* bgr) {
+	// OpenCV converts 8 bit HSV via floats, the same operations are used here
+	static const int sector_data[][3] = { { 1, 3, 0 }, { 1, 0, 2 }, { 3, 0, 1 }, { 0, 2, 1 }, { 0, 1, 3 }, { 2, 1, 0 } };
+	float h = hsv[0], s = hsv[1] * (1.f / 255.f), v = hsv[2] * (1.f / 255.f);
+	float b, g, r;
+	if (s == 0) {
+		b = g = r = v;
+	} else {
+		float tab[4];
+		h *= 6.f / 180.f;
+		if (h >= 6)
+			h -= 6;
+		int sector = cvFloor(h);
+		h -= sector;
+		if ((unsigned) sector >= 6u) {
+			sector = 0;
+			h = 0.f;
+		}
+		tab[0] = v;
+		tab[1] = v * (1.f - s);
+		tab[2] = v * (1.f - s * h);
+		tab[3] = v * (1.f - s * (1.f - h));
+		b = tab[sector_data[sector][0]];
+		g = tab[sector_data[sector][1]];
+		r = tab[sector_data[sector][2]];
+	}
+	bgr[0] = color_saturate(cvRound(b * 255.f));
+	bgr[1] = color_saturate(cvRound(g * 255.f));
+	bgr[2] = color_saturate(cvRound(r * 255.f));
+}
+
+static inline void color_bgr2yuv(const unsigned char* bgr, unsigned char* yuv) {
+	int b = bgr[0], g = bgr[1], r = bgr[2];
+	int y = COLOR_DESCALE(b * 1868 + g * 9617 + r * 4899);
+	yuv[0] = color_saturate(y);
+	yuv[1] = color_saturate(COLOR_DESCALE((b - y) * 8061 + (128 << COLOR_YUV_SHIFT)));
+	yuv[2] = color_saturate(COLOR_DESCALE((r - y) * 14369 + (128 << COLOR_YUV_SHIFT)));
+}
+
+static inline void color_yuv2bgr(const unsigned char* yuv, unsigned char* bgr) {
+	int y = yuv[0], u = yuv[1] - 128, v = yuv[2] - 128;
+	bgr[0] = color_saturate(y + COLOR_DESCALE(u * 33292));
+	bgr[1] = color_saturate(y + COLOR_DESCALE(v * -9519 + u * -6472));
+	bgr[2] = color_saturate(y + COLOR_DESCALE(v * 18678));
+}
+
+// converts "n" consecutive pixels (3 bytes each), "src" and "dst" may be the same
+void color_bgr2hsv_row(const unsigned char* src, unsigned char* dst, int n);
+// converts the rectangle "rect" of the 8 bit BGR image "src" into "dst" at "at", row by row (the ROIs
+// of both images are ignored); "src" and "dst" may be the same image, like cvCvtColor(..., CV_BGR2HSV)
+void color_bgr2hsv_image(const IplImage* src, CvRect rect, IplImage* dst, CvPoint at);
+
+// packs "n" 2x2 quads of a GBRG Bayer mosaic (rows "even": G B G B ..., and "odd": R G R G ...) into "n" BGR pixels,
+// the greens are averaged (rounded up): a color image at half the resolution of the mosaic, without demosaicing
+void color_gbrg2bgr_quads_row(const unsigned char* even, const unsigned char* odd, unsigned char* dst, int n);
+
+// calculates the bounds of a color filter for 8 bit images, like cvInRangeS does: rounded, a value passes if lo <= value <= hi
+void color_range_bounds(CvScalar min, CvScalar max, int* lo, int* hi);
+
+// returns 1 if the HSV conversion of the BGR color "bgr" passes the color filter with the bounds "lo" and "hi"
+static inline int color_in_range(const unsigned char* bgr, const int* lo, const int* hi) {
+	unsigned char hsv[3];
+	color_bgr2hsv(bgr, hsv);
+	return hsv[0] >= lo[0] && hsv[0] <= hi[0] && hsv[1] >= lo[1] && hsv[1] <= hi[1] && hsv[2] >= lo[2] && hsv[2] <= hi[2];
+}
+
+// converts a color given as CvScalar (rounded and saturated to 8 bit, like cvSet does on an 8 bit image)
+CvScalar color_scalar_bgr2hsv(CvScalar bgr);
+CvScalar color_scalar_hsv2bgr(CvScalar hsv);
+
+#endif /* COLOR_CONVERSION_H_ */
@@ -0,0 +1,82 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include "color_conversion.h"
+#include "decimated_mask.h"
+
+void decimated_mask_cells(const IplImage* frame, CvRect roi, int d, const int* lo, const int* hi, BitMask* cells) {
+	int x, y;
+
+	// classify the center pixel of every cell (the cells at the right and bottom border may be cut off)
+	bit_mask_init(cells, cvSize((roi.width + d - 1) / d, (roi.height + d - 1) / d), cells->bits);
+	for (y = 0; y < cells->height; y++) {
+		const unsigned char* src = (const unsigned char*) frame->imageData + (roi.y + MIN(y * d + d / 2, roi.height - 1)) * frame->widthStep + roi.x * 3;
+		uint64_t* row = bit_mask_row(cells, y);
+		for (x = 0; x < cells->width; x++) {
+			if (color_in_range(src + MIN(x * d + d / 2, roi.width - 1) * 3, lo, hi))
+				bit_mask_set_run(row, x, x + 1);
+		}
+	}
+}
+
+void decimated_mask_refine(const IplImage* frame, CvRect roi, int d, const int* lo, const int* hi, const BitMask* cells, BitMask* inner, BitMask* outer, BitMask* tmp, BitMask* dst) {
+	CvSize size = cvSize(cells->width, cells->height);
+	int w = roi.width;
+	int x, y;
+
+	// the interior of the blobs is set, only the pixels of the cells at their edge are classified
+	bit_mask_init(inner, size, inner->bits);
+	bit_mask_init(outer, size, outer->bits);
+	bit_mask_init(tmp, size, tmp->bits);
+	bit_mask_erode(cells, inner, tmp, 3, 1);
+	bit_mask_dilate(cells, outer, tmp, 3, 1);
+	// the cells at the border of the ROI may be cut off by it, their pixels are always classified
+	bit_mask_clear_border(inner);
+	bit_mask_clear(dst);
+	for (y = 0; y < roi.height; y++) {
+		const uint64_t* in = bit_mask_row(inner, y / d);
+		const uint64_t* out = bit_mask_row(outer, y / d);
+		const unsigned char* src = (const unsigned char*) frame->imageData + (roi.y + y) * frame->widthStep + roi.x * 3;
+		uint64_t* row = bit_mask_row(dst, y);
+		int c = bit_mask_next(out, 0, size.width, 1);
+		while (c < size.width) {
+			// within a run of "outer", the cells up to the next interior cell are at the edge
+			int end = bit_mask_next(out, c, size.width, 0);
+			int interior = bit_mask_next(in, c, end, 1);
+			for (x = c * d; x < MIN(interior * d, w); x++) {
+				if (color_in_range(src + x * 3, lo, hi))
+					bit_mask_set_run(row, x, x + 1);
+			}
+			// followed by the interior cells
+			c = bit_mask_next(in, interior, end, 0);
+			bit_mask_set_run(row, interior * d, MIN(c * d, w));
+			if (c == end)
+				c = bit_mask_next(out, end, size.width, 1);
+		}
+	}
+}
@@ -0,0 +1,56 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef DECIMATED_MASK_H_
+#define DECIMATED_MASK_H_
+
+#include "opencv2/core/core_c.h"
+
+#include "bit_mask.h"
+
+/*
+ * Applies the color filter to a ROI at a decimated resolution, for spheres that are big enough:
+ * first only the center pixel of every d x d cell is classified. The cells whose neighbours are
+ * all set are interior cells, they are set without looking at their pixels; only the pixels of
+ * the cells at the edge of the blobs (and of the cells on the border of the ROI, which may be cut
+ * off) are classified at full resolution. Away from the border of the ROI, the result equals the
+ * classification of every pixel, except that holes smaller than a cell are filled and blobs that
+ * do not cover the center of any cell may be missed.
+ *
+ * frame	- (in) the 8 bit BGR frame
+ * roi		- (in) the rectangle of the frame that is filtered
+ * d		- (in) the decimation (the size of the cells)
+ * lo, hi	- (in) the bounds of the color filter (see color_range_bounds)
+ * cells	- (out) one pixel per cell, resized to the number of cells (rounded up)
+ * inner, outer, tmp	- (in) scratch masks, at least as big as "cells"
+ * dst		- (out) the mask of the ROI at full resolution (of the size of "roi")
+ */
+void decimated_mask_cells(const IplImage* frame, CvRect roi, int d, const int* lo, const int* hi, BitMask* cells);
+void decimated_mask_refine(const IplImage* frame, CvRect roi, int d, const int* lo, const int* hi, const BitMask* cells, BitMask* inner, BitMask* outer, BitMask* tmp, BitMask* dst);
+
+#endif /* DECIMATED_MASK_H_ */
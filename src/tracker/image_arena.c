@@ -0,0 +1,159 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+#ifdef WIN32
+#	include <malloc.h>
+#else
+#	include <sys/mman.h>
+#endif
+
+#include "image_arena.h"
+
+#define IMAGE_ARENA_HUGE_PAGE (2 * 1024 * 1024) // size of a huge page on x86
+
+// an image or a block of memory that did not fit into the arena
+typedef struct _ImageArenaOverflow {
+	IplImage* image;
+	void* memory;
+	struct _ImageArenaOverflow* next;
+} ImageArenaOverflow;
+
+struct _ImageArena {
+	char* memory; // the single allocation all images are taken from
+	size_t capacity; // size of "memory"
+	size_t used; // number of bytes handed out
+	unsigned int heap_allocations; // number of allocations made on the heap
+	ImageArenaOverflow* overflow; // images allocated on the heap, because the arena was exhausted
+};
+
+size_t image_arena_align(size_t n) {
+	return (n + IMAGE_ARENA_ALIGNMENT - 1) & ~((size_t) IMAGE_ARENA_ALIGNMENT - 1);
+}
+
+size_t image_arena_row_size(CvSize size, int depth, int channels) {
+	return image_arena_align((size_t) size.width * channels * ((depth & 255) >> 3));
+}
+
+size_t image_arena_size_of(CvSize size, int depth, int channels) {
+	return image_arena_align(sizeof(IplImage)) + image_arena_row_size(size, depth, channels) * size.height;
+}
+
+size_t image_arena_block_size_of(size_t size) {
+	return image_arena_align(size);
+}
+
+ImageArena* image_arena_new(size_t capacity, int huge_pages) {
+	ImageArena* a = (ImageArena*) calloc(1, sizeof(ImageArena));
+	void* memory = 0x0;
+	capacity = image_arena_align(capacity);
+#ifdef WIN32
+	memory = _aligned_malloc(capacity, IMAGE_ARENA_ALIGNMENT);
+#else
+	// huge pages save TLB misses when the whole frame is scanned; the kernel only uses
+	// them (transparently) for aligned memory that spans at least one of them
+	size_t alignment = IMAGE_ARENA_ALIGNMENT;
+	if (huge_pages && capacity >= IMAGE_ARENA_HUGE_PAGE) {
+		alignment = IMAGE_ARENA_HUGE_PAGE;
+		capacity = (capacity + IMAGE_ARENA_HUGE_PAGE - 1) & ~((size_t) IMAGE_ARENA_HUGE_PAGE - 1);
+	}
+	if (posix_memalign(&memory, alignment, capacity) != 0)
+		memory = 0x0;
+#ifdef MADV_HUGEPAGE
+	if (memory != 0x0 && alignment == IMAGE_ARENA_HUGE_PAGE)
+		madvise(memory, capacity, MADV_HUGEPAGE);
+#endif
+#endif
+	// without memory, all images are allocated on the heap
+	a->memory = (char*) memory;
+	a->capacity = memory != 0x0 ? capacity : 0;
+	a->heap_allocations = memory != 0x0 ? 1 : 0;
+	return a;
+}
+
+void image_arena_release(ImageArena* a) {
+	if (a == 0x0)
+		return;
+	while (a->overflow != 0x0) {
+		ImageArenaOverflow* o = a->overflow;
+		a->overflow = o->next;
+		if (o->image != 0x0)
+			cvReleaseImage(&o->image);
+		free(o->memory);
+		free(o);
+	}
+#ifdef WIN32
+	_aligned_free(a->memory);
+#else
+	free(a->memory);
+#endif
+	free(a);
+}
+
+IplImage* image_arena_create_image(ImageArena* a, CvSize size, int depth, int channels) {
+	size_t needed = image_arena_size_of(size, depth, channels);
+	if (a->used + needed > a->capacity) {
+		ImageArenaOverflow* o = (ImageArenaOverflow*) calloc(1, sizeof(ImageArenaOverflow));
+		o->image = cvCreateImage(size, depth, channels);
+		o->next = a->overflow;
+		a->overflow = o;
+		a->heap_allocations++;
+		return o->image;
+	}
+
+	IplImage* img = (IplImage*) (a->memory + a->used);
+	char* data = a->memory + a->used + image_arena_align(sizeof(IplImage));
+	a->used += needed;
+	cvInitImageHeader(img, size, depth, channels, IPL_ORIGIN_TL, 4);
+	cvSetData(img, data, (int) image_arena_row_size(size, depth, channels));
+	return img;
+}
+
+void* image_arena_alloc(ImageArena* a, size_t size) {
+	size = image_arena_block_size_of(size);
+	if (a->used + size > a->capacity) {
+		ImageArenaOverflow* o = (ImageArenaOverflow*) calloc(1, sizeof(ImageArenaOverflow));
+		o->memory = malloc(size);
+		o->next = a->overflow;
+		a->overflow = o;
+		a->heap_allocations++;
+		return o->memory;
+	}
+
+	void* memory = a->memory + a->used;
+	a->used += size;
+	return memory;
+}
+
+size_t image_arena_get_used(ImageArena* a) {
+	return a->used;
+}
+
+unsigned int image_arena_get_heap_allocations(ImageArena* a) {
+	return a->heap_allocations;
+}
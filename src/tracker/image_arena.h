@@ -0,0 +1,57 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef IMAGE_ARENA_H_
+#define IMAGE_ARENA_H_
+
+#include <stddef.h>
+
+#include "opencv2/core/core_c.h"
+
+#define IMAGE_ARENA_ALIGNMENT 64 // every image (and each of its rows) starts on a cache line
+
+/* Opaque data type for the image arena */
+struct _ImageArena;
+typedef struct _ImageArena ImageArena;
+
+/*
+ * Hands out images (header and data) from a single allocation that is made when the arena is
+ * created; nothing is freed until the whole arena is released. The images must not be released
+ * with cvReleaseImage. If the arena is exhausted, images are allocated on the heap instead (and
+ * released with the arena); the counter of heap allocations shows whether this ever happens.
+ */
+size_t image_arena_size_of(CvSize size, int depth, int channels); // number of bytes an image takes in the arena
+size_t image_arena_block_size_of(size_t size); // number of bytes a block of memory (see image_arena_alloc) takes in the arena
+ImageArena* image_arena_new(size_t capacity, int huge_pages); // constructor, "huge_pages" asks the OS to back the arena with huge pages
+void image_arena_release(ImageArena* a); // destructor, releases all images
+IplImage* image_arena_create_image(ImageArena* a, CvSize size, int depth, int channels);
+void* image_arena_alloc(ImageArena* a, size_t size); // a block of memory that is not an image (e.g. the bits of a BitMask), aligned like the images
+size_t image_arena_get_used(ImageArena* a); // number of bytes handed out
+unsigned int image_arena_get_heap_allocations(ImageArena* a); // 1 for the arena itself, plus 1 for every image that did not fit
+
+#endif /* IMAGE_ARENA_H_ */
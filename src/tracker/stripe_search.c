@@ -0,0 +1,82 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#include <stdlib.h>
+
+#include "color_conversion.h"
+#include "stripe_search.h"
+
+struct _StripeSearch {
+	TrackerPool* pool; // the threads that process the stripes
+	CvSize size; // size of the frames
+	int stripes; // number of stripes
+
+	// the parameters of the current run (read by the workers)
+	IplImage* frame;
+	IplImage* hsv;
+	BitMask* mask;
+	CvScalar min, max;
+};
+
+// converts and filters a single stripe (runs on a thread of the pool)
+void stripe_search_job(void* arg, int job) {
+	StripeSearch* s = (StripeSearch*) arg;
+	int y0 = job * s->size.height / s->stripes;
+	int y1 = (job + 1) * s->size.height / s->stripes;
+
+	// each stripe writes its own rows of the mask only
+	CvRect rect = cvRect(0, y0, s->size.width, y1 - y0);
+	color_bgr2hsv_image(s->frame, rect, s->hsv, cvPoint(0, y0));
+	bit_mask_in_range(s->mask, rect, s->hsv, s->min, s->max);
+}
+
+StripeSearch* stripe_search_new(TrackerPool* pool, CvSize size, int stripes) {
+	StripeSearch* s = (StripeSearch*) calloc(1, sizeof(StripeSearch));
+	if (stripes < 1)
+		stripes = 1;
+	if (stripes > size.height)
+		stripes = size.height;
+
+	s->pool = pool;
+	s->size = size;
+	s->stripes = stripes;
+	return s;
+}
+
+void stripe_search_release(StripeSearch* s) {
+	free(s);
+}
+
+void stripe_search_run(StripeSearch* s, IplImage* frame, IplImage* hsv, BitMask* mask, CvScalar min, CvScalar max) {
+	s->frame = frame;
+	s->hsv = hsv;
+	s->mask = mask;
+	s->min = min;
+	s->max = max;
+	tracker_pool_run(s->pool, stripe_search_job, s, s->stripes);
+}
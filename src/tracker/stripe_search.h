@@ -0,0 +1,52 @@
+/**
+ * PS Move API - An interface for the PS Move Motion Controller
+ * Copyright (c) 2012 Benjamin Venditti <benjamin.venditti@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+#ifndef STRIPE_SEARCH_H_
+#define STRIPE_SEARCH_H_
+
+#include "opencv2/core/core_c.h"
+
+#include "bit_mask.h"
+#include "../thread/tracker_pool.h"
+
+/* Opaque data type for the stripe search */
+struct _StripeSearch;
+typedef struct _StripeSearch StripeSearch;
+
+/*
+ * Applies the color filter to a whole frame in parallel: the frame is split into horizontal
+ * stripes, each of them is converted to HSV and filtered into the bit mask on its own thread
+ * of the pool. The blobs of the mask are labelled afterwards (see bit_mask_blobs_find), which
+ * does not depend on the stripes.
+ */
+StripeSearch* stripe_search_new(TrackerPool* pool, CvSize size, int stripes); // constructor, for frames of the given size
+void stripe_search_release(StripeSearch* s); // destructor (the pool is not released)
+// converts "frame" into "hsv" and filters it into "mask" (as bit_mask_in_range), all of the same size
+void stripe_search_run(StripeSearch* s, IplImage* frame, IplImage* hsv, BitMask* mask, CvScalar min, CvScalar max);
+
+#endif /* STRIPE_SEARCH_H_ */
@@ -28,6 +28,7 @@
 
 #include "tracked_controller.h"
 #include "tracker_helpers.h"
+#include "color_conversion.h"
 #include "../iniparser/iniparser.h"
 #include "../iniparser/dictionary.h"
 
@@ -45,6 +46,9 @@ tracked_controller_create() {
 
 	tc->eColor = cvScalar(0, 0, 0, 0);
 	tc->eColorHSV = cvScalar(0, 0, 0, 0);
+	tc->exposure = 0;
+	tc->cFColor = cvScalar(0, 0, 0, 0);
+	tc->cExposure = 0;
 
 	tc->roi_x = 0;
 	tc->roi_y = 0;
@@ -59,7 +63,17 @@ tracked_controller_create() {
 	tc->my = 0;
 
 	tc->is_tracked = 0;
-	tc->last_color_update = 0;
+	tc->roi_fallbacks = 0;
+	tc->roi_full_searches = 0;
+	tc->reacquire_tile = 0;
+	tc->reacquire_pending = 0;
+	tc->reacquire_handoffs = 0;
+	tc->reacquire_searches = 0;
+	tc->found_once = 0;
+	tc->slot = -1;
+	tc->cam_x = 0;
+	tc->cam_y = 0;
+	tc->cam_z = 0;
 
 	tc->next = 0x0;
 	return tc;
@@ -174,8 +188,8 @@ int tracked_controller_load_color(TrackedController* tc) {
 		tc->eColor.val[1] = tc->eFColor.val[1];
 		tc->eColor.val[0] = tc->eFColor.val[0];
 
-		tc->eColorHSV = th_brg2hsv(tc->eColor);
-		tc->eFColorHSV = th_brg2hsv(tc->eFColor);
+		tc->eColorHSV = color_scalar_bgr2hsv(tc->eColor);
+		tc->eFColorHSV = color_scalar_bgr2hsv(tc->eFColor);
 
 		loaded = 1;
 	} else
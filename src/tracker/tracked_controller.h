@@ -31,7 +31,7 @@
 
 #include "opencv2/core/core_c.h"
 #include "psmove.h"
-#include <time.h>
+#include <stdint.h>
 
 struct _TrackedController;
 typedef struct _TrackedController TrackedController;
@@ -44,13 +44,24 @@ struct _TrackedController {
 	CvScalar eFColorHSV;		// first estimated color (HSV)
 	CvScalar eColor;			// estimated color (BGR)
 	CvScalar eColorHSV; 		// estimated color (HSV)
+	int exposure;				// the exposure of the camera eFColor belongs to (0 = unknown)
+	CvScalar cFColor;			// first estimated color as calibrated (BGR), eFColor is derived from it
+	int cExposure;				// the exposure of the camera cFColor belongs to (0 = unknown)
 	int roi_x, roi_y;			// x/y - Coordinates of the ROI
 	int roi_level; 	 			// the current index for the level of ROI
 	float mx, my;				// x/y - Coordinates of center of mass of the blob
 	float x, y, r;				// x/y - Coordinates of the controllers sphere and its radius
 	float rs;					// a smoothed variant of the radius
+	float cam_x, cam_y, cam_z;	// position of the sphere's center in camera space (in mm)
 	int is_tracked;				// 1 if tracked 0 otherwise
-	time_t last_color_update;	// the timestamp when the last color adaption has been performed
+	int roi_fallbacks;			// number of times the ROI had to be enlarged, because the sphere was not found
+	int roi_full_searches;		// number of searches on the whole image
+	int reacquire_tile;			// the next tile of the decimated frame to search, while the sphere is lost
+	int reacquire_pending;		// 1 if the sphere is to be searched by the reacquisition scheduler in the current frame
+	int reacquire_handoffs;		// number of times the sphere was not found in its ROI and has been left to the scheduler
+	int reacquire_searches;		// number of frames in which the scheduler searched the sphere
+	int found_once;				// 1 if the sphere has been found at least once since the controller has been enabled
+	int slot;					// the profiler slot of the controller, it does not change while it is enabled (-1 = none)
 	TrackedController* next;
 };
 
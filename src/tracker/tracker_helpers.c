@@ -149,29 +149,6 @@ void th_print_array(double* src, int len) {
 	printf("%s", "}\n");
 }
 
-IplImage* pxHSV;
-IplImage* pxBGR;
-CvScalar th_hsv2bgr(CvScalar hsv) {
-	if (pxHSV == 0x0) {
-		pxHSV = cvCreateImage(cvSize(1, 1), IPL_DEPTH_8U, 3);
-		pxBGR = cvCloneImage(pxHSV);
-	}
-
-	cvSet(pxHSV, hsv, 0x0);
-	cvCvtColor(pxHSV, pxBGR, CV_HSV2BGR);
-	return cvAvg(pxBGR, 0x0);
-
-}
-CvScalar th_brg2hsv(CvScalar bgr) {
-	if (pxHSV == 0x0) {
-		pxHSV = cvCreateImage(cvSize(1, 1), IPL_DEPTH_8U, 3);
-		pxBGR = cvCloneImage(pxHSV);
-	}
-	cvSet(pxBGR, bgr, 0x0);
-	cvCvtColor(pxBGR, pxHSV, CV_BGR2HSV);
-	return cvAvg(pxHSV, 0x0);
-}
-
 CvScalar th_hsv2bgr_alt(float hue) {
 	int rgb[3], p, sector;
 	while ((hue >= 180))
@@ -48,10 +48,6 @@ int th_save_jpgEx(const char* folder, const char* filename, int prefix, const Cv
 // prints a array to system out ala {a,b,c...}
 void th_print_array(double* src, int len);
 
-// converts HSV color to a BGR color and back
-CvScalar th_hsv2bgr(CvScalar hsv);
-CvScalar th_brg2hsv(CvScalar bgr);
-
 // waits until the uses presses ESC (only works if a windo is visible)
 void th_wait_esc();
 void th_wait(char c);